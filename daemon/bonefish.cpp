@@ -31,10 +31,20 @@ int main(int argc, char** argv)
         ("help,h", "produce help message")
         ("realm,r", po::value<std::string>(), "set the WAMP realm for this router")
         ("websocket-port,w", po::value<std::uint16_t>()->value_name("<port>"), "enable websocket transport on the given port")
+        ("websocket-deflate", "enable permessage-deflate compression for websocket connections")
+        ("websocket-deflate-window-bits", po::value<unsigned>()->value_name("<bits>"), "set the largest compression window size (8-15)")
+        ("websocket-deflate-min-size", po::value<std::size_t>()->value_name("<bytes>"), "do not compress messages smaller than the given size")
+        ("websocket-deflate-no-context-takeover", "reset the compression context after each message")
         ("rawsocket-port,t", po::value<std::uint16_t>()->value_name("<port>"), "enable rawsocket transport on the given port")
         ("rawsocket-path,u", po::value<std::string>()->value_name("<path>"), "enable rawsocket transport on the given path")
+        ("rawsocket-seqpacket-path", po::value<std::string>()->value_name("<path>"), "enable seqpacket rawsocket transport on the given path")
+        ("rawsocket-shm-path", po::value<std::string>()->value_name("<path>"), "enable shared memory rawsocket transport set up through the given path")
+        ("rawsocket-shm-ring-size", po::value<std::size_t>()->value_name("<bytes>"), "set the shared memory ring size per direction (power of two)")
+        ("rawsocket-io-uring", "use io_uring for rawsocket connections when the kernel supports it")
         ("no-json", "disable JSON serialization")
         ("no-msgpack", "disable msgpack serialization")
+        ("io-threads", po::value<unsigned>()->value_name("<count>"), "accept and service tcp connections on the given number of threads")
+        ("registration-grace-period", po::value<unsigned>()->value_name("<ms>"), "let calls wait the given time for their procedure to be registered")
         ("debug,d", po::bool_switch()->default_value(false), "enable debugging")
     ;
 
@@ -62,11 +72,37 @@ int main(int argc, char** argv)
 
     options.set_debug_enabled(variables["debug"].as<bool>());
 
+    if (variables.count("io-threads")) {
+        options.set_io_threads(variables["io-threads"].as<unsigned>());
+    }
+
+    if (variables.count("registration-grace-period")) {
+        options.set_registration_grace_period(variables["registration-grace-period"].as<unsigned>());
+    }
+
     if (variables.count("websocket-port")) {
         options.set_websocket_enabled(true);
         options.set_websocket_port(variables["websocket-port"].as<std::uint16_t>());
     }
 
+    if (variables.count("websocket-deflate")) {
+        options.set_websocket_compression_enabled(true);
+    }
+
+    if (variables.count("websocket-deflate-window-bits")) {
+        options.set_websocket_compression_window_bits(
+                variables["websocket-deflate-window-bits"].as<unsigned>());
+    }
+
+    if (variables.count("websocket-deflate-min-size")) {
+        options.set_websocket_compression_min_size(
+                variables["websocket-deflate-min-size"].as<std::size_t>());
+    }
+
+    if (variables.count("websocket-deflate-no-context-takeover")) {
+        options.set_websocket_context_takeover_enabled(false);
+    }
+
     if (variables.count("rawsocket-port")) {
         options.set_rawsocket_enabled(true);
         options.set_rawsocket_port(variables["rawsocket-port"].as<std::uint16_t>());
@@ -77,6 +113,24 @@ int main(int argc, char** argv)
         options.set_rawsocket_path(variables["rawsocket-path"].as<std::string>());
     }
 
+    if (variables.count("rawsocket-seqpacket-path")) {
+        options.set_rawsocket_enabled(true);
+        options.set_rawsocket_seqpacket_path(variables["rawsocket-seqpacket-path"].as<std::string>());
+    }
+
+    if (variables.count("rawsocket-shm-path")) {
+        options.set_rawsocket_enabled(true);
+        options.set_rawsocket_shm_path(variables["rawsocket-shm-path"].as<std::string>());
+    }
+
+    if (variables.count("rawsocket-shm-ring-size")) {
+        options.set_rawsocket_shm_ring_size(variables["rawsocket-shm-ring-size"].as<std::size_t>());
+    }
+
+    if (variables.count("rawsocket-io-uring")) {
+        options.set_rawsocket_io_uring_enabled(true);
+    }
+
     if (variables.count("no-json")) {
         options.set_json_serialization_enabled(false);
     }
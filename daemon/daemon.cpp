@@ -23,6 +23,12 @@
 #include <bonefish/router/wamp_router.hpp>
 #include <bonefish/router/wamp_routers.hpp>
 #include <bonefish/rawsocket/rawsocket_server.hpp>
+#if defined(__linux__)
+#include <bonefish/rawsocket/seqpacket_listener.hpp>
+#include <bonefish/rawsocket/shm_listener.hpp>
+#include <bonefish/rawsocket/uring_listener.hpp>
+#include <bonefish/rawsocket/uring_service.hpp>
+#endif
 #include <bonefish/rawsocket/tcp_listener.hpp>
 #include <bonefish/rawsocket/uds_listener.hpp>
 #include <bonefish/trace/trace.hpp>
@@ -44,6 +50,10 @@ daemon::daemon(const daemon_options& options)
 #else
     , m_termination_signals(m_io_service, SIGTERM, SIGINT)
 #endif
+    , m_io_services()
+    , m_io_work()
+    , m_io_threads()
+    , m_tcp_io_services()
     , m_routers(std::make_shared<wamp_routers>())
     , m_serializers(std::make_shared<wamp_serializers>())
     , m_rawsocket_server()
@@ -65,7 +75,20 @@ daemon::daemon(const daemon_options& options)
     // such as websocketpp.
     bonefish::trace::set_enabled(options.is_debug_enabled());
 
+    // With a single io thread everything runs on the main io service.
+    // Otherwise tcp connections are accepted and serviced on the io threads
+    // while the routers keep running on the main io service.
+    if (options.io_threads() > 1) {
+        for (unsigned i = 0; i < options.io_threads(); ++i) {
+            m_io_services.emplace_back(new boost::asio::io_service(1));
+            m_tcp_io_services.push_back(m_io_services.back().get());
+        }
+    } else {
+        m_tcp_io_services.push_back(&m_io_service);
+    }
+
     auto router = std::make_shared<wamp_router>(m_io_service, options.realm());
+    router->set_registration_grace_period(options.registration_grace_period());
     m_routers->add_router(router);
 
     if (options.is_json_serialization_enabled()) {
@@ -76,23 +99,66 @@ daemon::daemon(const daemon_options& options)
     }
 
     if (options.is_websocket_enabled()) {
+        websocket_compression_options compression_options;
+        compression_options.set_enabled(options.is_websocket_compression_enabled());
+        compression_options.set_max_window_bits(
+                static_cast<uint8_t>(options.websocket_compression_window_bits()));
+        compression_options.set_min_payload_size(options.websocket_compression_min_size());
+        compression_options.set_context_takeover(options.is_websocket_context_takeover_enabled());
+
         m_websocket_server = std::make_shared<websocket_server>(
-                m_io_service, m_routers, m_serializers);
+                m_io_service, m_routers, m_serializers, compression_options);
         m_websocket_port = options.websocket_port();
     }
 
     if (options.is_rawsocket_enabled()) {
-        m_rawsocket_server = std::make_shared<rawsocket_server>(m_routers, m_serializers);
+        m_rawsocket_server = std::make_shared<rawsocket_server>(
+                m_io_service, m_routers, m_serializers);
+#if defined(__linux__)
+        std::shared_ptr<uring_service> uring;
+        if (options.is_rawsocket_io_uring_enabled()) {
+            if (uring_service::is_supported()) {
+                uring = std::make_shared<uring_service>(m_io_service);
+            } else {
+                std::cerr << "io_uring is not supported by this kernel, "
+                        "using the regular rawsocket listeners" << std::endl;
+            }
+        }
+#endif
         if (options.rawsocket_port() != 0) {
-            auto listener = std::make_shared<tcp_listener>(
-                    m_io_service, boost::asio::ip::address(), options.rawsocket_port());
-            m_rawsocket_server->attach_listener(std::static_pointer_cast<rawsocket_listener>(listener));
+            std::shared_ptr<rawsocket_listener> listener;
+#if defined(__linux__)
+            if (uring) {
+                listener = std::make_shared<uring_listener>(
+                        uring, boost::asio::ip::address(), options.rawsocket_port());
+            } else
+#endif
+            listener = std::make_shared<tcp_listener>(
+                    m_tcp_io_services, boost::asio::ip::address(), options.rawsocket_port());
+            m_rawsocket_server->attach_listener(listener);
         }
         if (!options.rawsocket_path().empty()) {
-            auto listener = std::make_shared<uds_listener>(
-                    m_io_service, options.rawsocket_path());
+            std::shared_ptr<rawsocket_listener> listener;
+#if defined(__linux__)
+            if (uring) {
+                listener = std::make_shared<uring_listener>(uring, options.rawsocket_path());
+            } else
+#endif
+            listener = std::make_shared<uds_listener>(m_io_service, options.rawsocket_path());
+            m_rawsocket_server->attach_listener(listener);
+        }
+#if defined(__linux__)
+        if (!options.rawsocket_seqpacket_path().empty()) {
+            auto listener = std::make_shared<seqpacket_listener>(
+                    m_io_service, options.rawsocket_seqpacket_path());
             m_rawsocket_server->attach_listener(std::static_pointer_cast<rawsocket_listener>(listener));
         }
+        if (!options.rawsocket_shm_path().empty()) {
+            auto listener = std::make_shared<shm_listener>(
+                    m_io_service, options.rawsocket_shm_path(), options.rawsocket_shm_ring_size());
+            m_rawsocket_server->attach_listener(std::static_pointer_cast<rawsocket_listener>(listener));
+        }
+#endif
     }
 }
 
@@ -112,7 +178,15 @@ void daemon::run()
     }
 
     if (m_websocket_server) {
-        m_websocket_server->start(boost::asio::ip::address(), m_websocket_port);
+        m_websocket_server->start(boost::asio::ip::address(), m_websocket_port, m_tcp_io_services);
+    }
+
+    for (const auto& io_service : m_io_services) {
+        boost::asio::io_service* thread_io_service = io_service.get();
+        m_io_work.emplace_back(new boost::asio::io_service::work(*thread_io_service));
+        m_io_threads.emplace_back([thread_io_service]() {
+            thread_io_service->run();
+        });
     }
 
     m_io_service.run();
@@ -150,6 +224,17 @@ void daemon::shutdown_handler()
         m_work.reset();
         m_io_service.poll();
         m_io_service.stop();
+
+        // The io threads are stopped last. Anything they still had pending
+        // is dropped along with their io services.
+        m_io_work.clear();
+        for (const auto& io_service : m_io_services) {
+            io_service->stop();
+        }
+        for (std::thread& thread : m_io_threads) {
+            thread.join();
+        }
+        m_io_threads.clear();
     }
 }
 
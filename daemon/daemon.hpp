@@ -25,6 +25,8 @@
 #include <boost/asio/signal_set.hpp>
 #include <cstdint>
 #include <memory>
+#include <thread>
+#include <vector>
 
 namespace bonefish {
 
@@ -54,6 +56,13 @@ private:
     std::shared_ptr<boost::asio::io_service::work> m_work;
     boost::asio::signal_set m_termination_signals;
 
+    /// The io services that accept and service tcp connections when more
+    /// than one io thread is requested. Each is run by its own thread.
+    std::vector<std::unique_ptr<boost::asio::io_service>> m_io_services;
+    std::vector<std::unique_ptr<boost::asio::io_service::work>> m_io_work;
+    std::vector<std::thread> m_io_threads;
+    std::vector<boost::asio::io_service*> m_tcp_io_services;
+
     std::shared_ptr<bonefish::wamp_routers> m_routers;
     std::shared_ptr<bonefish::wamp_serializers> m_serializers;
     std::shared_ptr<bonefish::rawsocket_server> m_rawsocket_server;
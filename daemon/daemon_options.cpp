@@ -16,15 +16,27 @@
 
 #include "daemon_options.hpp"
 
+#include <boost/asio/detail/socket_types.hpp>
+
 namespace bonefish {
 
 daemon_options::daemon_options()
     : m_realm()
     , m_debug_enabled(false)
+    , m_io_threads(1)
+    , m_registration_grace_period(0)
     , m_websocket_port(0)
     , m_rawsocket_port(0)
     , m_rawsocket_path()
+    , m_rawsocket_seqpacket_path()
+    , m_rawsocket_shm_path()
+    , m_rawsocket_shm_ring_size(1024 * 1024)
+    , m_rawsocket_io_uring_enabled(false)
     , m_websocket_enabled(false)
+    , m_websocket_compression_enabled(false)
+    , m_websocket_compression_window_bits(15)
+    , m_websocket_compression_min_size(256)
+    , m_websocket_context_takeover_enabled(true)
     , m_rawsocket_enabled(false)
     , m_json_serialization_enabled(true)
     , m_msgpack_serialization_enabled(true)
@@ -44,12 +56,40 @@ std::vector<std::string> daemon_options::problems() const
     if (!m_json_serialization_enabled && !m_msgpack_serialization_enabled) {
         list.push_back("No serialization methods are enabled.");
     }
+    if (m_io_threads == 0) {
+        list.push_back("At least one io thread is required.");
+    }
+#if !defined(SO_REUSEPORT)
+    if (m_io_threads > 1) {
+        list.push_back("Multiple io threads require SO_REUSEPORT support.");
+    }
+#endif
     if (m_websocket_enabled && m_websocket_port == 0) {
         list.push_back("Websocket support is enabled but no port is set.");
     }
+    if (m_websocket_compression_window_bits < 8 || m_websocket_compression_window_bits > 15) {
+        list.push_back("Websocket compression window bits must be between 8 and 15.");
+    }
     if ((m_rawsocket_enabled && m_rawsocket_port == 0) &&
-            (m_rawsocket_enabled && m_rawsocket_path.empty())) {
-        list.push_back("Rawsocket support is enabled but no tcp port or uds path is set.");
+            (m_rawsocket_enabled && m_rawsocket_path.empty()) &&
+            (m_rawsocket_enabled && m_rawsocket_seqpacket_path.empty()) &&
+            (m_rawsocket_enabled && m_rawsocket_shm_path.empty())) {
+        list.push_back("Rawsocket support is enabled but no tcp port, uds path, seqpacket path or shm path is set.");
+    }
+#if !defined(__linux__)
+    if (!m_rawsocket_seqpacket_path.empty()) {
+        list.push_back("Seqpacket rawsocket support is only available on Linux.");
+    }
+#endif
+    if (!m_rawsocket_shm_path.empty()) {
+#if defined(__linux__)
+        if (m_rawsocket_shm_ring_size < 4096 ||
+                (m_rawsocket_shm_ring_size & (m_rawsocket_shm_ring_size - 1)) != 0) {
+            list.push_back("Rawsocket shm ring size must be a power of two of at least 4096.");
+        }
+#else
+        list.push_back("Shared memory rawsocket support is only available on Linux.");
+#endif
     }
     return list;
 }
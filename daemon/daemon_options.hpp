@@ -17,6 +17,7 @@
 #ifndef BONEFISH_DAEMON_OPTIONS_HPP
 #define BONEFISH_DAEMON_OPTIONS_HPP
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -39,6 +40,19 @@ public:
     void set_debug_enabled(bool enabled) { m_debug_enabled = enabled; }
     bool is_debug_enabled() const { return m_debug_enabled; }
 
+    /// Set the number of threads that accept and service tcp connections.
+    /// With more than one thread the websocket and rawsocket tcp ports are
+    /// each opened once per thread with SO_REUSEPORT. Messages are always
+    /// routed on the main thread. Default value is 1.
+    void set_io_threads(unsigned threads) { m_io_threads = threads; }
+    unsigned io_threads() const { return m_io_threads; }
+
+    /// Set how long calls to procedures that are not registered yet wait
+    /// for the procedure to be registered. Default value is 0 which fails
+    /// such calls right away.
+    void set_registration_grace_period(unsigned grace_period_ms) { m_registration_grace_period = grace_period_ms; }
+    unsigned registration_grace_period() const { return m_registration_grace_period; }
+
     /// Enable or disable websocket support. Default value is disabled.
     /// At least one transport has to be enabled for the router to start.
     void set_websocket_enabled(bool enabled) { m_websocket_enabled = enabled; }
@@ -48,6 +62,23 @@ public:
     void set_websocket_port(std::uint16_t port) { m_websocket_port = port; }
     std::uint16_t websocket_port() const { return m_websocket_port; }
 
+    /// Enable or disable permessage-deflate compression for websocket
+    /// connections. Default value is disabled.
+    void set_websocket_compression_enabled(bool enabled) { m_websocket_compression_enabled = enabled; }
+    bool is_websocket_compression_enabled() const { return m_websocket_compression_enabled; }
+
+    /// Set the largest compression window size as a power of two between 8 and 15.
+    void set_websocket_compression_window_bits(unsigned bits) { m_websocket_compression_window_bits = bits; }
+    unsigned websocket_compression_window_bits() const { return m_websocket_compression_window_bits; }
+
+    /// Set the payload size in bytes below which messages are not compressed.
+    void set_websocket_compression_min_size(std::size_t size) { m_websocket_compression_min_size = size; }
+    std::size_t websocket_compression_min_size() const { return m_websocket_compression_min_size; }
+
+    /// Enable or disable compression context takeover. Default value is enabled.
+    void set_websocket_context_takeover_enabled(bool enabled) { m_websocket_context_takeover_enabled = enabled; }
+    bool is_websocket_context_takeover_enabled() const { return m_websocket_context_takeover_enabled; }
+
     /// Enable or disable rawsocket support. Default value is disabled.
     /// At least one transport has to be enabled for the router to start.
     void set_rawsocket_enabled(bool enabled) { m_rawsocket_enabled = enabled; }
@@ -61,6 +92,27 @@ public:
     void set_rawsocket_path(const std::string& path) { m_rawsocket_path = path; }
     const std::string& rawsocket_path() const { return m_rawsocket_path; }
 
+    /// Set the path of a SOCK_SEQPACKET uds on which messages are exchanged
+    /// as datagrams without length prefixes. Only supported on Linux.
+    void set_rawsocket_seqpacket_path(const std::string& path) { m_rawsocket_seqpacket_path = path; }
+    const std::string& rawsocket_seqpacket_path() const { return m_rawsocket_seqpacket_path; }
+
+    /// Set the uds path through which components on the same host set up
+    /// shared memory rawsocket connections. Only supported on Linux.
+    void set_rawsocket_shm_path(const std::string& path) { m_rawsocket_shm_path = path; }
+    const std::string& rawsocket_shm_path() const { return m_rawsocket_shm_path; }
+
+    /// Set the size in bytes of each shared memory ring. Must be a power of two
+    /// of at least 4096. Default value is 1MiB.
+    void set_rawsocket_shm_ring_size(std::size_t size) { m_rawsocket_shm_ring_size = size; }
+    std::size_t rawsocket_shm_ring_size() const { return m_rawsocket_shm_ring_size; }
+
+    /// Enable or disable the io_uring backend for rawsocket tcp and uds
+    /// listeners. Falls back to the regular listeners if the kernel lacks
+    /// io_uring support. Only supported on Linux. Default value is disabled.
+    void set_rawsocket_io_uring_enabled(bool enabled) { m_rawsocket_io_uring_enabled = enabled; }
+    bool is_rawsocket_io_uring_enabled() const { return m_rawsocket_io_uring_enabled; }
+
     /// Enable or disable JSON serialization support. Default value is enabled.
     /// At least one serialization method has to be enabled for the router to start.
     void set_json_serialization_enabled(bool enabled) { m_json_serialization_enabled = enabled; }
@@ -76,10 +128,20 @@ public:
 private:
     std::string m_realm;
     bool m_debug_enabled;
+    unsigned m_io_threads;
+    unsigned m_registration_grace_period;
     std::uint16_t m_websocket_port;
     std::uint16_t m_rawsocket_port;
     std::string m_rawsocket_path;
+    std::string m_rawsocket_seqpacket_path;
+    std::string m_rawsocket_shm_path;
+    std::size_t m_rawsocket_shm_ring_size;
+    bool m_rawsocket_io_uring_enabled;
     bool m_websocket_enabled;
+    bool m_websocket_compression_enabled;
+    unsigned m_websocket_compression_window_bits;
+    std::size_t m_websocket_compression_min_size;
+    bool m_websocket_context_takeover_enabled;
     bool m_rawsocket_enabled;
     bool m_json_serialization_enabled;
     bool m_msgpack_serialization_enabled;
@@ -27,18 +27,27 @@
 #include <bonefish/messages/wamp_unsubscribed_message.hpp>
 #include <bonefish/session/wamp_session.hpp>
 #include <bonefish/trace/trace.hpp>
+#include <bonefish/transport/wamp_fanout_message.hpp>
 #include <bonefish/transport/wamp_transport.hpp>
+#include <bonefish/utility/wamp_uri.hpp>
+
+#include <algorithm>
+#include <stdexcept>
 
 namespace bonefish {
 
-wamp_broker::wamp_broker(const std::string& realm)
+wamp_broker::wamp_broker(const std::string& realm, wamp_uri_table& uri_table)
     : m_realm(realm)
+    , m_uri_table(uri_table)
     , m_publication_id_generator()
     , m_subscription_id_generator()
-    , m_sessions()
     , m_session_subscriptions()
     , m_topic_subscriptions()
     , m_subscription_topics()
+    , m_fanout_subscribers()
+    , m_topic_event_handlers()
+    , m_event_handler_topics()
+    , m_dispatching_events(false)
 {
 }
 
@@ -49,22 +58,12 @@ wamp_broker::~wamp_broker()
 void wamp_broker::attach_session(const std::shared_ptr<wamp_session>& session)
 {
     BONEFISH_TRACE("attach session: %1%", *session);
-    auto result = m_sessions.insert(
-            std::make_pair(session->get_session_id(), std::move(session)));
-    if (!result.second) {
-        throw std::logic_error("broker session already registered");
-    }
 }
 
-void wamp_broker::detach_session(const wamp_session_id& session_id)
+void wamp_broker::detach_session(const std::shared_ptr<wamp_session>& session)
 {
-    auto session_itr = m_sessions.find(session_id);
-    if (session_itr == m_sessions.end()) {
-        throw std::logic_error("broker session does not exist");
-    }
-
-    BONEFISH_TRACE("detach session: %1%", session_itr->second.get());
-    auto session_subscriptions_itr = m_session_subscriptions.find(session_id);
+    BONEFISH_TRACE("detach session: %1%", *session);
+    auto session_subscriptions_itr = m_session_subscriptions.find(session->get_session_id());
     if (session_subscriptions_itr != m_session_subscriptions.end()) {
         for (const auto& subscription_id : session_subscriptions_itr->second) {
             auto subscription_topics_itr = m_subscription_topics.find(subscription_id);
@@ -73,43 +72,39 @@ void wamp_broker::detach_session(const wamp_session_id& session_id)
                 continue;
             }
 
-            std::string topic = subscription_topics_itr->second->get_topic();
-            subscription_topics_itr->second->remove_session(session_itr->second);
-            if (subscription_topics_itr->second->get_sessions().size() == 0) {
+            const wamp_uri_id topic_id = subscription_topics_itr->second->get_topic_id();
+            subscription_topics_itr->second->remove_session(session.get());
+            if (subscription_topics_itr->second->get_sessions().empty()) {
                 m_subscription_topics.erase(subscription_id);
             }
 
-            auto topic_subscriptions_itr = m_topic_subscriptions.find(topic);
+            auto topic_subscriptions_itr = m_topic_subscriptions.find(topic_id);
             if (topic_subscriptions_itr == m_topic_subscriptions.end()) {
                 BONEFISH_TRACE("error: broker topic subscriptions are out of sync");
                 continue;
             }
 
-            topic_subscriptions_itr->second->remove_session(session_itr->second);
-            if (topic_subscriptions_itr->second->get_sessions().size() == 0) {
-                m_topic_subscriptions.erase(topic);
+            topic_subscriptions_itr->second->remove_session(session.get());
+            if (topic_subscriptions_itr->second->get_sessions().empty()) {
+                m_topic_subscriptions.erase(topic_subscriptions_itr);
+                m_uri_table.release(topic_id);
             }
         }
 
         m_session_subscriptions.erase(session_subscriptions_itr);
     }
-
-    m_sessions.erase(session_itr);
 }
 
-void wamp_broker::process_publish_message(const wamp_session_id& session_id,
+void wamp_broker::process_publish_message(const std::shared_ptr<wamp_session>& session,
         const wamp_publish_message* publish_message)
 {
-    auto session_itr = m_sessions.find(session_id);
-    if (session_itr == m_sessions.end()) {
-        throw std::logic_error("broker session does not exist");
-    }
-
-    BONEFISH_TRACE("%1%, %2%", *session_itr->second % *publish_message);
-    const std::string topic = publish_message->get_topic();
+    BONEFISH_TRACE("%1%, %2%", *session % *publish_message);
     const wamp_publication_id publication_id = m_publication_id_generator.generate();
 
-    auto topic_subscriptions_itr = m_topic_subscriptions.find(topic);
+    // A topic that has not been interned cannot have any subscribers so
+    // there is no need to fall back to a string based lookup here.
+    const wamp_uri_id topic_id = m_uri_table.find(publish_message->get_topic_ref());
+    auto topic_subscriptions_itr = m_topic_subscriptions.find(topic_id);
     if (topic_subscriptions_itr != m_topic_subscriptions.end()) {
         std::unique_ptr<wamp_event_message> event_message(new wamp_event_message);
         event_message->set_subscription_id(topic_subscriptions_itr->second->get_subscription_id());
@@ -117,13 +112,41 @@ void wamp_broker::process_publish_message(const wamp_session_id& session_id,
         event_message->set_arguments(publish_message->get_arguments());
         event_message->set_arguments_kw(publish_message->get_arguments_kw());
 
-        for (const auto& session : topic_subscriptions_itr->second->get_sessions()) {
-            BONEFISH_TRACE("%1%, %2%", *session % *event_message);
-            // TODO: Improve performance here by offering a transport api that
-            //       takes in a pre-serialized buffer. That way we can serialize
-            //       the message once and then send it to all of the subscribers.
-            session->get_transport()->send_message(std::move(*event_message));
+        // The event is serialized and framed at most once per serializer
+        // type and then shared by all of the subscribers. The subscribers are
+        // stored contiguously so this loop is a linear walk over memory
+        // regardless of the number of subscribers. A failed send can detach
+        // a subscriber and swap-remove it from the subscription so the loop
+        // walks a snapshot. The snapshot buffer is reused across publications.
+        std::vector<wamp_session*> subscribers;
+        subscribers.swap(m_fanout_subscribers);
+        const auto& sessions = topic_subscriptions_itr->second->get_sessions();
+        subscribers.assign(sessions.begin(), sessions.end());
+
+        wamp_fanout_message fanout_message(*event_message);
+        for (wamp_session* subscriber : subscribers) {
+            BONEFISH_TRACE("%1%, %2%", *subscriber % *event_message);
+            subscriber->get_transport()->send_fanout_message(fanout_message);
         }
+
+        subscribers.clear();
+        m_fanout_subscribers.swap(subscribers);
+    }
+
+    auto topic_event_handlers_itr = m_topic_event_handlers.find(topic_id);
+    if (topic_event_handlers_itr != m_topic_event_handlers.end()) {
+        const wamp_event event(publish_message->get_topic_ref(), publication_id.id(),
+                publish_message->get_arguments(), publish_message->get_arguments_kw());
+
+        m_dispatching_events = true;
+        for (const auto& event_handler : topic_event_handlers_itr->second) {
+            try {
+                event_handler.second(event);
+            } catch (const std::exception& e) {
+                BONEFISH_TRACE("event handler failed: %1%", e.what());
+            }
+        }
+        m_dispatching_events = false;
     }
 
     // TODO: Publish acknowledgements require support for publish options which
@@ -132,44 +155,44 @@ void wamp_broker::process_publish_message(const wamp_session_id& session_id,
     //std::unique_ptr<wamp_published_message> published_message(new wamp_published_message);
     //published_message->set_request_id(publish_message->get_request_id());
     //published_message->set_publication_id(publication_id);
-    //session_itr->second->get_transport()->send_message(published_message.get());
+    //session->get_transport()->send_message(published_message.get());
 }
 
-void wamp_broker::process_subscribe_message(const wamp_session_id& session_id,
+void wamp_broker::process_subscribe_message(const std::shared_ptr<wamp_session>& session,
         const wamp_subscribe_message* subscribe_message)
 {
-    auto session_itr = m_sessions.find(session_id);
-    if (session_itr == m_sessions.end()) {
-        throw std::logic_error("broker session does not exist");
-    }
-
-    BONEFISH_TRACE("%1%, %2%", *session_itr->second % *subscribe_message);
+    BONEFISH_TRACE("%1%, %2%", *session % *subscribe_message);
     wamp_subscription_id subscription_id;
-    auto& session = session_itr->second;
+    const boost::string_ref topic = subscribe_message->get_topic_ref();
+    wamp_uri_id topic_id = m_uri_table.find(topic);
     {
-        auto result = m_topic_subscriptions.insert(
-                std::make_pair(subscribe_message->get_topic(), nullptr));
-        if (result.second) {
+        auto topic_subscriptions_itr = m_topic_subscriptions.find(topic_id);
+        if (topic_subscriptions_itr == m_topic_subscriptions.end()) {
+            // Each topic subscription holds a reference to its interned
+            // topic which is released when the subscription is removed.
+            topic_id = m_uri_table.acquire(topic);
             subscription_id = m_subscription_id_generator.generate();
-            result.first->second.reset(new wamp_broker_subscription(subscription_id));
-            result.first->second->add_session(session);
+            std::unique_ptr<wamp_broker_subscription> subscription(
+                    new wamp_broker_subscription(subscription_id));
+            subscription->add_session(session.get());
+            m_topic_subscriptions.insert(std::make_pair(topic_id, std::move(subscription)));
         } else {
-            subscription_id = result.first->second->get_subscription_id();
-            result.first->second->add_session(session);
+            subscription_id = topic_subscriptions_itr->second->get_subscription_id();
+            topic_subscriptions_itr->second->add_session(session.get());
         }
     }
 
     {
         auto result = m_subscription_topics.insert(std::make_pair(subscription_id, nullptr));
         if (result.second) {
-            result.first->second.reset(new wamp_broker_topic(subscribe_message->get_topic()));
-            result.first->second->add_session(session);
+            result.first->second.reset(new wamp_broker_topic(topic_id));
+            result.first->second->add_session(session.get());
         } else {
-            result.first->second->add_session(session);
+            result.first->second->add_session(session.get());
         }
     }
 
-    m_session_subscriptions[session_id].insert(subscription_id);
+    m_session_subscriptions[session->get_session_id()].insert(subscription_id);
 
     std::unique_ptr<wamp_subscribed_message> subscribed_message(new wamp_subscribed_message);
     subscribed_message->set_request_id(subscribe_message->get_request_id());
@@ -179,25 +202,20 @@ void wamp_broker::process_subscribe_message(const wamp_session_id& session_id,
     session->get_transport()->send_message(std::move(*subscribed_message));
 }
 
-void wamp_broker::process_unsubscribe_message(const wamp_session_id& session_id,
+void wamp_broker::process_unsubscribe_message(const std::shared_ptr<wamp_session>& session,
         const wamp_unsubscribe_message* unsubscribe_message)
 {
-    auto session_itr = m_sessions.find(session_id);
-    if (session_itr == m_sessions.end()) {
-        throw std::logic_error("broker session does not exist");
-    }
-
-    BONEFISH_TRACE("%1%, %2%", *session_itr->second % *unsubscribe_message);
-    auto session_subscriptions_itr = m_session_subscriptions.find(session_id);
+    BONEFISH_TRACE("%1%, %2%", *session % *unsubscribe_message);
+    auto session_subscriptions_itr = m_session_subscriptions.find(session->get_session_id());
     if (session_subscriptions_itr == m_session_subscriptions.end()) {
-        send_error(session_itr->second->get_transport(), unsubscribe_message->get_type(),
+        send_error(session->get_transport(), unsubscribe_message->get_type(),
                 unsubscribe_message->get_request_id(), std::string("wamp.error.no_subscriptions_for_session"));
         return;
     }
 
     const wamp_subscription_id& subscription_id = unsubscribe_message->get_subscription_id();
     if (session_subscriptions_itr->second.erase(subscription_id) == 0) {
-        send_error(session_itr->second->get_transport(), unsubscribe_message->get_type(),
+        send_error(session->get_transport(), unsubscribe_message->get_type(),
                 unsubscribe_message->get_request_id(), std::string("wamp.error.no_such_subscription"));
         return;
     }
@@ -206,19 +224,20 @@ void wamp_broker::process_unsubscribe_message(const wamp_session_id& session_id,
     if (subscription_topics_itr == m_subscription_topics.end()) {
         BONEFISH_TRACE("error: broker subscription topics are out of sync");
     } else {
-        std::string topic = subscription_topics_itr->second->get_topic();
-        subscription_topics_itr->second->remove_session(session_itr->second);
-        if (subscription_topics_itr->second->get_sessions().size() == 0) {
+        const wamp_uri_id topic_id = subscription_topics_itr->second->get_topic_id();
+        subscription_topics_itr->second->remove_session(session.get());
+        if (subscription_topics_itr->second->get_sessions().empty()) {
             m_subscription_topics.erase(subscription_id);
         }
 
-        auto topic_subscriptions_itr = m_topic_subscriptions.find(topic);
+        auto topic_subscriptions_itr = m_topic_subscriptions.find(topic_id);
         if (topic_subscriptions_itr == m_topic_subscriptions.end()) {
             BONEFISH_TRACE("error: broker topic subscription out of sync");
         } else {
-            topic_subscriptions_itr->second->remove_session(session_itr->second);
-            if (topic_subscriptions_itr->second->get_sessions().size() == 0) {
-                m_topic_subscriptions.erase(topic);
+            topic_subscriptions_itr->second->remove_session(session.get());
+            if (topic_subscriptions_itr->second->get_sessions().empty()) {
+                m_topic_subscriptions.erase(topic_subscriptions_itr);
+                m_uri_table.release(topic_id);
             }
         }
     }
@@ -226,11 +245,71 @@ void wamp_broker::process_unsubscribe_message(const wamp_session_id& session_id,
     std::unique_ptr<wamp_unsubscribed_message> unsubscribed_message(new wamp_unsubscribed_message);
     unsubscribed_message->set_request_id(unsubscribe_message->get_request_id());
 
-    BONEFISH_TRACE("%1%, %2%", *session_itr->second % *unsubscribed_message);
-    session_itr->second->get_transport()->send_message(std::move(*unsubscribed_message));
+    BONEFISH_TRACE("%1%, %2%", *session % *unsubscribed_message);
+    session->get_transport()->send_message(std::move(*unsubscribed_message));
+}
+
+wamp_subscription_id wamp_broker::subscribe_event_handler(const std::string& topic,
+        const wamp_event_handler& handler)
+{
+    if (m_dispatching_events) {
+        throw std::logic_error("cannot subscribe an event handler while dispatching events");
+    }
+
+    if (!is_valid_uri(topic)) {
+        throw std::invalid_argument("invalid topic uri");
+    }
+
+    // Each topic with handlers holds a single reference to its interned
+    // topic which is released along with the last handler.
+    wamp_uri_id topic_id = m_uri_table.find(topic);
+    if (!m_topic_event_handlers.count(topic_id)) {
+        topic_id = m_uri_table.acquire(topic);
+    }
+
+    const wamp_subscription_id subscription_id = m_subscription_id_generator.generate();
+    m_topic_event_handlers[topic_id].push_back(std::make_pair(subscription_id, handler));
+    m_event_handler_topics[subscription_id] = topic_id;
+
+    BONEFISH_TRACE("subscribed event handler: topic %1%", topic);
+    return subscription_id;
+}
+
+bool wamp_broker::unsubscribe_event_handler(const wamp_subscription_id& subscription_id)
+{
+    if (m_dispatching_events) {
+        throw std::logic_error("cannot unsubscribe an event handler while dispatching events");
+    }
+
+    auto event_handler_topics_itr = m_event_handler_topics.find(subscription_id);
+    if (event_handler_topics_itr == m_event_handler_topics.end()) {
+        return false;
+    }
+
+    const wamp_uri_id topic_id = event_handler_topics_itr->second;
+    m_event_handler_topics.erase(event_handler_topics_itr);
+
+    auto topic_event_handlers_itr = m_topic_event_handlers.find(topic_id);
+    if (topic_event_handlers_itr == m_topic_event_handlers.end()) {
+        BONEFISH_TRACE("error: broker event handlers are out of sync");
+        return true;
+    }
+
+    auto& handlers = topic_event_handlers_itr->second;
+    handlers.erase(std::remove_if(handlers.begin(), handlers.end(),
+            [&](const event_handlers::value_type& handler) {
+                return handler.first == subscription_id;
+            }), handlers.end());
+
+    if (handlers.empty()) {
+        m_topic_event_handlers.erase(topic_event_handlers_itr);
+        m_uri_table.release(topic_id);
+    }
+
+    return true;
 }
 
-void wamp_broker::send_error(const std::unique_ptr<wamp_transport>& transport,
+void wamp_broker::send_error(const std::shared_ptr<wamp_transport>& transport,
         const wamp_message_type request_type, const wamp_request_id& request_id,
         const std::string& error) const
 {
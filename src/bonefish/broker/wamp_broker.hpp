@@ -17,6 +17,7 @@
 #ifndef BONEFISH_BROKER_WAMP_BROKER_HPP
 #define BONEFISH_BROKER_WAMP_BROKER_HPP
 
+#include <bonefish/broker/wamp_event.hpp>
 #include <bonefish/identifiers/wamp_publication_id.hpp>
 #include <bonefish/identifiers/wamp_publication_id_generator.hpp>
 #include <bonefish/identifiers/wamp_request_id.hpp>
@@ -24,10 +25,13 @@
 #include <bonefish/identifiers/wamp_subscription_id.hpp>
 #include <bonefish/identifiers/wamp_subscription_id_generator.hpp>
 #include <bonefish/messages/wamp_message_type.hpp>
+#include <bonefish/utility/wamp_uri_table.hpp>
 
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace bonefish {
 
@@ -42,32 +46,53 @@ class wamp_unsubscribe_message;
 class wamp_broker
 {
 public:
-    wamp_broker(const std::string& realm);
+    wamp_broker(const std::string& realm, wamp_uri_table& uri_table);
     ~wamp_broker();
 
     void attach_session(const std::shared_ptr<wamp_session>& session);
-    void detach_session(const wamp_session_id& id);
+    void detach_session(const std::shared_ptr<wamp_session>& session);
 
-    void process_publish_message(const wamp_session_id& session_id,
+    void process_publish_message(const std::shared_ptr<wamp_session>& session,
             const wamp_publish_message* publish_message);
-    void process_subscribe_message(const wamp_session_id& session_id,
+    void process_subscribe_message(const std::shared_ptr<wamp_session>& session,
             const wamp_subscribe_message* subscribe_message);
-    void process_unsubscribe_message(const wamp_session_id& session_id,
+    void process_unsubscribe_message(const std::shared_ptr<wamp_session>& session,
             const wamp_unsubscribe_message* unsubscribe_message);
 
+    /// Subscribes a handler inside of the router to a topic. The handler is
+    /// invoked for every publication to the topic without building an event
+    /// message. Handlers cannot be added or removed from within a handler.
+    wamp_subscription_id subscribe_event_handler(const std::string& topic,
+            const wamp_event_handler& handler);
+
+    /// Removes a handler that was subscribed inside of the router. Returns
+    /// false if there is no such subscription.
+    bool unsubscribe_event_handler(const wamp_subscription_id& subscription_id);
+
 private:
-    void send_error(const std::unique_ptr<wamp_transport>& transport,
+    void send_error(const std::shared_ptr<wamp_transport>& transport,
             const wamp_message_type request_type, const wamp_request_id& request_id,
             const std::string& error) const;
 
 private:
     const std::string m_realm;
+    wamp_uri_table& m_uri_table;
     wamp_publication_id_generator m_publication_id_generator;
     wamp_subscription_id_generator m_subscription_id_generator;
-    std::unordered_map<wamp_session_id, std::shared_ptr<wamp_session>> m_sessions;
     std::unordered_map<wamp_session_id, std::unordered_set<wamp_subscription_id>> m_session_subscriptions;
-    std::unordered_map<std::string, std::unique_ptr<wamp_broker_subscription>> m_topic_subscriptions;
+    std::unordered_map<wamp_uri_id, std::unique_ptr<wamp_broker_subscription>> m_topic_subscriptions;
     std::unordered_map<wamp_subscription_id, std::unique_ptr<wamp_broker_topic>> m_subscription_topics;
+
+    /// Scratch buffer for the subscribers an event is fanned out to.
+    std::vector<wamp_session*> m_fanout_subscribers;
+
+    /// The handlers subscribed inside of the router. They are kept apart from
+    /// the session subscriptions so that publications without any remote
+    /// subscribers never build an event message.
+    typedef std::vector<std::pair<wamp_subscription_id, wamp_event_handler>> event_handlers;
+    std::unordered_map<wamp_uri_id, event_handlers> m_topic_event_handlers;
+    std::unordered_map<wamp_subscription_id, wamp_uri_id> m_event_handler_topics;
+    bool m_dispatching_events;
 };
 
 } // namespace bonefish
@@ -0,0 +1,125 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_BROKER_WAMP_BROKER_SUBSCRIBERS_HPP
+#define BONEFISH_BROKER_WAMP_BROKER_SUBSCRIBERS_HPP
+
+#include <bonefish/session/wamp_session.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace bonefish {
+
+/// A dense set of subscribed sessions. The sessions are kept contiguous in
+/// memory so that fanning out an event is a linear walk over an array rather
+/// than a walk over hash buckets and nodes. Removal swaps the last session
+/// into the vacated position so that it remains constant time. The position
+/// of each session is stored in an array indexed by the slot of the session
+/// in the router's session table. Slots are unique among attached sessions
+/// and are reused densely, so the array only grows up to the highest slot
+/// that has subscribed.
+///
+/// The sessions are not owned by this container. The router's session table
+/// owns them and the broker removes a session from all subscribers before the
+/// session's slot is released.
+class wamp_broker_subscribers
+{
+public:
+    wamp_broker_subscribers();
+    ~wamp_broker_subscribers();
+
+    bool add_session(wamp_session* session);
+    bool remove_session(const wamp_session* session);
+
+    bool empty() const;
+    size_t size() const;
+    const std::vector<wamp_session*>& get_sessions() const;
+
+private:
+    static const size_t NO_INDEX = std::numeric_limits<size_t>::max();
+
+    std::vector<wamp_session*> m_sessions;
+
+    /// The position of each session in the sessions indexed by slot.
+    std::vector<size_t> m_session_indices;
+};
+
+inline wamp_broker_subscribers::wamp_broker_subscribers()
+    : m_sessions()
+    , m_session_indices()
+{
+}
+
+inline wamp_broker_subscribers::~wamp_broker_subscribers()
+{
+}
+
+inline bool wamp_broker_subscribers::add_session(wamp_session* session)
+{
+    const uint32_t slot_index = session->get_slot().index();
+    if (slot_index >= m_session_indices.size()) {
+        m_session_indices.resize(slot_index + 1, static_cast<size_t>(NO_INDEX));
+    } else if (m_session_indices[slot_index] != NO_INDEX) {
+        return false;
+    }
+
+    m_session_indices[slot_index] = m_sessions.size();
+    m_sessions.push_back(session);
+    return true;
+}
+
+inline bool wamp_broker_subscribers::remove_session(const wamp_session* session)
+{
+    const uint32_t slot_index = session->get_slot().index();
+    if (slot_index >= m_session_indices.size() || m_session_indices[slot_index] == NO_INDEX) {
+        return false;
+    }
+
+    const size_t index = m_session_indices[slot_index];
+    m_session_indices[slot_index] = NO_INDEX;
+
+    // Swap the last session into the vacated slot to keep the array dense.
+    wamp_session* last_session = m_sessions.back();
+    m_sessions.pop_back();
+    if (index != m_sessions.size()) {
+        m_sessions[index] = last_session;
+        m_session_indices[last_session->get_slot().index()] = index;
+    }
+
+    return true;
+}
+
+inline bool wamp_broker_subscribers::empty() const
+{
+    return m_sessions.empty();
+}
+
+inline size_t wamp_broker_subscribers::size() const
+{
+    return m_sessions.size();
+}
+
+inline const std::vector<wamp_session*>& wamp_broker_subscribers::get_sessions() const
+{
+    return m_sessions;
+}
+
+} // namespace bonefish
+
+#endif // BONEFISH_BROKER_WAMP_BROKER_SUBSCRIBERS_HPP
@@ -17,10 +17,11 @@
 #ifndef BONEFISH_BROKER_WAMP_BROKER_SUBSCRIPTION_HPP
 #define BONEFISH_BROKER_WAMP_BROKER_SUBSCRIPTION_HPP
 
+#include <bonefish/broker/wamp_broker_subscribers.hpp>
 #include <bonefish/identifiers/wamp_subscription_id.hpp>
 #include <bonefish/session/wamp_session.hpp>
 
-#include <unordered_set>
+#include <vector>
 
 namespace bonefish {
 
@@ -31,14 +32,14 @@ public:
     wamp_broker_subscription(const wamp_subscription_id& subscription_id);
     ~wamp_broker_subscription();
 
-    bool add_session(const std::shared_ptr<wamp_session>& session);
-    bool remove_session(const std::shared_ptr<wamp_session>& session);
+    bool add_session(wamp_session* session);
+    bool remove_session(const wamp_session* session);
     const wamp_subscription_id& get_subscription_id() const;
-    const std::unordered_set<std::shared_ptr<wamp_session>>& get_sessions() const;
+    const std::vector<wamp_session*>& get_sessions() const;
 
 private:
     const wamp_subscription_id m_subscription_id;
-    std::unordered_set<std::shared_ptr<wamp_session>> m_sessions;
+    wamp_broker_subscribers m_sessions;
 };
 
 inline wamp_broker_subscription::wamp_broker_subscription()
@@ -57,15 +58,14 @@ inline wamp_broker_subscription::~wamp_broker_subscription()
 {
 }
 
-inline bool wamp_broker_subscription::add_session(const std::shared_ptr<wamp_session>& session)
+inline bool wamp_broker_subscription::add_session(wamp_session* session)
 {
-    auto result = m_sessions.insert(session);
-    return result.second;
+    return m_sessions.add_session(session);
 }
 
-inline bool wamp_broker_subscription::remove_session(const std::shared_ptr<wamp_session>& session)
+inline bool wamp_broker_subscription::remove_session(const wamp_session* session)
 {
-    return m_sessions.erase(session) != 0;
+    return m_sessions.remove_session(session);
 }
 
 inline const wamp_subscription_id& wamp_broker_subscription::get_subscription_id() const
@@ -73,9 +73,9 @@ inline const wamp_subscription_id& wamp_broker_subscription::get_subscription_id
     return m_subscription_id;
 }
 
-inline const std::unordered_set<std::shared_ptr<wamp_session>>& wamp_broker_subscription::get_sessions() const
+inline const std::vector<wamp_session*>& wamp_broker_subscription::get_sessions() const
 {
-    return m_sessions;
+    return m_sessions.get_sessions();
 }
 
 } // namespace bonefish
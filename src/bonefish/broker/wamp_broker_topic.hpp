@@ -17,9 +17,11 @@
 #ifndef BONEFISH_BROKER_WAMP_BROKER_TOPIC_HPP
 #define BONEFISH_BROKER_WAMP_BROKER_TOPIC_HPP
 
+#include <bonefish/broker/wamp_broker_subscribers.hpp>
 #include <bonefish/session/wamp_session.hpp>
+#include <bonefish/utility/wamp_uri_table.hpp>
 
-#include <unordered_set>
+#include <vector>
 
 namespace bonefish {
 
@@ -27,27 +29,27 @@ class wamp_broker_topic
 {
 public:
     wamp_broker_topic();
-    wamp_broker_topic(const std::string& topic);
+    wamp_broker_topic(const wamp_uri_id& topic_id);
     ~wamp_broker_topic();
 
-    bool add_session(const std::shared_ptr<wamp_session>& session);
-    bool remove_session(const std::shared_ptr<wamp_session>& session);
-    const std::string& get_topic() const;
-    const std::unordered_set<std::shared_ptr<wamp_session>>& get_sessions();
+    bool add_session(wamp_session* session);
+    bool remove_session(const wamp_session* session);
+    const wamp_uri_id& get_topic_id() const;
+    const std::vector<wamp_session*>& get_sessions();
 
 private:
-    const std::string m_topic;
-    std::unordered_set<std::shared_ptr<wamp_session>> m_sessions;
+    const wamp_uri_id m_topic_id;
+    wamp_broker_subscribers m_sessions;
 };
 
 inline wamp_broker_topic::wamp_broker_topic()
-    : m_topic()
+    : m_topic_id(wamp_uri_table::INVALID_URI_ID)
     , m_sessions()
 {
 }
 
-inline wamp_broker_topic::wamp_broker_topic(const std::string& topic)
-    : m_topic(topic)
+inline wamp_broker_topic::wamp_broker_topic(const wamp_uri_id& topic_id)
+    : m_topic_id(topic_id)
     , m_sessions()
 {
 }
@@ -56,25 +58,24 @@ inline wamp_broker_topic::~wamp_broker_topic()
 {
 }
 
-inline bool wamp_broker_topic::add_session(const std::shared_ptr<wamp_session>& session)
+inline bool wamp_broker_topic::add_session(wamp_session* session)
 {
-    auto result = m_sessions.insert(session);
-    return result.second;
+    return m_sessions.add_session(session);
 }
 
-inline bool wamp_broker_topic::remove_session(const std::shared_ptr<wamp_session>& session)
+inline bool wamp_broker_topic::remove_session(const wamp_session* session)
 {
-    return m_sessions.erase(session) != 0;
+    return m_sessions.remove_session(session);
 }
 
-inline const std::string& wamp_broker_topic::get_topic() const
+inline const wamp_uri_id& wamp_broker_topic::get_topic_id() const
 {
-    return m_topic;
+    return m_topic_id;
 }
 
-inline const std::unordered_set<std::shared_ptr<wamp_session>>& wamp_broker_topic::get_sessions()
+inline const std::vector<wamp_session*>& wamp_broker_topic::get_sessions()
 {
-    return m_sessions;
+    return m_sessions.get_sessions();
 }
 
 } // namespace bonefish
@@ -0,0 +1,85 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_BROKER_WAMP_EVENT_HPP
+#define BONEFISH_BROKER_WAMP_EVENT_HPP
+
+#include <boost/utility/string_ref.hpp>
+#include <cstdint>
+#include <functional>
+#include <msgpack.hpp>
+
+namespace bonefish {
+
+/// An event that is delivered to a handler inside of the router. The event
+/// is a view of the PUBLISH message and is only valid while the handler is
+/// running. Handlers have to copy anything that they want to keep.
+class wamp_event
+{
+public:
+    wamp_event(const boost::string_ref& topic, uint64_t publication_id,
+            const msgpack::object& arguments,
+            const msgpack::object& arguments_kw);
+
+    const boost::string_ref& get_topic() const;
+    uint64_t get_publication_id() const;
+    const msgpack::object& get_arguments() const;
+    const msgpack::object& get_arguments_kw() const;
+
+private:
+    boost::string_ref m_topic;
+    uint64_t m_publication_id;
+    const msgpack::object& m_arguments;
+    const msgpack::object& m_arguments_kw;
+};
+
+/// Receives events synchronously on the router thread while the publication
+/// is being processed.
+typedef std::function<void(const wamp_event&)> wamp_event_handler;
+
+inline wamp_event::wamp_event(const boost::string_ref& topic, uint64_t publication_id,
+        const msgpack::object& arguments,
+        const msgpack::object& arguments_kw)
+    : m_topic(topic)
+    , m_publication_id(publication_id)
+    , m_arguments(arguments)
+    , m_arguments_kw(arguments_kw)
+{
+}
+
+inline const boost::string_ref& wamp_event::get_topic() const
+{
+    return m_topic;
+}
+
+inline uint64_t wamp_event::get_publication_id() const
+{
+    return m_publication_id;
+}
+
+inline const msgpack::object& wamp_event::get_arguments() const
+{
+    return m_arguments;
+}
+
+inline const msgpack::object& wamp_event::get_arguments_kw() const
+{
+    return m_arguments_kw;
+}
+
+} // namespace bonefish
+
+#endif // BONEFISH_BROKER_WAMP_EVENT_HPP
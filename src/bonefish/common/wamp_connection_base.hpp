@@ -17,12 +17,18 @@
 #ifndef BONEFISH_WAMP_CONNECTION_BASE_HPP
 #define BONEFISH_WAMP_CONNECTION_BASE_HPP
 
+#include <bonefish/common/wamp_message_inbox.hpp>
 #include <bonefish/identifiers/wamp_session_id.hpp>
+#include <bonefish/session/wamp_session_slot.hpp>
 
+#include <memory>
 #include <string>
 
 namespace bonefish {
 
+class wamp_router;
+class wamp_transport;
+
 class wamp_connection_base
 {
 public:
@@ -37,16 +43,49 @@ public:
     void set_session_id(const wamp_session_id& id);
     const wamp_session_id& get_session_id() const;
 
+    void set_session_slot(const wamp_session_slot& slot);
+    const wamp_session_slot& get_session_slot() const;
+
+    void set_router(const std::shared_ptr<wamp_router>& router);
+    const std::shared_ptr<wamp_router>& get_router() const;
+
+    void set_transport(const std::shared_ptr<wamp_transport>& transport);
+    const std::shared_ptr<wamp_transport>& get_transport() const;
+
+    /// Messages that were received on another thread than the one that
+    /// drives the routers and wait to be processed by the routers.
+    wamp_message_inbox& get_inbox();
+
     void clear_data();
 
 private:
     std::string m_realm;
     wamp_session_id m_session_id;
+
+    /// The slot of the session in the routers session table. This is cached
+    /// so that messages arriving on the connection can resolve their session
+    /// without a hash table lookup.
+    wamp_session_slot m_session_slot;
+
+    /// The router for the connections realm. This is resolved once when the
+    /// session is established rather than looking up the realm per message.
+    std::shared_ptr<wamp_router> m_router;
+
+    /// The transport used for sending messages over the connection. This is
+    /// created once when the connection is established and is shared with
+    /// any session that is opened on the connection.
+    std::shared_ptr<wamp_transport> m_transport;
+
+    wamp_message_inbox m_inbox;
 };
 
 inline wamp_connection_base::wamp_connection_base()
     : m_realm()
     , m_session_id()
+    , m_session_slot()
+    , m_router()
+    , m_transport()
+    , m_inbox()
 {
 }
 
@@ -84,10 +123,47 @@ inline const wamp_session_id& wamp_connection_base::get_session_id() const
     return m_session_id;
 }
 
+inline void wamp_connection_base::set_session_slot(const wamp_session_slot& slot)
+{
+    m_session_slot = slot;
+}
+
+inline const wamp_session_slot& wamp_connection_base::get_session_slot() const
+{
+    return m_session_slot;
+}
+
+inline void wamp_connection_base::set_router(const std::shared_ptr<wamp_router>& router)
+{
+    m_router = router;
+}
+
+inline const std::shared_ptr<wamp_router>& wamp_connection_base::get_router() const
+{
+    return m_router;
+}
+
+inline void wamp_connection_base::set_transport(const std::shared_ptr<wamp_transport>& transport)
+{
+    m_transport = transport;
+}
+
+inline const std::shared_ptr<wamp_transport>& wamp_connection_base::get_transport() const
+{
+    return m_transport;
+}
+
+inline wamp_message_inbox& wamp_connection_base::get_inbox()
+{
+    return m_inbox;
+}
+
 inline void wamp_connection_base::clear_data()
 {
     m_session_id = wamp_session_id();
+    m_session_slot = wamp_session_slot();
     m_realm = std::string();
+    m_router.reset();
 }
 
 } // namespace bonefish
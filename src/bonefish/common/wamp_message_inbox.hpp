@@ -0,0 +1,87 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_WAMP_MESSAGE_INBOX_HPP
+#define BONEFISH_WAMP_MESSAGE_INBOX_HPP
+
+#include <bonefish/messages/wamp_message.hpp>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace bonefish {
+
+/// Hands decoded messages from the thread that services a connection over
+/// to the thread that drives the routers. Messages are collected until the
+/// routers take all of them at once so only the first message after each
+/// take needs to wake up the routers. The two buffers are swapped rather
+/// than reallocated so the hand-off does not allocate in steady state.
+class wamp_message_inbox
+{
+public:
+    wamp_message_inbox();
+    ~wamp_message_inbox();
+
+    wamp_message_inbox(const wamp_message_inbox&) = delete;
+    wamp_message_inbox& operator=(const wamp_message_inbox&) = delete;
+
+    /// Adds a message. Returns true if the routers have to be told to take
+    /// the messages as they have not been told since the last take.
+    bool push(std::unique_ptr<wamp_message>&& message);
+
+    /// Moves all messages into the given buffer which must be empty.
+    void take(std::vector<std::unique_ptr<wamp_message>>& messages);
+
+private:
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<wamp_message>> m_messages;
+    bool m_take_pending;
+};
+
+inline wamp_message_inbox::wamp_message_inbox()
+    : m_mutex()
+    , m_messages()
+    , m_take_pending(false)
+{
+}
+
+inline wamp_message_inbox::~wamp_message_inbox()
+{
+}
+
+inline bool wamp_message_inbox::push(std::unique_ptr<wamp_message>&& message)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_messages.push_back(std::move(message));
+    if (m_take_pending) {
+        return false;
+    }
+
+    m_take_pending = true;
+    return true;
+}
+
+inline void wamp_message_inbox::take(std::vector<std::unique_ptr<wamp_message>>& messages)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_messages.swap(messages);
+    m_take_pending = false;
+}
+
+} // namespace bonefish
+
+#endif // BONEFISH_WAMP_MESSAGE_INBOX_HPP
@@ -15,10 +15,12 @@
  */
 
 #include <bonefish/common/wamp_message_processor.hpp>
+#include <bonefish/common/wamp_connection_base.hpp>
 #include <bonefish/identifiers/wamp_session_id.hpp>
 #include <bonefish/identifiers/wamp_session_id_generator.hpp>
 #include <bonefish/messages/wamp_abort_message.hpp>
 #include <bonefish/messages/wamp_call_message.hpp>
+#include <bonefish/messages/wamp_cancel_message.hpp>
 #include <bonefish/messages/wamp_error_message.hpp>
 #include <bonefish/messages/wamp_goodbye_message.hpp>
 #include <bonefish/messages/wamp_hello_details.hpp>
@@ -40,7 +42,6 @@ namespace bonefish {
 
 void wamp_message_processor::process_message(
         const std::unique_ptr<wamp_message>& message,
-        std::unique_ptr<wamp_transport>&& transport,
         wamp_connection_base* connection)
 {
     BONEFISH_TRACE("processing message: %1%", message_type_to_string(message->get_type()));
@@ -50,31 +51,40 @@ void wamp_message_processor::process_message(
             break;
         case wamp_message_type::CALL:
         {
-            std::shared_ptr<wamp_router> router = m_routers->get_router(connection->get_realm());
+            const std::shared_ptr<wamp_router>& router = connection->get_router();
             if (router) {
                 wamp_call_message* call_message = static_cast<wamp_call_message*>(message.get());
-                router->process_call_message(connection->get_session_id(), call_message);
+                router->process_call_message(connection->get_session_slot(), call_message);
             }
             break;
         }
         case wamp_message_type::CANCEL:
+        {
+            const std::shared_ptr<wamp_router>& router = connection->get_router();
+            if (router) {
+                wamp_cancel_message* cancel_message = static_cast<wamp_cancel_message*>(message.get());
+                router->process_cancel_message(connection->get_session_slot(), cancel_message);
+            }
             break;
+        }
         case wamp_message_type::ERROR:
         {
-            std::shared_ptr<wamp_router> router = m_routers->get_router(connection->get_realm());
+            const std::shared_ptr<wamp_router>& router = connection->get_router();
             if (router) {
                 wamp_error_message* error_message = static_cast<wamp_error_message*>(message.get());
-                router->process_error_message(connection->get_session_id(), error_message);
+                router->process_error_message(connection->get_session_slot(), error_message);
             }
             break;
         }
         case wamp_message_type::GOODBYE:
         {
-            std::shared_ptr<wamp_router> router = m_routers->get_router(connection->get_realm());
+            // Take a copy of the router as clearing the connection data
+            // below releases the connections reference to it.
+            std::shared_ptr<wamp_router> router = connection->get_router();
             if (router) {
                 wamp_goodbye_message* goodbye_message = static_cast<wamp_goodbye_message*>(message.get());
-                router->process_goodbye_message(connection->get_session_id(), goodbye_message);
-                router->detach_session(connection->get_session_id());
+                router->process_goodbye_message(connection->get_session_slot(), goodbye_message);
+                router->detach_session(connection->get_session_slot());
             }
             connection->clear_data();
             break;
@@ -86,7 +96,7 @@ void wamp_message_processor::process_message(
             if (!router) {
                 std::unique_ptr<wamp_abort_message> abort_message(new wamp_abort_message);
                 abort_message->set_reason("wamp.error.no_such_realm");
-                transport->send_message(std::move(*abort_message));
+                connection->get_transport()->send_message(std::move(*abort_message));
             } else {
                 wamp_session_id id;
                 auto generator = router->get_session_id_generator();
@@ -96,6 +106,7 @@ void wamp_message_processor::process_message(
 
                 connection->set_session_id(id);
                 connection->set_realm(hello_message->get_realm());
+                connection->set_router(router);
 
                 // We need to setup the sessions roles before attaching the session
                 // so that we know whether or not to also attach the session to the
@@ -104,65 +115,66 @@ void wamp_message_processor::process_message(
                 hello_details.unmarshal(hello_message->get_details());
 
                 auto session = std::make_shared<wamp_session>(
-                        id, hello_message->get_realm(), std::move(transport));
+                        id, hello_message->get_realm(), connection->get_transport());
                 session->set_roles(hello_details.get_roles());
 
                 router->attach_session(session);
-                router->process_hello_message(id, hello_message);
+                connection->set_session_slot(session->get_slot());
+                router->process_hello_message(session->get_slot(), hello_message);
             }
             break;
         }
         case wamp_message_type::PUBLISH:
         {
-            std::shared_ptr<wamp_router> router = m_routers->get_router(connection->get_realm());
+            const std::shared_ptr<wamp_router>& router = connection->get_router();
             if (router) {
                 wamp_publish_message* publish_message = static_cast<wamp_publish_message*>(message.get());
-                router->process_publish_message(connection->get_session_id(), publish_message);
+                router->process_publish_message(connection->get_session_slot(), publish_message);
             }
             break;
         }
         case wamp_message_type::REGISTER:
         {
-            std::shared_ptr<wamp_router> router = m_routers->get_router(connection->get_realm());
+            const std::shared_ptr<wamp_router>& router = connection->get_router();
             if (router) {
                 wamp_register_message* register_message = static_cast<wamp_register_message*>(message.get());
-                router->process_register_message(connection->get_session_id(), register_message);
+                router->process_register_message(connection->get_session_slot(), register_message);
             }
             break;
         }
         case wamp_message_type::SUBSCRIBE:
         {
-            std::shared_ptr<wamp_router> router = m_routers->get_router(connection->get_realm());
+            const std::shared_ptr<wamp_router>& router = connection->get_router();
             if (router) {
                 wamp_subscribe_message* subscribe_message = static_cast<wamp_subscribe_message*>(message.get());
-                router->process_subscribe_message(connection->get_session_id(), subscribe_message);
+                router->process_subscribe_message(connection->get_session_slot(), subscribe_message);
             }
             break;
         }
         case wamp_message_type::UNREGISTER:
         {
-            std::shared_ptr<wamp_router> router = m_routers->get_router(connection->get_realm());
+            const std::shared_ptr<wamp_router>& router = connection->get_router();
             if (router) {
                 wamp_unregister_message* unregister_message = static_cast<wamp_unregister_message*>(message.get());
-                router->process_unregister_message(connection->get_session_id(), unregister_message);
+                router->process_unregister_message(connection->get_session_slot(), unregister_message);
             }
             break;
         }
         case wamp_message_type::UNSUBSCRIBE:
         {
-            std::shared_ptr<wamp_router> router = m_routers->get_router(connection->get_realm());
+            const std::shared_ptr<wamp_router>& router = connection->get_router();
             if (router) {
                 wamp_unsubscribe_message* unsubscribe_message = static_cast<wamp_unsubscribe_message*>(message.get());
-                router->process_unsubscribe_message(connection->get_session_id(), unsubscribe_message);
+                router->process_unsubscribe_message(connection->get_session_slot(), unsubscribe_message);
             }
             break;
         }
         case wamp_message_type::YIELD:
         {
-            std::shared_ptr<wamp_router> router = m_routers->get_router(connection->get_realm());
+            const std::shared_ptr<wamp_router>& router = connection->get_router();
             if (router) {
                 wamp_yield_message* yield_message = static_cast<wamp_yield_message*>(message.get());
-                router->process_yield_message(connection->get_session_id(), yield_message);
+                router->process_yield_message(connection->get_session_slot(), yield_message);
             }
             break;
         }
@@ -171,4 +183,18 @@ void wamp_message_processor::process_message(
     }
 }
 
+void wamp_message_processor::process_inbox(wamp_connection_base* connection)
+{
+    connection->get_inbox().take(m_inbox_messages);
+    for (const auto& message : m_inbox_messages) {
+        try {
+            process_message(message, connection);
+        } catch (const std::exception& e) {
+            BONEFISH_TRACE("unhandled exception: %1%", e.what());
+        }
+    }
+
+    m_inbox_messages.clear();
+}
+
 } // namespace bonefish
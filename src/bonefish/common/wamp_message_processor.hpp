@@ -18,16 +18,16 @@
 #define BONEFISH_WAMP_MESSAGE_PROCESSOR_HPP
 
 #include <bonefish/identifiers/wamp_session_id.hpp>
+#include <bonefish/messages/wamp_message.hpp>
 
 #include <memory>
+#include <vector>
 
 namespace bonefish {
 
 class wamp_connection_base;
-class wamp_message;
 class wamp_routers;
 class wamp_session_id_generator;
-class wamp_transport;
 
 class wamp_message_processor
 {
@@ -37,16 +37,24 @@ public:
 
     void process_message(
             const std::unique_ptr<wamp_message>& message,
-            std::unique_ptr<wamp_transport>&& transport,
             wamp_connection_base* connection_base);
 
+    /// Processes the messages that are waiting in the inbox of the
+    /// connection in the order in which they arrived.
+    void process_inbox(wamp_connection_base* connection_base);
+
 private:
     std::shared_ptr<wamp_routers> m_routers;
+
+    /// The messages taken out of an inbox. The buffer is kept around so
+    /// that taking messages does not allocate.
+    std::vector<std::unique_ptr<wamp_message>> m_inbox_messages;
 };
 
 inline wamp_message_processor::wamp_message_processor(
         const std::shared_ptr<wamp_routers>& routers)
     : m_routers(routers)
+    , m_inbox_messages()
 {
 }
 
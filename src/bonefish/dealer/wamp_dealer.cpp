@@ -16,37 +16,55 @@
 
 #include <bonefish/dealer/wamp_dealer.hpp>
 #include <bonefish/dealer/wamp_dealer_invocation.hpp>
+#include <bonefish/dealer/wamp_dealer_parked_call.hpp>
 #include <bonefish/dealer/wamp_dealer_registration.hpp>
 #include <bonefish/messages/wamp_call_message.hpp>
 #include <bonefish/messages/wamp_call_options.hpp>
+#include <bonefish/messages/wamp_cancel_message.hpp>
+#include <bonefish/messages/wamp_cancel_options.hpp>
 #include <bonefish/messages/wamp_error_message.hpp>
+#include <bonefish/messages/wamp_interrupt_message.hpp>
 #include <bonefish/messages/wamp_invocation_message.hpp>
 #include <bonefish/messages/wamp_register_message.hpp>
+#include <bonefish/messages/wamp_register_options.hpp>
 #include <bonefish/messages/wamp_registered_message.hpp>
 #include <bonefish/messages/wamp_result_message.hpp>
 #include <bonefish/messages/wamp_unregister_message.hpp>
 #include <bonefish/messages/wamp_unregistered_message.hpp>
 #include <bonefish/messages/wamp_yield_message.hpp>
+#include <bonefish/messages/wamp_yield_options.hpp>
 #include <bonefish/session/wamp_session.hpp>
 #include <bonefish/trace/trace.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <map>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 namespace bonefish {
 
-wamp_dealer::wamp_dealer(boost::asio::io_service& io_service)
+wamp_dealer::wamp_dealer(boost::asio::io_service& io_service, wamp_uri_table& uri_table)
     : m_io_service(io_service)
+    , m_uri_table(uri_table)
     , m_request_id_generator()
     , m_registration_id_generator()
-    , m_sessions()
     , m_session_registrations()
     , m_registered_procedures()
     , m_procedure_registrations()
+    , m_pattern_registrations()
+    , m_procedure_patterns()
     , m_pending_invocations()
     , m_pending_caller_invocations()
     , m_pending_callee_invocations()
+    , m_coalesced_invocations()
+    , m_cache_stats()
+    , m_call_queue_depth(0)
+    , m_registration_grace_period_ms(0)
+    , m_parked_calls()
+    , m_lifetime(std::make_shared<wamp_dealer*>(this))
 {
 }
 
@@ -56,27 +74,19 @@ wamp_dealer::~wamp_dealer()
 
 void wamp_dealer::attach_session(const std::shared_ptr<wamp_session>& session)
 {
-    assert(session->get_role(wamp_role_type::CALLER) ||
-            session->get_role(wamp_role_type::CALLEE));
+    assert(session->has_role(wamp_role_type::CALLER) ||
+            session->has_role(wamp_role_type::CALLEE));
 
     BONEFISH_TRACE("attach session: %1%", *session);
-    auto result = m_sessions.insert(std::make_pair(session->get_session_id(), session));
-    if (!result.second) {
-        throw std::logic_error("dealer session already registered");
-    }
 }
 
-void wamp_dealer::detach_session(const wamp_session_id& session_id)
+void wamp_dealer::detach_session(const std::shared_ptr<wamp_session>& session)
 {
-    auto session_itr = m_sessions.find(session_id);
-    if (session_itr == m_sessions.end()) {
-        throw std::logic_error("dealer session does not exist");
-    }
+    assert(session->has_role(wamp_role_type::CALLER) ||
+            session->has_role(wamp_role_type::CALLEE));
 
-    assert(session_itr->second->get_role(wamp_role_type::CALLER) ||
-            session_itr->second->get_role(wamp_role_type::CALLEE));
-
-    BONEFISH_TRACE("detach session: %1%", *session_itr->second);
+    BONEFISH_TRACE("detach session: %1%", *session);
+    const wamp_session_id& session_id = session->get_session_id();
 
     // Cleanup all of the procedures that were registered by the session.
     // No messages need to be sent here it is strictly just cleaning up any
@@ -86,6 +96,10 @@ void wamp_dealer::detach_session(const wamp_session_id& session_id)
     if (session_registrations_itr != m_session_registrations.end()) {
         auto& registration_ids = session_registrations_itr->second;
         for (const auto& registration_id : registration_ids) {
+            if (erase_pattern_registration(registration_id)) {
+                continue;
+            }
+
             auto registered_procedures_itr =
                     m_registered_procedures.find(registration_id);
             if (registered_procedures_itr == m_registered_procedures.end()) {
@@ -98,33 +112,82 @@ void wamp_dealer::detach_session(const wamp_session_id& session_id)
                 throw std::logic_error("dealer procedure registrations out of sync");
             }
 
+            // Shared registrations remain as long as they have callees left.
+            const auto& dealer_registration = procedure_registrations_itr->second;
+            if (dealer_registration->remove_session(session) &&
+                    !dealer_registration->get_sessions().empty()) {
+                continue;
+            }
+
             BONEFISH_TRACE("removing registration: %1%, procedure %2%",
-                    *session_itr->second % procedure_registrations_itr->first);
+                    *session % m_uri_table.get_uri(procedure_registrations_itr->first));
 
+            m_uri_table.release(procedure_registrations_itr->first);
             m_procedure_registrations.erase(procedure_registrations_itr);
             m_registered_procedures.erase(registered_procedures_itr);
         }
         m_session_registrations.erase(session_registrations_itr);
     }
 
+    // Calls of the session that are waiting for their procedure to be
+    // registered are dropped as well.
+    for (auto parked_calls_itr = m_parked_calls.begin();
+            parked_calls_itr != m_parked_calls.end(); ) {
+        if ((*parked_calls_itr)->get_session() == session) {
+            parked_calls_itr = m_parked_calls.erase(parked_calls_itr);
+        } else {
+            ++parked_calls_itr;
+        }
+    }
+
     // Cleanup any pending caller invocations associated with the session.
     // Since the session would be the caller we do not have to send any
-    // messages here. Just simply cleanup any pending invocations.
+    // messages to it. Nobody is waiting for the results anymore though so
+    // the callees are interrupted once the state has been cleaned up.
     BONEFISH_TRACE("cleaning up pending caller invocations");
+    std::vector<std::pair<std::shared_ptr<wamp_session>, wamp_request_id>> interrupts;
     auto pending_caller_invocations_itr = m_pending_caller_invocations.find(session_id);
     if (pending_caller_invocations_itr != m_pending_caller_invocations.end()) {
         for (const auto& request_id : pending_caller_invocations_itr->second) {
             auto pending_invocations_itr = m_pending_invocations.find(request_id);
             if (pending_invocations_itr != m_pending_invocations.end()) {
                 const auto& dealer_invocation = pending_invocations_itr->second;
-                std::shared_ptr<wamp_session> session = dealer_invocation->get_session();
+                std::shared_ptr<wamp_session> caller = dealer_invocation->get_session();
 
                 BONEFISH_TRACE("cleaning up pending caller invocation: %1%, request_id %2%",
-                        *session % request_id);
-
+                        *caller % request_id);
+
+                // An invocation that other calls have joined keeps running for
+                // them without a caller of its own.
+                std::shared_ptr<wamp_session> callee = dealer_invocation->get_callee();
+                if (callee && has_followers(*dealer_invocation)) {
+                    dealer_invocation->set_session(nullptr);
+                    continue;
+                }
+
+                if (callee && callee != session) {
+                    erase_callee_invocation(callee, request_id);
+                    if (!dealer_invocation->is_canceled() && !dealer_invocation->is_queued()) {
+                        interrupts.push_back(std::make_pair(callee, request_id));
+                    }
+                }
+
+                if (dealer_invocation->get_fanout()) {
+                    for (const auto& fanout_callee :
+                            dealer_invocation->get_fanout()->get_pending_callees()) {
+                        if (fanout_callee != session) {
+                            erase_callee_invocation(fanout_callee, request_id);
+                            interrupts.push_back(std::make_pair(fanout_callee, request_id));
+                        }
+                    }
+                }
+
+                erase_coalesced_invocation(request_id, *dealer_invocation);
+                release_call_queue(request_id, *dealer_invocation);
                 m_pending_invocations.erase(pending_invocations_itr);
             }
         }
+        m_pending_caller_invocations.erase(pending_caller_invocations_itr);
     }
 
     // Cleanup any pending callee invocations associated with the session.
@@ -133,64 +196,161 @@ void wamp_dealer::detach_session(const wamp_session_id& session_id)
     BONEFISH_TRACE("cleaning up pending callee invocations");
     auto pending_callee_invocations_itr = m_pending_callee_invocations.find(session_id);
     if (pending_callee_invocations_itr != m_pending_callee_invocations.end()) {
-        for (const auto& request_id : pending_callee_invocations_itr->second) {
+        // Sending an error can detach the caller which also cleans up the
+        // callee invocations so the set is taken out of the map up front.
+        const std::unordered_set<wamp_request_id> request_ids =
+                std::move(pending_callee_invocations_itr->second);
+        m_pending_callee_invocations.erase(pending_callee_invocations_itr);
+
+        for (const auto& request_id : request_ids) {
             auto pending_invocations_itr = m_pending_invocations.find(request_id);
             if (pending_invocations_itr != m_pending_invocations.end()) {
-                const auto& dealer_invocation = pending_invocations_itr->second;
-                std::shared_ptr<wamp_session> session = dealer_invocation->get_session();
-                BONEFISH_TRACE("cleaning up pending callee invocation: %1%, request_id %2%",
-                        *session, request_id);
-
-                send_error(session->get_transport(), wamp_message_type::CALL,
-                        dealer_invocation->get_request_id(), "wamp.error.callee_session_closed");
-
-                m_pending_invocations.erase(pending_invocations_itr);
+                BONEFISH_TRACE("cleaning up pending callee invocation: request_id %1%",
+                        request_id);
+
+                // The other callees of a fanout call may still answer it.
+                wamp_dealer_fanout* fanout = pending_invocations_itr->second->get_fanout();
+                if (fanout) {
+                    if (fanout->set_error(session_id, "wamp.error.callee_session_closed",
+                            msgpack::object(), msgpack::object()) && fanout->is_complete()) {
+                        complete_fanout_invocation(request_id);
+                    }
+                    continue;
+                }
+
+                pending_callers callers = take_callers(request_id);
+                for (const auto& caller : callers) {
+                    send_error(caller.first->get_transport(), wamp_message_type::CALL,
+                            caller.second, "wamp.error.callee_session_closed");
+                }
             }
         }
     }
 
-    m_sessions.erase(session_itr);
+    for (const auto& interrupt : interrupts) {
+        send_interrupt(interrupt.first, interrupt.second, "killnowait");
+    }
 }
 
-void wamp_dealer::process_call_message(const wamp_session_id& session_id,
+void wamp_dealer::process_call_message(const std::shared_ptr<wamp_session>& session,
         const wamp_call_message* call_message)
 {
-    auto session_itr = m_sessions.find(session_id);
-    if (session_itr == m_sessions.end()) {
-        throw std::logic_error("dealer session does not exist");
-    }
+    process_call_message(session, call_message, nullptr);
+}
 
-    BONEFISH_TRACE("%1%, %2%", *session_itr->second % *call_message);
+void wamp_dealer::process_call_message(const std::shared_ptr<wamp_session>& session,
+        const wamp_call_message* call_message, const wamp_dealer_parked_call* parked_call)
+{
+    BONEFISH_TRACE("%1%, %2%", *session % *call_message);
 
     // If the session placing the call does not support the caller role
     // than do not allow the call to be processed and send an error.
-    if (!session_itr->second->get_role(wamp_role_type::CALLER)) {
-        send_error(session_itr->second->get_transport(), call_message->get_type(),
+    if (!session->has_role(wamp_role_type::CALLER)) {
+        send_error(session->get_transport(), call_message->get_type(),
                 call_message->get_request_id(), "wamp.error.role_violation");
         return;
     }
 
-    const auto procedure = call_message->get_procedure();
-    if (!is_valid_uri(procedure)) {
-        send_error(session_itr->second->get_transport(), call_message->get_type(),
-                call_message->get_request_id(), "wamp.error.invalid_uri");
-        return;
-    }
+    wamp_dealer_registration* registration = find_registration(call_message->get_procedure_ref());
+    if (!registration) {
+        // Registered procedures are validated when they are registered so the
+        // uri only needs to be validated when no registration is found in order
+        // to report the appropriate error.
+        if (!is_valid_uri(call_message->get_procedure())) {
+            send_error(session->get_transport(), call_message->get_type(),
+                    call_message->get_request_id(), "wamp.error.invalid_uri");
+            return;
+        }
 
-    auto procedure_registrations_itr = m_procedure_registrations.find(procedure);
-    if (procedure_registrations_itr == m_procedure_registrations.end()) {
-        send_error(session_itr->second->get_transport(), call_message->get_type(),
+        if (park_call(session, call_message)) {
+            return;
+        }
+
+        send_error(session->get_transport(), call_message->get_type(),
                 call_message->get_request_id(), "wamp.error.no_such_procedure");
         return;
     }
 
-    std::shared_ptr<wamp_session> session =
-            procedure_registrations_itr->second->get_session();
+    if (registration->is_native()) {
+        call_native_procedure(session, call_message, *registration, parked_call);
+        return;
+    }
 
     const wamp_request_id request_id = m_request_id_generator.generate();
 
-    const wamp_registration_id& registration_id =
-            procedure_registrations_itr->second->get_registration_id();
+    const wamp_registration_id& registration_id = registration->get_registration_id();
+
+    // Calls that waited for their procedure to be registered only have
+    // whatever is left of their timeout.
+    wamp_call_options options;
+    options.unmarshal(call_message->get_options());
+    unsigned timeout_ms = parked_call ? parked_call->get_remaining_ms()
+            : options.get_option_or<unsigned>("timeout", 0);
+    bool receive_progress = options.get_option_or<bool>("receive_progress", false);
+
+    const std::string fanout = options.get_option_or<std::string>("fanout", "single");
+    if (fanout == "all") {
+        process_fanout_call_message(session, call_message, *registration,
+                request_id, timeout_ms);
+        return;
+    } else if (fanout != "single") {
+        send_error(session->get_transport(), call_message->get_type(),
+                call_message->get_request_id(), "wamp.error.invalid_argument");
+        return;
+    }
+
+    // Calls to registrations that are routed by key are sent to the callee
+    // that owns the key given by the caller or else the first argument.
+    std::string routing_key;
+    if (registration->get_invoke_policy() == wamp_invoke_policy::KEY) {
+        routing_key = create_routing_key(options, call_message->get_arguments());
+    }
+
+    std::shared_ptr<wamp_session> callee = registration->next_session(routing_key);
+
+    // Calls to cacheable procedures are answered from the cache when possible.
+    // Progressive results are never cached so those calls bypass the cache.
+    // Sending a message can fail and detach the callee which in turn can
+    // destroy the registration. So the registration's cache and call queue
+    // are held on to rather than referenced.
+    std::string cache_key;
+    std::shared_ptr<wamp_dealer_result_cache> result_cache = registration->get_result_cache();
+    if (result_cache && !receive_progress) {
+        cache_key = wamp_dealer_result_cache::make_key(call_message->get_procedure_ref(),
+                call_message->get_arguments(), call_message->get_arguments_kw());
+        const wamp_dealer_result_cache::result* cached_result = result_cache->find(cache_key);
+        if (cached_result) {
+            m_cache_stats.add_hit();
+
+            std::unique_ptr<wamp_result_message> result_message(new wamp_result_message);
+            result_message->set_request_id(call_message->get_request_id());
+            result_message->set_arguments(cached_result->arguments);
+            result_message->set_arguments_kw(cached_result->arguments_kw);
+
+            BONEFISH_TRACE("%1%, %2%", *session % *result_message);
+            if (!session->get_transport()->send_message(std::move(*result_message))) {
+                BONEFISH_TRACE("failed to send result message to caller: network failure");
+            }
+            return;
+        }
+        m_cache_stats.add_miss();
+    }
+
+    // Identical calls to a coalescing procedure join the invocation that is
+    // already pending for them rather than invoking the callee again.
+    std::string coalesce_key;
+    if (registration->is_coalescing() && !receive_progress) {
+        coalesce_key = !cache_key.empty() ? cache_key
+                : wamp_dealer_result_cache::make_key(call_message->get_procedure_ref(),
+                        call_message->get_arguments(), call_message->get_arguments_kw());
+        auto coalesced_invocations_itr = m_coalesced_invocations.find(coalesce_key);
+        if (coalesced_invocations_itr != m_coalesced_invocations.end()) {
+            if (join_pending_invocation(session, call_message, request_id,
+                    coalesced_invocations_itr->second, timeout_ms)) {
+                return;
+            }
+        }
+    }
 
     std::unique_ptr<wamp_invocation_message> invocation_message(new wamp_invocation_message);
     invocation_message->set_request_id(request_id);
@@ -198,44 +358,195 @@ void wamp_dealer::process_call_message(const wamp_session_id& session_id,
     invocation_message->set_arguments(call_message->get_arguments());
     invocation_message->set_arguments_kw(call_message->get_arguments_kw());
 
-    BONEFISH_TRACE("%1%, %2%", *session_itr->second % *invocation_message);
-    if (!session->get_transport()->send_message(std::move(*invocation_message))) {
-        BONEFISH_TRACE("sending invocation message to callee failed: network failure");
+    // The callee is only allowed to yield progressive results if the caller
+    // asked for them. Callees of pattern based registrations are told which
+    // procedure was actually called. Callees are told how long the caller
+    // waits for the result so that they can give up on the call in time.
+    msgpack::zone zone;
+    std::map<std::string, msgpack::object> details;
+    if (receive_progress) {
+        details["receive_progress"] = msgpack::object(true);
+    }
+    if (timeout_ms) {
+        details["timeout"] = msgpack::object(timeout_ms);
+    }
+    if (registration->get_match_policy() != wamp_match_policy::EXACT) {
+        details["procedure"] = msgpack::object(call_message->get_procedure(), zone);
+    }
+    if (!details.empty()) {
+        invocation_message->set_details(msgpack::object(details, zone));
+    }
 
-        send_error(session_itr->second->get_transport(), call_message->get_type(),
-                call_message->get_request_id(), "wamp.error.network_failure");
+    // Calls to a registration with limited concurrency wait in its queue
+    // while all of its slots are taken. Once the queue is full the callee is
+    // considered to be unavailable.
+    std::shared_ptr<wamp_dealer_call_queue> call_queue = registration->get_call_queue();
+    const bool queued = call_queue && !call_queue->acquire();
+    if (queued && !call_queue->push(request_id)) {
+        BONEFISH_TRACE("call queue is full: %1%", call_message->get_procedure());
+        send_error(session->get_transport(), call_message->get_type(),
+                call_message->get_request_id(), "wamp.error.unavailable");
         return;
-    } else {
-        wamp_call_options options;
-        options.unmarshal(call_message->get_options());
-        unsigned timeout_ms = options.get_option_or<unsigned>("timeout", 0);
+    }
 
-        // We only setup the invocation state after sending the message is successful.
-        // This saves us from having to cleanup any state if the send fails.
-        std::unique_ptr<wamp_dealer_invocation> dealer_invocation(
-                new wamp_dealer_invocation(m_io_service));
+    if (!queued) {
+        BONEFISH_TRACE("%1%, %2%", *session % *invocation_message);
+        if (!callee->get_transport()->send_message(std::move(*invocation_message))) {
+            BONEFISH_TRACE("sending invocation message to callee failed: network failure");
+            if (call_queue) {
+                call_queue->release();
+            }
 
-        dealer_invocation->set_session(session_itr->second);
-        dealer_invocation->set_request_id(call_message->get_request_id());
-        dealer_invocation->set_timeout(
-                std::bind(&wamp_dealer::invocation_timeout_handler, this,
-                        request_id, std::placeholders::_1), timeout_ms);
+            send_error(session->get_transport(), call_message->get_type(),
+                    call_message->get_request_id(), "wamp.error.network_failure");
+            return;
+        }
+    }
 
-        m_pending_invocations.insert(std::make_pair(request_id, std::move(dealer_invocation)));
-        m_pending_callee_invocations[session->get_session_id()].insert(request_id);
-        m_pending_caller_invocations[session_id].insert(request_id);
+    // We only setup the invocation state after sending the message is successful.
+    // This saves us from having to cleanup any state if the send fails. Queued
+    // calls are tracked right away so that the queue time counts towards the
+    // timeout of the call.
+    std::unique_ptr<wamp_dealer_invocation> dealer_invocation(
+            new wamp_dealer_invocation(m_io_service));
+
+    dealer_invocation->set_session(session);
+    dealer_invocation->set_request_id(call_message->get_request_id());
+    dealer_invocation->set_callee(callee);
+    dealer_invocation->set_receive_progress(receive_progress);
+    if (!coalesce_key.empty()) {
+        dealer_invocation->set_coalesce_key(coalesce_key);
+        m_coalesced_invocations[coalesce_key] = request_id;
     }
+    if (!cache_key.empty()) {
+        dealer_invocation->set_result_cache(result_cache, std::move(cache_key));
+    }
+    if (call_queue) {
+        dealer_invocation->set_call_queue(call_queue);
+    }
+    if (queued) {
+        dealer_invocation->set_queued_message(std::move(invocation_message));
+        ++m_call_queue_depth;
+    }
+    dealer_invocation->set_timeout(
+            std::bind(&wamp_dealer::invocation_timeout_handler, this,
+                    request_id, std::placeholders::_1), timeout_ms);
+
+    m_pending_invocations.insert(std::make_pair(request_id, std::move(dealer_invocation)));
+    m_pending_callee_invocations[callee->get_session_id()].insert(request_id);
+    m_pending_caller_invocations[session->get_session_id()].insert(request_id);
 }
 
-void wamp_dealer::process_error_message(const wamp_session_id& session_id,
-        const wamp_error_message* error_message)
+void wamp_dealer::process_cancel_message(const std::shared_ptr<wamp_session>& session,
+        const wamp_cancel_message* cancel_message)
 {
-    auto session_itr = m_sessions.find(session_id);
-    if (session_itr == m_sessions.end()) {
-        throw std::logic_error("dealer session does not exist");
+    BONEFISH_TRACE("%1%, %2%", *session % *cancel_message);
+
+    wamp_cancel_options options;
+    options.unmarshal(cancel_message->get_options());
+    const std::string mode = options.get_option_or<std::string>("mode", "killnowait");
+    if (mode != "skip" && mode != "kill" && mode != "killnowait") {
+        send_error(session->get_transport(), cancel_message->get_type(),
+                cancel_message->get_request_id(), "wamp.error.invalid_argument");
+        return;
     }
 
-    BONEFISH_TRACE("%1%, %2%", *session_itr->second % *error_message);
+    // The call may have completed or timed out before the cancel arrived
+    // in which case there is nothing left to cancel.
+    const wamp_request_id call_request_id = cancel_message->get_request_id();
+    if (cancel_parked_call(session, call_request_id)) {
+        send_error(session->get_transport(), wamp_message_type::CALL,
+                call_request_id, "wamp.error.canceled");
+        return;
+    }
+
+    auto pending_caller_invocations_itr =
+            m_pending_caller_invocations.find(session->get_session_id());
+    if (pending_caller_invocations_itr == m_pending_caller_invocations.end()) {
+        BONEFISH_TRACE("unable to find invocation ... completed or timed out");
+        return;
+    }
+
+    auto pending_invocations_itr = m_pending_invocations.end();
+    for (const auto& request_id : pending_caller_invocations_itr->second) {
+        auto itr = m_pending_invocations.find(request_id);
+        if (itr != m_pending_invocations.end() &&
+                itr->second->get_request_id() == call_request_id) {
+            pending_invocations_itr = itr;
+            break;
+        }
+    }
+
+    if (pending_invocations_itr == m_pending_invocations.end()) {
+        BONEFISH_TRACE("unable to find invocation ... completed or timed out");
+        return;
+    }
+
+    const wamp_request_id request_id = pending_invocations_itr->first;
+    std::unique_ptr<wamp_dealer_invocation>& dealer_invocation = pending_invocations_itr->second;
+    if (dealer_invocation->is_canceled()) {
+        return;
+    }
+
+    // An invocation that other calls have joined keeps running for them and
+    // only the canceling caller is answered.
+    std::shared_ptr<wamp_session> callee = dealer_invocation->get_callee();
+    if (callee && has_followers(*dealer_invocation)) {
+        pending_caller_invocations_itr->second.erase(request_id);
+        dealer_invocation->set_session(nullptr);
+        send_error(session->get_transport(), wamp_message_type::CALL,
+                call_request_id, "wamp.error.canceled");
+        return;
+    }
+
+    // Every callee that has not answered a fanout call yet is interrupted
+    // right away as there is no single answer to wait for.
+    if (dealer_invocation->get_fanout()) {
+        const std::vector<std::shared_ptr<wamp_session>> callees =
+                dealer_invocation->get_fanout()->get_pending_callees();
+        erase_pending_invocation(request_id);
+        if (mode != "skip") {
+            for (const auto& fanout_callee : callees) {
+                send_interrupt(fanout_callee, request_id, "killnowait");
+            }
+        }
+
+        send_error(session->get_transport(), wamp_message_type::CALL,
+                call_request_id, "wamp.error.canceled");
+        return;
+    }
+
+    // Queued calls have not reached their callee yet so there is nothing
+    // to interrupt.
+    if (dealer_invocation->is_queued()) {
+        callee.reset();
+    }
+
+    // Procedures inside of the router cannot be interrupted so their calls
+    // are always answered right away and any late completion is dropped.
+    if (callee && mode == "kill") {
+        // The caller receives whatever the callee responds with to the
+        // interrupt so the invocation stays pending until then. Identical
+        // calls no longer join it as it is unlikely to produce a result.
+        dealer_invocation->set_canceled(true);
+        erase_coalesced_invocation(request_id, *dealer_invocation);
+        send_interrupt(callee, request_id, mode);
+        return;
+    }
+
+    erase_pending_invocation(request_id);
+    if (callee && mode == "killnowait") {
+        send_interrupt(callee, request_id, mode);
+    }
+
+    send_error(session->get_transport(), wamp_message_type::CALL,
+            call_request_id, "wamp.error.canceled");
+}
+
+void wamp_dealer::process_error_message(const std::shared_ptr<wamp_session>& session,
+        const wamp_error_message* error_message)
+{
+    BONEFISH_TRACE("%1%, %2%", *session % *error_message);
 
     const auto request_id = error_message->get_request_id();
     auto pending_invocations_itr = m_pending_invocations.find(request_id);
@@ -247,74 +558,153 @@ void wamp_dealer::process_error_message(const wamp_session_id& session_id,
         return;
     }
 
+    // Request ids are easy to guess so only the callee that the call was
+    // invoked on may answer it. Fanout calls check their callees on their own.
     const auto& dealer_invocation = pending_invocations_itr->second;
+    if (!dealer_invocation->get_fanout() && (session != dealer_invocation->get_callee() ||
+            dealer_invocation->is_queued())) {
+        BONEFISH_TRACE("dropping error message: session is not the callee");
+        return;
+    }
 
-    std::unique_ptr<wamp_error_message> caller_error_message(new wamp_error_message);
-    caller_error_message->set_request_type(wamp_message_type::CALL);
-    caller_error_message->set_request_id(dealer_invocation->get_request_id());
-    caller_error_message->set_details(error_message->get_details());
-    caller_error_message->set_error(error_message->get_error());
-    caller_error_message->set_arguments(error_message->get_arguments());
-    caller_error_message->set_arguments_kw(error_message->get_arguments_kw());
-
-    BONEFISH_TRACE("%1%, %2%", *session_itr->second % *caller_error_message);
-    std::shared_ptr<wamp_session> session = dealer_invocation->get_session();
-    if (!session->get_transport()->send_message(std::move(*caller_error_message))) {
-        // There is no error message to propogate in this case as this error
-        // message was initiated by the callee and sending the callee an error
-        // message in response to an error message would not make any sense.
-        // Besides, the callers session has ended.
-        BONEFISH_TRACE("failed to send error message to caller: network failure");
+    wamp_dealer_fanout* fanout = dealer_invocation->get_fanout();
+    if (fanout) {
+        if (fanout->set_error(session->get_session_id(), error_message->get_error(),
+                error_message->get_arguments(), error_message->get_arguments_kw())) {
+            answer_fanout_invocation(session, request_id);
+        }
+        return;
     }
 
     // The failure to send a message in the event of a network failure
-    // will detach the session. When this happens the pending invocations
-    // will be cleaned up. So we don't use an iterator here to erase the
-    // pending invocation because it may have just been invalidated above.
-    m_pending_callee_invocations[session_id].erase(request_id);
-    m_pending_caller_invocations[session->get_session_id()].erase(request_id);
-    m_pending_invocations.erase(request_id);
+    // will detach the session which cleans up the pending invocations. So
+    // the invocation is taken out of the pending invocations up front.
+    pending_callers callers = take_callers(request_id);
+    for (const auto& caller : callers) {
+        std::unique_ptr<wamp_error_message> caller_error_message(new wamp_error_message);
+        caller_error_message->set_request_type(wamp_message_type::CALL);
+        caller_error_message->set_request_id(caller.second);
+        caller_error_message->set_details(error_message->get_details());
+        caller_error_message->set_error(error_message->get_error());
+        caller_error_message->set_arguments(error_message->get_arguments());
+        caller_error_message->set_arguments_kw(error_message->get_arguments_kw());
+
+        // There is no error message to propogate if sending fails as this
+        // error message was initiated by the callee and sending the callee an
+        // error message in response to an error message would not make any
+        // sense. Besides, the callers session has ended.
+        BONEFISH_TRACE("%1%, %2%", *caller.first % *caller_error_message);
+        if (!caller.first->get_transport()->send_message(std::move(*caller_error_message))) {
+            BONEFISH_TRACE("failed to send error message to caller: network failure");
+        }
+    }
 }
 
-void wamp_dealer::process_register_message(const wamp_session_id& session_id,
+void wamp_dealer::process_register_message(const std::shared_ptr<wamp_session>& session,
         const wamp_register_message* register_message)
 {
-    auto session_itr = m_sessions.find(session_id);
-    if (session_itr == m_sessions.end()) {
-        throw std::logic_error("dealer session does not exist");
-    }
-
-    BONEFISH_TRACE("%1%, %2%", *session_itr->second % *register_message);
+    BONEFISH_TRACE("%1%, %2%", *session % *register_message);
 
     // If the session registering the procedure does not support the callee
     // role than do not allow the call to be processed and send an error.
-    if (!session_itr->second->get_role(wamp_role_type::CALLEE)) {
-        send_error(session_itr->second->get_transport(), register_message->get_type(),
+    if (!session->has_role(wamp_role_type::CALLEE)) {
+        send_error(session->get_transport(), register_message->get_type(),
                 register_message->get_request_id(), "wamp.error.role_violation");
         return;
     }
 
-    const auto procedure = register_message->get_procedure();
-    if (!is_valid_uri(procedure)) {
-        send_error(session_itr->second->get_transport(), register_message->get_type(),
+    wamp_register_options options;
+    options.unmarshal(register_message->get_options());
+    const std::string match = options.get_option_or<std::string>("match", "exact");
+    if (match == "prefix") {
+        process_pattern_register_message(session, register_message, options,
+                wamp_match_policy::PREFIX);
+        return;
+    } else if (match == "wildcard") {
+        process_pattern_register_message(session, register_message, options,
+                wamp_match_policy::WILDCARD);
+        return;
+    } else if (match != "exact") {
+        send_error(session->get_transport(), register_message->get_type(),
+                register_message->get_request_id(), "wamp.error.invalid_argument");
+        return;
+    }
+
+    const auto procedure = register_message->get_procedure_ref();
+    if (!is_valid_uri(procedure.to_string())) {
+        send_error(session->get_transport(), register_message->get_type(),
                 register_message->get_request_id(), "wamp.error.invalid_uri");
         return;
     }
 
-    auto procedure_registrations_itr = m_procedure_registrations.find(procedure);
+    const std::string invoke = options.get_option_or<std::string>("invoke", "single");
+    wamp_invoke_policy invoke_policy = wamp_invoke_policy::SINGLE;
+    if (invoke == "first") {
+        invoke_policy = wamp_invoke_policy::FIRST;
+    } else if (invoke == "last") {
+        invoke_policy = wamp_invoke_policy::LAST;
+    } else if (invoke == "roundrobin") {
+        invoke_policy = wamp_invoke_policy::ROUNDROBIN;
+    } else if (invoke == "key") {
+        invoke_policy = wamp_invoke_policy::KEY;
+    } else if (invoke != "single") {
+        send_error(session->get_transport(), register_message->get_type(),
+                register_message->get_request_id(), "wamp.error.invalid_argument");
+        return;
+    }
+
+    // Callees of the key policy may give a node key that stays the same
+    // across reconnects so that they keep owning the same keys.
+    const std::string node_key = options.get_option_or<std::string>("node_key", "");
+
+    // Callees may share a registration as long as they all agree on how the
+    // calls are distributed between them. The options of the first callee
+    // apply to the shared registration.
+    auto procedure_registrations_itr =
+            m_procedure_registrations.find(m_uri_table.find(procedure));
     if (procedure_registrations_itr != m_procedure_registrations.end()) {
-        send_error(session_itr->second->get_transport(), register_message->get_type(),
-                register_message->get_request_id(), "wamp.error.procedure_already_exists");
+        const auto& dealer_registration = procedure_registrations_itr->second;
+        const auto& sessions = dealer_registration->get_sessions();
+        if (invoke_policy == wamp_invoke_policy::SINGLE || dealer_registration->is_native() ||
+                dealer_registration->get_invoke_policy() != invoke_policy ||
+                std::find(sessions.begin(), sessions.end(), session) != sessions.end() ||
+                (!node_key.empty() && dealer_registration->has_node_key(node_key))) {
+            send_error(session->get_transport(), register_message->get_type(),
+                    register_message->get_request_id(), "wamp.error.procedure_already_exists");
+            return;
+        }
+
+        dealer_registration->add_session(session, node_key);
+        m_session_registrations[session->get_session_id()].insert(
+                dealer_registration->get_registration_id());
+
+        std::unique_ptr<wamp_registered_message> registered_message(new wamp_registered_message);
+        registered_message->set_request_id(register_message->get_request_id());
+        registered_message->set_registration_id(dealer_registration->get_registration_id());
+
+        BONEFISH_TRACE("%1%, %2%", *session % *registered_message);
+        if (!session->get_transport()->send_message(std::move(*registered_message))) {
+            BONEFISH_TRACE("failed to send registered message to caller: network failure");
+        }
+
+        dispatch_parked_calls();
         return;
     }
 
+    // Each registration holds a reference to its interned procedure which
+    // is released when the procedure is unregistered.
+    const wamp_uri_id procedure_id = m_uri_table.acquire(procedure);
     const wamp_registration_id registration_id = m_registration_id_generator.generate();
     std::unique_ptr<wamp_dealer_registration> dealer_registration(
-            new wamp_dealer_registration(session_itr->second, registration_id));
-    m_procedure_registrations[procedure] = std::move(dealer_registration);
+            new wamp_dealer_registration(session, registration_id, node_key));
+    dealer_registration->set_invoke_policy(invoke_policy);
+    dealer_registration->set_result_cache(create_result_cache(options));
+    dealer_registration->set_coalescing(options.get_option_or<bool>("coalesce", false));
+    dealer_registration->set_call_queue(create_call_queue(options));
+    m_procedure_registrations[procedure_id] = std::move(dealer_registration);
 
-    m_session_registrations[session_id].insert(registration_id);
-    m_registered_procedures[registration_id] = procedure;
+    m_session_registrations[session->get_session_id()].insert(registration_id);
+    m_registered_procedures[registration_id] = procedure_id;
 
     std::unique_ptr<wamp_registered_message> registered_message(new wamp_registered_message);
     registered_message->set_request_id(register_message->get_request_id());
@@ -324,25 +714,131 @@ void wamp_dealer::process_register_message(const wamp_session_id& session_id,
     // the underlying network connection has been closed/lost which means
     // that the callee is no longer reachable on this session. So all we
     // do here is trace the fact that this event occured.
-    BONEFISH_TRACE("%1%, %2%", *session_itr->second % *registered_message);
-    if (!session_itr->second->get_transport()->send_message(std::move(*registered_message))) {
+    BONEFISH_TRACE("%1%, %2%", *session % *registered_message);
+    if (!session->get_transport()->send_message(std::move(*registered_message))) {
         BONEFISH_TRACE("failed to send registered message to caller: network failure");
     }
+
+    // Calls that were waiting for the procedure are invoked once the callee
+    // knows about its registration.
+    dispatch_parked_calls();
 }
 
-void wamp_dealer::process_unregister_message(const wamp_session_id& session_id,
-        const wamp_unregister_message* unregister_message)
+void wamp_dealer::process_pattern_register_message(const std::shared_ptr<wamp_session>& session,
+        const wamp_register_message* register_message, const wamp_register_options& options,
+        wamp_match_policy policy)
 {
-    auto session_itr = m_sessions.find(session_id);
-    if (session_itr == m_sessions.end()) {
-        throw std::logic_error("dealer session does not exist");
+    // Patterns may contain empty components. Wildcard patterns use them to
+    // match any component and prefix patterns may end with a separator.
+    const std::string pattern = register_message->get_procedure();
+    if (!is_valid_uri(pattern, uri_flags::allow_empty_components)) {
+        send_error(session->get_transport(), register_message->get_type(),
+                register_message->get_request_id(), "wamp.error.invalid_uri");
+        return;
+    }
+
+    const wamp_registration_id registration_id = m_registration_id_generator.generate();
+    std::unique_ptr<wamp_dealer_registration> dealer_registration(
+            new wamp_dealer_registration(session, registration_id));
+    dealer_registration->set_pattern(policy, pattern);
+    dealer_registration->set_result_cache(create_result_cache(options));
+    dealer_registration->set_coalescing(options.get_option_or<bool>("coalesce", false));
+    dealer_registration->set_call_queue(create_call_queue(options));
+
+    if (!m_procedure_patterns.insert(policy, pattern, dealer_registration.get())) {
+        send_error(session->get_transport(), register_message->get_type(),
+                register_message->get_request_id(), "wamp.error.procedure_already_exists");
+        return;
     }
 
-    BONEFISH_TRACE("%1%, %2%", *session_itr->second % *unregister_message);
+    m_pattern_registrations[registration_id] = std::move(dealer_registration);
+    m_session_registrations[session->get_session_id()].insert(registration_id);
 
-    auto session_registrations_itr = m_session_registrations.find(session_id);
+    std::unique_ptr<wamp_registered_message> registered_message(new wamp_registered_message);
+    registered_message->set_request_id(register_message->get_request_id());
+    registered_message->set_registration_id(registration_id);
+
+    BONEFISH_TRACE("%1%, %2%", *session % *registered_message);
+    if (!session->get_transport()->send_message(std::move(*registered_message))) {
+        BONEFISH_TRACE("failed to send registered message to caller: network failure");
+    }
+
+    // Calls that were waiting for the procedure are invoked once the callee
+    // knows about its registration.
+    dispatch_parked_calls();
+}
+
+std::shared_ptr<wamp_dealer_result_cache> wamp_dealer::create_result_cache(
+        const wamp_register_options& options) const
+{
+    // Procedures are only cacheable if the callee says so by giving their
+    // results a time to live.
+    const unsigned ttl_ms = options.get_option_or<unsigned>("cache_ttl", 0);
+    if (!ttl_ms) {
+        return nullptr;
+    }
+
+    const size_t default_max_size = wamp_dealer_result_cache::DEFAULT_MAX_SIZE;
+    const size_t max_size = options.get_option_or<size_t>("cache_max_size", default_max_size);
+    return std::make_shared<wamp_dealer_result_cache>(ttl_ms, max_size);
+}
+
+std::string wamp_dealer::create_routing_key(const wamp_call_options& options,
+        const msgpack::object& arguments) const
+{
+    msgpack::object key = options.get_option_or<msgpack::object>("key", msgpack::object());
+    if (key.type == msgpack::type::NIL && arguments.type == msgpack::type::ARRAY &&
+            arguments.via.array.size) {
+        key = arguments.via.array.ptr[0];
+    }
+
+    // Keys are compared in their serialized form so that keys of any type
+    // can be used.
+    msgpack::sbuffer buffer;
+    msgpack::pack(buffer, key);
+    return std::string(buffer.data(), buffer.size());
+}
+
+std::shared_ptr<wamp_dealer_call_queue> wamp_dealer::create_call_queue(
+        const wamp_register_options& options) const
+{
+    // Registrations without a concurrency limit are invoked right away.
+    const size_t concurrency = options.get_option_or<size_t>("concurrency", 0);
+    if (!concurrency) {
+        return nullptr;
+    }
+
+    const size_t default_max_size = wamp_dealer_call_queue::DEFAULT_MAX_SIZE;
+    const size_t max_size = options.get_option_or<size_t>("queue_max_size", default_max_size);
+    return std::make_shared<wamp_dealer_call_queue>(concurrency, max_size);
+}
+
+bool wamp_dealer::erase_pattern_registration(const wamp_registration_id& registration_id)
+{
+    auto pattern_registrations_itr = m_pattern_registrations.find(registration_id);
+    if (pattern_registrations_itr == m_pattern_registrations.end()) {
+        return false;
+    }
+
+    const auto& dealer_registration = pattern_registrations_itr->second;
+    BONEFISH_TRACE("removing pattern registration: %1%", dealer_registration->get_pattern());
+    if (!m_procedure_patterns.erase(dealer_registration->get_match_policy(),
+            dealer_registration->get_pattern())) {
+        throw std::logic_error("dealer procedure patterns out of sync");
+    }
+
+    m_pattern_registrations.erase(pattern_registrations_itr);
+    return true;
+}
+
+void wamp_dealer::process_unregister_message(const std::shared_ptr<wamp_session>& session,
+        const wamp_unregister_message* unregister_message)
+{
+    BONEFISH_TRACE("%1%, %2%", *session % *unregister_message);
+
+    auto session_registrations_itr = m_session_registrations.find(session->get_session_id());
     if (session_registrations_itr == m_session_registrations.end()) {
-        send_error(session_itr->second->get_transport(), unregister_message->get_type(),
+        send_error(session->get_transport(), unregister_message->get_type(),
                 unregister_message->get_request_id(), "wamp.error.no_such_registration");
         return;
     }
@@ -351,31 +847,39 @@ void wamp_dealer::process_unregister_message(const wamp_session_id& session_id,
     auto registrations_itr = registrations.find(unregister_message->get_registration_id());
     if (registrations_itr == registrations.end()) {
         BONEFISH_TRACE("error: dealer session registration id does not exist");
-        send_error(session_itr->second->get_transport(), unregister_message->get_type(),
+        send_error(session->get_transport(), unregister_message->get_type(),
                 unregister_message->get_request_id(), "wamp.error.no_such_registration");
         return;
     }
 
-    auto registered_procedures_itr =
-            m_registered_procedures.find(*registrations_itr);
-    if (registered_procedures_itr == m_registered_procedures.end()) {
-        BONEFISH_TRACE("error: dealer registered procedures out of sync");
-        send_error(session_itr->second->get_transport(), unregister_message->get_type(),
-                unregister_message->get_request_id(), "wamp.error.no_such_registration");
-        return;
-    }
+    if (!erase_pattern_registration(*registrations_itr)) {
+        auto registered_procedures_itr =
+                m_registered_procedures.find(*registrations_itr);
+        if (registered_procedures_itr == m_registered_procedures.end()) {
+            BONEFISH_TRACE("error: dealer registered procedures out of sync");
+            send_error(session->get_transport(), unregister_message->get_type(),
+                    unregister_message->get_request_id(), "wamp.error.no_such_registration");
+            return;
+        }
 
-    auto procedure_registrations_itr =
-            m_procedure_registrations.find(registered_procedures_itr->second);
-    if (procedure_registrations_itr == m_procedure_registrations.end()) {
-        BONEFISH_TRACE("error: dealer procedure registrations out of sync");
-        send_error(session_itr->second->get_transport(), unregister_message->get_type(),
-                unregister_message->get_request_id(), "wamp.error.no_such_registration");
-        return;
-    }
+        auto procedure_registrations_itr =
+                m_procedure_registrations.find(registered_procedures_itr->second);
+        if (procedure_registrations_itr == m_procedure_registrations.end()) {
+            BONEFISH_TRACE("error: dealer procedure registrations out of sync");
+            send_error(session->get_transport(), unregister_message->get_type(),
+                    unregister_message->get_request_id(), "wamp.error.no_such_registration");
+            return;
+        }
 
-    m_procedure_registrations.erase(procedure_registrations_itr);
-    m_registered_procedures.erase(registered_procedures_itr);
+        // Shared registrations remain as long as they have callees left.
+        const auto& dealer_registration = procedure_registrations_itr->second;
+        if (!dealer_registration->remove_session(session) ||
+                dealer_registration->get_sessions().empty()) {
+            m_uri_table.release(procedure_registrations_itr->first);
+            m_procedure_registrations.erase(procedure_registrations_itr);
+            m_registered_procedures.erase(registered_procedures_itr);
+        }
+    }
     registrations.erase(registrations_itr);
 
     std::unique_ptr<wamp_unregistered_message> unregistered_message(new wamp_unregistered_message);
@@ -385,24 +889,19 @@ void wamp_dealer::process_unregister_message(const wamp_session_id& session_id,
     // the underlying network connection has been closed/lost which means
     // that the callee is no longer reachable on this session. So all we
     // do here is trace the fact that this event occured.
-    BONEFISH_TRACE("%1%, %2%", *session_itr->second % *unregistered_message);
-    if (!session_itr->second->get_transport()->send_message(std::move(*unregistered_message))) {
+    BONEFISH_TRACE("%1%, %2%", *session % *unregistered_message);
+    if (!session->get_transport()->send_message(std::move(*unregistered_message))) {
         BONEFISH_TRACE("failed to send unregistered message to caller: network failure");
     }
 }
 
-void wamp_dealer::process_yield_message(const wamp_session_id& session_id,
+void wamp_dealer::process_yield_message(const std::shared_ptr<wamp_session>& session,
         const wamp_yield_message* yield_message)
 {
-    auto session_itr = m_sessions.find(session_id);
-    if (session_itr == m_sessions.end()) {
-        throw std::logic_error("dealer session does not exist");
-    }
-
     // It is considered to be a normal condition if we cannot find the
     // associated invocation. Typically this occurs if the invocation
     // timed out or if the callers session has ended.
-    BONEFISH_TRACE("%1%, %2%", *session_itr->second % *yield_message);
+    BONEFISH_TRACE("%1%, %2%", *session % *yield_message);
     const auto request_id = yield_message->get_request_id();
     auto pending_invocations_itr = m_pending_invocations.find(request_id);
     if (pending_invocations_itr == m_pending_invocations.end()) {
@@ -410,50 +909,292 @@ void wamp_dealer::process_yield_message(const wamp_session_id& session_id,
         return;
     }
 
+    // Request ids are easy to guess so only the callee that the call was
+    // invoked on may answer it. Fanout calls check their callees on their own.
     const auto& dealer_invocation = pending_invocations_itr->second;
-    std::shared_ptr<wamp_session> session = dealer_invocation->get_session();
+    if (!dealer_invocation->get_fanout() && (session != dealer_invocation->get_callee() ||
+            dealer_invocation->is_queued())) {
+        BONEFISH_TRACE("dropping yield message: session is not the callee");
+        return;
+    }
 
-    // We can't have a pending invocation without a pending caller/callee
-    // as they are tracked in a synchronized manner. So to have one without
-    // the other is considered to be an error.
-    auto pending_callee_invocations_itr =
-            m_pending_callee_invocations.find(session_itr->second->get_session_id());
-    if (pending_callee_invocations_itr == m_pending_callee_invocations.end()) {
-        throw std::logic_error("dealer pending callee invocations out of sync");
+    wamp_yield_options options;
+    options.unmarshal(yield_message->get_options());
+    if (options.get_option_or<bool>("progress", false)) {
+        process_progressive_yield_message(session, yield_message, *dealer_invocation);
+        return;
     }
-    pending_callee_invocations_itr->second.erase(request_id);
 
-    auto pending_caller_invocations_itr =
-            m_pending_caller_invocations.find(session->get_session_id());
-    if (pending_caller_invocations_itr == m_pending_caller_invocations.end()) {
-        throw std::logic_error("dealer pending caller invocations out of sync");
+    wamp_dealer_fanout* fanout = dealer_invocation->get_fanout();
+    if (fanout) {
+        if (fanout->set_result(session->get_session_id(), yield_message->get_arguments(),
+                yield_message->get_arguments_kw())) {
+            answer_fanout_invocation(session, request_id);
+        }
+        return;
     }
-    pending_caller_invocations_itr->second.erase(request_id);
+
+    std::shared_ptr<wamp_dealer_result_cache> result_cache = dealer_invocation->get_result_cache();
+    if (result_cache) {
+        m_cache_stats.add_evictions(result_cache->insert(dealer_invocation->get_cache_key(),
+                yield_message->get_arguments(), yield_message->get_arguments_kw()));
+    }
+
+    // The failure to send a message in the event of a network failure
+    // will detach the session which cleans up the pending invocations. So
+    // the invocation is taken out of the pending invocations up front.
+    pending_callers callers = take_callers(request_id);
+    for (const auto& caller : callers) {
+        std::unique_ptr<wamp_result_message> result_message(new wamp_result_message);
+        result_message->set_request_id(caller.second);
+        result_message->set_arguments(yield_message->get_arguments());
+        result_message->set_arguments_kw(yield_message->get_arguments_kw());
+
+        // If we fail to send the result message it is most likely that the
+        // underlying network connection has been closed/lost which means
+        // that the caller is no longer reachable on this session. So all
+        // we do here is trace the fact that this event occured.
+        BONEFISH_TRACE("%1%, %2%", *caller.first % *result_message);
+        if (!caller.first->get_transport()->send_message(std::move(*result_message))) {
+            BONEFISH_TRACE("failed to send result message to caller: network failure");
+        }
+    }
+}
+
+void wamp_dealer::process_progressive_yield_message(const std::shared_ptr<wamp_session>& session,
+        const wamp_yield_message* yield_message,
+        const wamp_dealer_invocation& dealer_invocation)
+{
+    // A callee that yields progressive results to a caller that did not ask
+    // for them is violating the protocol. The chunk is dropped rather than
+    // delivering a partial result as if it were the final one.
+    if (!dealer_invocation.get_receive_progress()) {
+        BONEFISH_TRACE("dropping progressive result: caller did not request progress");
+        return;
+    }
+
+    // Each chunk is forwarded as soon as it arrives and the invocation stays
+    // pending until the final yield. Nothing is buffered in the dealer.
+    msgpack::zone zone;
+    std::map<std::string, bool> details { { "progress", true } };
 
     std::unique_ptr<wamp_result_message> result_message(new wamp_result_message);
-    result_message->set_request_id(dealer_invocation->get_request_id());
+    result_message->set_request_id(dealer_invocation.get_request_id());
+    result_message->set_details(msgpack::object(details, zone));
     result_message->set_arguments(yield_message->get_arguments());
     result_message->set_arguments_kw(yield_message->get_arguments_kw());
 
-    // If we fail to send the result message it is most likely that the
-    // underlying network connection has been closed/lost which means
-    // that the caller is no longer reachable on this session. So all
-    // we do here is trace the fact that this event occured.
-    BONEFISH_TRACE("%1%, %2%", *session_itr->second % *result_message);
-    if (!session->get_transport()->send_message(std::move(*result_message))) {
-        BONEFISH_TRACE("failed to send result message to caller: network failure");
+    BONEFISH_TRACE("%1%, %2%", *session % *result_message);
+    if (!dealer_invocation.get_session()->get_transport()->send_message(std::move(*result_message))) {
+        BONEFISH_TRACE("failed to send progressive result message to caller: network failure");
     }
+}
 
-    // The failure to send a message in the event of a network failure
-    // will detach the session. When this happens the pending invocations
-    // be cleaned up. So we don't use an iterator here to erase the pending
-    // invocation because it may have just been invalidated above.
-    m_pending_callee_invocations[session_id].erase(request_id);
-    m_pending_caller_invocations[session->get_session_id()].erase(request_id);
-    m_pending_invocations.erase(request_id);
+const wamp_dealer_cache_stats& wamp_dealer::get_cache_stats() const
+{
+    return m_cache_stats;
+}
+
+size_t wamp_dealer::get_call_queue_depth() const
+{
+    return m_call_queue_depth;
+}
+
+void wamp_dealer::set_registration_grace_period(unsigned grace_period_ms)
+{
+    m_registration_grace_period_ms = grace_period_ms;
+}
+
+wamp_registration_id wamp_dealer::register_procedure(const std::string& procedure,
+        const wamp_procedure& handler)
+{
+    std::unique_ptr<wamp_dealer_registration> registration(
+            new wamp_dealer_registration(handler, m_registration_id_generator.generate()));
+    return add_native_registration(procedure, std::move(registration));
+}
+
+wamp_registration_id wamp_dealer::register_async_procedure(const std::string& procedure,
+        const wamp_async_procedure& handler)
+{
+    std::unique_ptr<wamp_dealer_registration> registration(
+            new wamp_dealer_registration(handler, m_registration_id_generator.generate()));
+    return add_native_registration(procedure, std::move(registration));
+}
+
+bool wamp_dealer::unregister_procedure(const wamp_registration_id& registration_id)
+{
+    auto registered_procedures_itr = m_registered_procedures.find(registration_id);
+    if (registered_procedures_itr == m_registered_procedures.end()) {
+        return false;
+    }
+
+    auto procedure_registrations_itr =
+            m_procedure_registrations.find(registered_procedures_itr->second);
+    if (procedure_registrations_itr == m_procedure_registrations.end()) {
+        throw std::logic_error("dealer procedure registrations out of sync");
+    }
+
+    // Registrations made by sessions can only be removed by their session.
+    if (!procedure_registrations_itr->second->is_native()) {
+        return false;
+    }
+
+    BONEFISH_TRACE("removing native registration: procedure %1%",
+            m_uri_table.get_uri(procedure_registrations_itr->first));
+
+    m_uri_table.release(procedure_registrations_itr->first);
+    m_procedure_registrations.erase(procedure_registrations_itr);
+    m_registered_procedures.erase(registered_procedures_itr);
+    return true;
+}
+
+wamp_registration_id wamp_dealer::add_native_registration(const std::string& procedure,
+        std::unique_ptr<wamp_dealer_registration>&& registration)
+{
+    if (!is_valid_uri(procedure)) {
+        throw std::invalid_argument("invalid procedure uri");
+    }
+
+    if (m_procedure_registrations.count(m_uri_table.find(procedure))) {
+        throw std::invalid_argument("procedure already exists");
+    }
+
+    BONEFISH_TRACE("adding native registration: procedure %1%", procedure);
+
+    const wamp_uri_id procedure_id = m_uri_table.acquire(procedure);
+    const wamp_registration_id registration_id = registration->get_registration_id();
+    m_procedure_registrations[procedure_id] = std::move(registration);
+    m_registered_procedures[registration_id] = procedure_id;
+
+    // Procedures may be registered while a message is being processed so
+    // the calls that were waiting for the procedure are invoked afterwards.
+    if (!m_parked_calls.empty()) {
+        std::weak_ptr<wamp_dealer*> weak_dealer = m_lifetime;
+        m_io_service.post([weak_dealer]() {
+            auto dealer = weak_dealer.lock();
+            if (dealer) {
+                (*dealer)->dispatch_parked_calls();
+            }
+        });
+    }
+
+    return registration_id;
+}
+
+void wamp_dealer::call_native_procedure(const std::shared_ptr<wamp_session>& session,
+        const wamp_call_message* call_message,
+        const wamp_dealer_registration& registration,
+        const wamp_dealer_parked_call* parked_call)
+{
+    const wamp_procedure_call call(call_message->get_procedure_ref(),
+            call_message->get_arguments(), call_message->get_arguments_kw());
+
+    // Synchronous procedures are answered right away without tracking any
+    // state for the call.
+    if (registration.get_procedure()) {
+        wamp_procedure_result result;
+        try {
+            registration.get_procedure()(call, result);
+        } catch (const std::exception& e) {
+            BONEFISH_TRACE("native procedure failed: %1%", e.what());
+            result.set_error("wamp.error.runtime_error");
+        }
+
+        send_procedure_result(session->get_transport(), call_message->get_request_id(), result);
+        return;
+    }
+
+    // Asynchronous procedures are tracked like invocations of a callee so
+    // that they time out and are cleaned up along with the caller's session.
+    wamp_call_options options;
+    options.unmarshal(call_message->get_options());
+    unsigned timeout_ms = parked_call ? parked_call->get_remaining_ms()
+            : options.get_option_or<unsigned>("timeout", 0);
+
+    const wamp_request_id request_id = m_request_id_generator.generate();
+    std::unique_ptr<wamp_dealer_invocation> dealer_invocation(
+            new wamp_dealer_invocation(m_io_service));
+    dealer_invocation->set_session(session);
+    dealer_invocation->set_request_id(call_message->get_request_id());
+    dealer_invocation->set_timeout(
+            std::bind(&wamp_dealer::invocation_timeout_handler, this,
+                    request_id, std::placeholders::_1), timeout_ms);
+
+    m_pending_invocations.insert(std::make_pair(request_id, std::move(dealer_invocation)));
+    m_pending_caller_invocations[session->get_session_id()].insert(request_id);
+
+    std::weak_ptr<wamp_dealer*> weak_dealer = m_lifetime;
+    wamp_procedure_completion completion =
+            [weak_dealer, request_id](const wamp_procedure_result& result) {
+        auto dealer = weak_dealer.lock();
+        if (dealer) {
+            (*dealer)->complete_native_procedure(request_id, result);
+        }
+    };
+
+    try {
+        registration.get_async_procedure()(call, completion);
+    } catch (const std::exception& e) {
+        BONEFISH_TRACE("native procedure failed: %1%", e.what());
+        wamp_procedure_result result;
+        result.set_error("wamp.error.runtime_error");
+        complete_native_procedure(request_id, result);
+    }
 }
 
-void wamp_dealer::send_error(const std::unique_ptr<wamp_transport>& transport,
+void wamp_dealer::complete_native_procedure(const wamp_request_id& request_id,
+        const wamp_procedure_result& result)
+{
+    auto pending_invocations_itr = m_pending_invocations.find(request_id);
+    if (pending_invocations_itr == m_pending_invocations.end()) {
+        BONEFISH_TRACE("unable to find invocation ... timed out or session closed");
+        return;
+    }
+
+    std::unique_ptr<wamp_dealer_invocation> dealer_invocation =
+            std::move(pending_invocations_itr->second);
+    m_pending_invocations.erase(pending_invocations_itr);
+
+    std::shared_ptr<wamp_session> caller = dealer_invocation->get_session();
+    auto pending_caller_invocations_itr =
+            m_pending_caller_invocations.find(caller->get_session_id());
+    if (pending_caller_invocations_itr != m_pending_caller_invocations.end()) {
+        pending_caller_invocations_itr->second.erase(request_id);
+    }
+
+    send_procedure_result(caller->get_transport(), dealer_invocation->get_request_id(), result);
+}
+
+void wamp_dealer::send_procedure_result(const std::shared_ptr<wamp_transport>& transport,
+        const wamp_request_id& request_id, const wamp_procedure_result& result) const
+{
+    if (result.is_error()) {
+        std::unique_ptr<wamp_error_message> error_message(new wamp_error_message);
+        error_message->set_request_type(wamp_message_type::CALL);
+        error_message->set_request_id(request_id);
+        error_message->set_error(result.get_error());
+        error_message->set_arguments(result.get_arguments());
+        error_message->set_arguments_kw(result.get_arguments_kw());
+
+        BONEFISH_TRACE("%1%", *error_message);
+        if (!transport->send_message(std::move(*error_message))) {
+            BONEFISH_TRACE("failed to send error message to caller: network failure");
+        }
+        return;
+    }
+
+    std::unique_ptr<wamp_result_message> result_message(new wamp_result_message);
+    result_message->set_request_id(request_id);
+    result_message->set_arguments(result.get_arguments());
+    result_message->set_arguments_kw(result.get_arguments_kw());
+
+    BONEFISH_TRACE("%1%", *result_message);
+    if (!transport->send_message(std::move(*result_message))) {
+        BONEFISH_TRACE("failed to send result message to caller: network failure");
+    }
+}
+
+void wamp_dealer::send_error(const std::shared_ptr<wamp_transport>& transport,
             const wamp_message_type request_type, const wamp_request_id& request_id,
             const std::string& error) const
 {
@@ -482,29 +1223,518 @@ void wamp_dealer::invocation_timeout_handler(const wamp_request_id& request_id,
     }
 
     BONEFISH_TRACE("timing out a pending invocation");
-    const auto& call_request_id = pending_invocations_itr->second->get_request_id();
-    std::shared_ptr<wamp_session> session = pending_invocations_itr->second->get_session();
 
-    send_error(session->get_transport(), wamp_message_type::CALL,
-            call_request_id, "wamp.error.call_timed_out");
+    // Fanout calls are answered with whatever the callees have answered so
+    // far and the callees that have not answered yet are interrupted.
+    if (pending_invocations_itr->second->get_fanout()) {
+        const std::vector<std::shared_ptr<wamp_session>> callees =
+                pending_invocations_itr->second->get_fanout()->get_pending_callees();
+        complete_fanout_invocation(request_id);
+        for (const auto& callee : callees) {
+            send_interrupt(callee, request_id, "killnowait");
+        }
+        return;
+    }
 
+    std::shared_ptr<wamp_session> callee = pending_invocations_itr->second->get_callee();
+    const bool interrupt = !pending_invocations_itr->second->is_canceled() &&
+            !pending_invocations_itr->second->is_queued();
+
+    // The failure to send a message in the event of a network failure
+    // will detach the session which cleans up the pending invocations. So
+    // the invocation is taken out of the pending invocations up front.
+    pending_callers callers = take_callers(request_id);
+
+    // Free up the callee unless it has already been interrupted by a cancel
+    // or the call never left the call queue.
+    if (callee && interrupt) {
+        send_interrupt(callee, request_id, "killnowait");
+    }
+
+    for (const auto& caller : callers) {
+        send_error(caller.first->get_transport(), wamp_message_type::CALL,
+                caller.second, "wamp.error.call_timed_out");
+    }
+}
+
+void wamp_dealer::send_interrupt(const std::shared_ptr<wamp_session>& callee,
+        const wamp_request_id& request_id, const std::string& mode) const
+{
+    msgpack::zone zone;
+    std::map<std::string, std::string> options { { "mode", mode } };
+
+    std::unique_ptr<wamp_interrupt_message> interrupt_message(new wamp_interrupt_message);
+    interrupt_message->set_request_id(request_id);
+    interrupt_message->set_options(msgpack::object(options, zone));
+
+    BONEFISH_TRACE("%1%, %2%", *callee % *interrupt_message);
+    if (!callee->get_transport()->send_message(std::move(*interrupt_message))) {
+        BONEFISH_TRACE("failed to send interrupt message to callee: network failure");
+    }
+}
+
+void wamp_dealer::erase_pending_invocation(const wamp_request_id& request_id)
+{
+    auto pending_invocations_itr = m_pending_invocations.find(request_id);
+    if (pending_invocations_itr == m_pending_invocations.end()) {
+        return;
+    }
+
+    const auto& dealer_invocation = pending_invocations_itr->second;
+    if (dealer_invocation->get_callee()) {
+        erase_callee_invocation(dealer_invocation->get_callee(), request_id);
+    }
+
+    if (dealer_invocation->get_fanout()) {
+        for (const auto& callee : dealer_invocation->get_fanout()->get_pending_callees()) {
+            erase_callee_invocation(callee, request_id);
+        }
+    }
+
+    if (dealer_invocation->get_session()) {
+        auto pending_caller_invocations_itr =
+                m_pending_caller_invocations.find(dealer_invocation->get_session()->get_session_id());
+        if (pending_caller_invocations_itr != m_pending_caller_invocations.end()) {
+            pending_caller_invocations_itr->second.erase(request_id);
+        }
+    }
+
+    erase_coalesced_invocation(request_id, *dealer_invocation);
+    release_call_queue(request_id, *dealer_invocation);
+    m_pending_invocations.erase(pending_invocations_itr);
+}
+
+void wamp_dealer::erase_callee_invocation(const std::shared_ptr<wamp_session>& callee,
+        const wamp_request_id& request_id)
+{
     auto pending_callee_invocations_itr =
-            m_pending_callee_invocations.find(session->get_session_id());
+            m_pending_callee_invocations.find(callee->get_session_id());
     if (pending_callee_invocations_itr != m_pending_callee_invocations.end()) {
         pending_callee_invocations_itr->second.erase(request_id);
     }
+}
 
-    auto pending_caller_invocations_itr =
-            m_pending_caller_invocations.find(session->get_session_id());
-    if (pending_caller_invocations_itr != m_pending_caller_invocations.end()) {
-        pending_caller_invocations_itr->second.erase(request_id);
+void wamp_dealer::erase_coalesced_invocation(const wamp_request_id& request_id,
+        const wamp_dealer_invocation& dealer_invocation)
+{
+    // Only the invocation that identical calls currently join owns the key.
+    const std::string& coalesce_key = dealer_invocation.get_coalesce_key();
+    if (coalesce_key.empty()) {
+        return;
     }
 
-    // The failure to send a message in the event of a network failure
-    // will detach the session. When this happens the pending invocations
-    // be cleaned up. So we don't use an iterator here to erase the pending
-    // invocation because it may have just been invalidated above.
-    m_pending_invocations.erase(request_id);
+    auto coalesced_invocations_itr = m_coalesced_invocations.find(coalesce_key);
+    if (coalesced_invocations_itr != m_coalesced_invocations.end() &&
+            coalesced_invocations_itr->second == request_id) {
+        m_coalesced_invocations.erase(coalesced_invocations_itr);
+    }
+}
+
+bool wamp_dealer::join_pending_invocation(const std::shared_ptr<wamp_session>& session,
+        const wamp_call_message* call_message, const wamp_request_id& request_id,
+        const wamp_request_id& leader_request_id, unsigned timeout_ms)
+{
+    auto leader_itr = m_pending_invocations.find(leader_request_id);
+    if (leader_itr == m_pending_invocations.end()) {
+        throw std::logic_error("dealer coalesced invocations out of sync");
+    }
+
+    // An invocation whose deadline has passed is about to time out so the
+    // call starts a new invocation instead.
+    const wamp_dealer_invocation& leader = *leader_itr->second;
+    if (leader.is_expired()) {
+        erase_coalesced_invocation(leader_request_id, leader);
+        return false;
+    }
+
+    // Timing out the invocation times out every call that joined it even if
+    // the caller that started it has canceled or left in the meantime. So a
+    // call only joins if it would time out no later than the invocation does.
+    // Otherwise it starts a new invocation that later calls join instead.
+    if (leader.has_deadline() && (!timeout_ms || timeout_ms > leader.get_remaining_ms())) {
+        return false;
+    }
+
+    // The joining call is tracked like any other pending call so that it
+    // times out, can be canceled and is cleaned up with its caller on its
+    // own. It just never invokes the callee.
+    std::unique_ptr<wamp_dealer_invocation> dealer_invocation(
+            new wamp_dealer_invocation(m_io_service));
+    dealer_invocation->set_session(session);
+    dealer_invocation->set_request_id(call_message->get_request_id());
+    dealer_invocation->set_timeout(
+            std::bind(&wamp_dealer::invocation_timeout_handler, this,
+                    request_id, std::placeholders::_1), timeout_ms);
+
+    BONEFISH_TRACE("joining pending invocation: request_id %1%", leader_request_id);
+    leader_itr->second->add_follower(request_id);
+    m_pending_invocations.insert(std::make_pair(request_id, std::move(dealer_invocation)));
+    m_pending_caller_invocations[session->get_session_id()].insert(request_id);
+    return true;
+}
+
+bool wamp_dealer::has_followers(const wamp_dealer_invocation& dealer_invocation) const
+{
+    for (const auto& request_id : dealer_invocation.get_followers()) {
+        if (m_pending_invocations.count(request_id)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+wamp_dealer::pending_callers wamp_dealer::take_callers(const wamp_request_id& request_id)
+{
+    pending_callers callers;
+
+    auto pending_invocations_itr = m_pending_invocations.find(request_id);
+    if (pending_invocations_itr == m_pending_invocations.end()) {
+        return callers;
+    }
+
+    // The caller of an invocation that other calls have joined may have
+    // left in which case only the joined calls are answered.
+    const auto& dealer_invocation = pending_invocations_itr->second;
+    if (dealer_invocation->get_session()) {
+        callers.push_back(std::make_pair(dealer_invocation->get_session(),
+                dealer_invocation->get_request_id()));
+    }
+
+    for (const auto& follower_request_id : dealer_invocation->get_followers()) {
+        auto followers_itr = m_pending_invocations.find(follower_request_id);
+        if (followers_itr != m_pending_invocations.end()) {
+            callers.push_back(std::make_pair(followers_itr->second->get_session(),
+                    followers_itr->second->get_request_id()));
+            erase_pending_invocation(follower_request_id);
+        }
+    }
+
+    erase_pending_invocation(request_id);
+    return callers;
+}
+
+void wamp_dealer::release_call_queue(const wamp_request_id& request_id,
+        const wamp_dealer_invocation& dealer_invocation)
+{
+    const std::shared_ptr<wamp_dealer_call_queue>& call_queue = dealer_invocation.get_call_queue();
+    if (!call_queue) {
+        return;
+    }
+
+    if (dealer_invocation.is_queued()) {
+        if (call_queue->remove(request_id)) {
+            --m_call_queue_depth;
+        }
+        return;
+    }
+
+    // Dispatching sends messages which can detach sessions and in turn
+    // erase further invocations. So the waiting calls are dispatched once
+    // the current message has been processed.
+    call_queue->release();
+    if (call_queue->get_size()) {
+        std::weak_ptr<wamp_dealer*> weak_dealer = m_lifetime;
+        m_io_service.post([weak_dealer, call_queue]() {
+            auto dealer = weak_dealer.lock();
+            if (dealer) {
+                (*dealer)->dispatch_queued_invocations(call_queue);
+            }
+        });
+    }
+}
+
+void wamp_dealer::dispatch_queued_invocations(
+        const std::shared_ptr<wamp_dealer_call_queue>& call_queue)
+{
+    wamp_request_id request_id;
+    while (call_queue->pop(request_id)) {
+        --m_call_queue_depth;
+
+        auto pending_invocations_itr = m_pending_invocations.find(request_id);
+        if (pending_invocations_itr == m_pending_invocations.end()) {
+            call_queue->release();
+            continue;
+        }
+
+        // Calls whose deadline passed while they were waiting in the queue are
+        // timed out right away rather than wasting the slot on the callee.
+        const auto& dealer_invocation = pending_invocations_itr->second;
+        if (dealer_invocation->is_expired()) {
+            call_queue->release();
+            pending_callers callers = take_callers(request_id);
+            for (const auto& caller : callers) {
+                send_error(caller.first->get_transport(), wamp_message_type::CALL,
+                        caller.second, "wamp.error.call_timed_out");
+            }
+            continue;
+        }
+
+        std::shared_ptr<wamp_session> callee = dealer_invocation->get_callee();
+        std::unique_ptr<wamp_invocation_message> invocation_message =
+                dealer_invocation->take_queued_message();
+
+        // The callee is told how much time is left after waiting in the queue.
+        if (dealer_invocation->has_deadline()) {
+            msgpack::zone zone;
+            std::map<std::string, msgpack::object> details =
+                    invocation_message->get_details().as<std::map<std::string, msgpack::object>>();
+            details["timeout"] = msgpack::object(dealer_invocation->get_remaining_ms());
+            invocation_message->set_details(msgpack::object(details, zone));
+        }
+
+        BONEFISH_TRACE("%1%, %2%", *callee % *invocation_message);
+        if (!callee->get_transport()->send_message(std::move(*invocation_message))) {
+            BONEFISH_TRACE("sending invocation message to callee failed: network failure");
+
+            pending_callers callers = take_callers(request_id);
+            for (const auto& caller : callers) {
+                send_error(caller.first->get_transport(), wamp_message_type::CALL,
+                        caller.second, "wamp.error.network_failure");
+            }
+        }
+    }
+}
+
+void wamp_dealer::process_fanout_call_message(const std::shared_ptr<wamp_session>& session,
+        const wamp_call_message* call_message, const wamp_dealer_registration& registration,
+        const wamp_request_id& request_id, unsigned timeout_ms)
+{
+    // Sending can fail and detach a callee which in turn drops it from the
+    // registration. So everything needed from the registration is copied up
+    // front.
+    const std::vector<std::shared_ptr<wamp_session>> callees = registration.get_sessions();
+    const wamp_registration_id registration_id = registration.get_registration_id();
+    const bool pattern = registration.get_match_policy() != wamp_match_policy::EXACT;
+
+    msgpack::zone zone;
+    std::map<std::string, msgpack::object> details;
+    if (pattern) {
+        details["procedure"] = msgpack::object(call_message->get_procedure(), zone);
+    }
+    if (timeout_ms) {
+        details["timeout"] = msgpack::object(timeout_ms);
+    }
+
+    std::unique_ptr<wamp_dealer_fanout> fanout(new wamp_dealer_fanout);
+    std::vector<std::shared_ptr<wamp_session>> invoked_callees;
+    for (const auto& callee : callees) {
+        std::unique_ptr<wamp_invocation_message> invocation_message(new wamp_invocation_message);
+        invocation_message->set_request_id(request_id);
+        invocation_message->set_registration_id(registration_id);
+        invocation_message->set_arguments(call_message->get_arguments());
+        invocation_message->set_arguments_kw(call_message->get_arguments_kw());
+        if (!details.empty()) {
+            invocation_message->set_details(msgpack::object(details, zone));
+        }
+
+        fanout->add_callee(callee);
+        BONEFISH_TRACE("%1%, %2%", *callee % *invocation_message);
+        if (!callee->get_transport()->send_message(std::move(*invocation_message))) {
+            BONEFISH_TRACE("sending invocation message to callee failed: network failure");
+            fanout->set_error(callee->get_session_id(), "wamp.error.network_failure",
+                    msgpack::object(), msgpack::object());
+            continue;
+        }
+        invoked_callees.push_back(callee);
+    }
+
+    if (invoked_callees.empty()) {
+        send_error(session->get_transport(), call_message->get_type(),
+                call_message->get_request_id(), "wamp.error.network_failure");
+        return;
+    }
+
+    // A single invocation tracks the answers of all of the callees. Each of
+    // the callees knows it by the same request id.
+    std::unique_ptr<wamp_dealer_invocation> dealer_invocation(
+            new wamp_dealer_invocation(m_io_service));
+    dealer_invocation->set_session(session);
+    dealer_invocation->set_request_id(call_message->get_request_id());
+    dealer_invocation->set_fanout(std::move(fanout));
+    dealer_invocation->set_timeout(
+            std::bind(&wamp_dealer::invocation_timeout_handler, this,
+                    request_id, std::placeholders::_1), timeout_ms);
+
+    m_pending_invocations.insert(std::make_pair(request_id, std::move(dealer_invocation)));
+    m_pending_caller_invocations[session->get_session_id()].insert(request_id);
+    for (const auto& callee : invoked_callees) {
+        m_pending_callee_invocations[callee->get_session_id()].insert(request_id);
+    }
+}
+
+void wamp_dealer::answer_fanout_invocation(const std::shared_ptr<wamp_session>& callee,
+        const wamp_request_id& request_id)
+{
+    erase_callee_invocation(callee, request_id);
+
+    auto pending_invocations_itr = m_pending_invocations.find(request_id);
+    if (pending_invocations_itr != m_pending_invocations.end() &&
+            pending_invocations_itr->second->get_fanout()->is_complete()) {
+        complete_fanout_invocation(request_id);
+    }
+}
+
+void wamp_dealer::complete_fanout_invocation(const wamp_request_id& request_id)
+{
+    auto pending_invocations_itr = m_pending_invocations.find(request_id);
+    if (pending_invocations_itr == m_pending_invocations.end()) {
+        return;
+    }
+
+    // The results are copied out of the invocation before it is taken out
+    // of the pending invocations.
+    msgpack::zone zone;
+    const msgpack::object results =
+            pending_invocations_itr->second->get_fanout()->get_results(zone);
+
+    pending_callers callers = take_callers(request_id);
+    for (const auto& caller : callers) {
+        std::unique_ptr<wamp_result_message> result_message(new wamp_result_message);
+        result_message->set_request_id(caller.second);
+        result_message->set_arguments(results);
+
+        BONEFISH_TRACE("%1%, %2%", *caller.first % *result_message);
+        if (!caller.first->get_transport()->send_message(std::move(*result_message))) {
+            BONEFISH_TRACE("failed to send result message to caller: network failure");
+        }
+    }
+}
+
+wamp_dealer_registration* wamp_dealer::find_registration(const boost::string_ref& procedure) const
+{
+    // Exact registrations take precedence over the longest matching prefix
+    // registration which in turn takes precedence over wildcard registrations.
+    auto procedure_registrations_itr = m_procedure_registrations.find(m_uri_table.find(procedure));
+    if (procedure_registrations_itr != m_procedure_registrations.end()) {
+        return procedure_registrations_itr->second.get();
+    }
+
+    return m_procedure_patterns.match(procedure);
+}
+
+bool wamp_dealer::park_call(const std::shared_ptr<wamp_session>& session,
+        const wamp_call_message* call_message)
+{
+    // Calls may only shorten the grace period of the router so that they
+    // cannot hold on to a parking spot for longer than the router allows.
+    wamp_call_options options;
+    options.unmarshal(call_message->get_options());
+    const unsigned grace_period_ms = std::min(options.get_option_or<unsigned>(
+            "registration_grace_period", m_registration_grace_period_ms),
+            m_registration_grace_period_ms);
+    if (!grace_period_ms || m_parked_calls.size() >= MAX_PARKED_CALLS) {
+        return false;
+    }
+
+    size_t session_parked_calls = 0;
+    for (const auto& parked_call : m_parked_calls) {
+        if (parked_call->get_session() == session &&
+                ++session_parked_calls >= MAX_SESSION_PARKED_CALLS) {
+            return false;
+        }
+    }
+
+    // The call fails with whatever expires first. A call timeout that is
+    // shorter than the grace period is reported as a timed out call.
+    const unsigned timeout_ms = options.get_option_or<unsigned>("timeout", 0);
+    const bool timeout_first = timeout_ms && timeout_ms < grace_period_ms;
+
+    const wamp_request_id request_id = m_request_id_generator.generate();
+    std::unique_ptr<wamp_dealer_parked_call> parked_call(
+            new wamp_dealer_parked_call(m_io_service, request_id, session, call_message));
+    parked_call->set_timeout(timeout_ms);
+    parked_call->set_expiration(
+            std::bind(&wamp_dealer::parked_call_expiration_handler, this,
+                    request_id, std::placeholders::_1),
+            timeout_first ? timeout_ms : grace_period_ms,
+            timeout_first ? "wamp.error.call_timed_out" : "wamp.error.no_such_procedure");
+
+    BONEFISH_TRACE("parking call: %1%", call_message->get_procedure());
+    m_parked_calls.push_back(std::move(parked_call));
+    return true;
+}
+
+bool wamp_dealer::cancel_parked_call(const std::shared_ptr<wamp_session>& session,
+        const wamp_request_id& call_request_id)
+{
+    for (auto parked_calls_itr = m_parked_calls.begin();
+            parked_calls_itr != m_parked_calls.end(); ++parked_calls_itr) {
+        const auto& parked_call = *parked_calls_itr;
+        if (parked_call->get_session() == session &&
+                parked_call->get_call_message()->get_request_id() == call_request_id) {
+            m_parked_calls.erase(parked_calls_itr);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void wamp_dealer::dispatch_parked_calls()
+{
+    std::vector<wamp_request_id> request_ids;
+    for (const auto& parked_call : m_parked_calls) {
+        if (find_registration(parked_call->get_call_message()->get_procedure_ref())) {
+            request_ids.push_back(parked_call->get_request_id());
+        }
+    }
+
+    // Processing a call sends messages which can detach sessions and in
+    // turn drop their parked calls. So each call is looked up again before
+    // it is processed.
+    for (const auto& request_id : request_ids) {
+        std::unique_ptr<wamp_dealer_parked_call> parked_call = take_parked_call(request_id);
+        if (!parked_call) {
+            continue;
+        }
+
+        // The time spent waiting for the registration counts towards the
+        // call timeout. Calls whose deadline has already passed are timed
+        // out rather than invoking the callee.
+        const wamp_call_message* call_message = parked_call->get_call_message();
+        if (parked_call->is_expired()) {
+            send_error(parked_call->get_session()->get_transport(), wamp_message_type::CALL,
+                    call_message->get_request_id(), "wamp.error.call_timed_out");
+            continue;
+        }
+
+        BONEFISH_TRACE("dispatching parked call: %1%", call_message->get_procedure());
+        process_call_message(parked_call->get_session(), call_message, parked_call.get());
+    }
+}
+
+std::unique_ptr<wamp_dealer_parked_call> wamp_dealer::take_parked_call(
+        const wamp_request_id& request_id)
+{
+    for (auto parked_calls_itr = m_parked_calls.begin();
+            parked_calls_itr != m_parked_calls.end(); ++parked_calls_itr) {
+        if ((*parked_calls_itr)->get_request_id() == request_id) {
+            std::unique_ptr<wamp_dealer_parked_call> parked_call = std::move(*parked_calls_itr);
+            m_parked_calls.erase(parked_calls_itr);
+            return parked_call;
+        }
+    }
+
+    return nullptr;
+}
+
+void wamp_dealer::parked_call_expiration_handler(const wamp_request_id& request_id,
+        const boost::system::error_code& error)
+{
+    if (error == boost::asio::error::operation_aborted) {
+        return;
+    }
+
+    std::unique_ptr<wamp_dealer_parked_call> parked_call = take_parked_call(request_id);
+    if (!parked_call) {
+        BONEFISH_TRACE("error: unable to find parked call");
+        return;
+    }
+
+    BONEFISH_TRACE("parked call expired: %1%", parked_call->get_error());
+    send_error(parked_call->get_session()->get_transport(), wamp_message_type::CALL,
+            parked_call->get_call_message()->get_request_id(), parked_call->get_error());
 }
 
 } // namespace bonefish
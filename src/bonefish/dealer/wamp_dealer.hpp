@@ -17,6 +17,12 @@
 #ifndef BONEFISH_DEALER_WAMP_DEALER_HPP
 #define BONEFISH_DEALER_WAMP_DEALER_HPP
 
+#include <bonefish/dealer/wamp_dealer_cache_stats.hpp>
+#include <bonefish/dealer/wamp_dealer_call_queue.hpp>
+#include <bonefish/dealer/wamp_dealer_result_cache.hpp>
+#include <bonefish/dealer/wamp_dealer_uri_trie.hpp>
+#include <bonefish/dealer/wamp_match_policy.hpp>
+#include <bonefish/dealer/wamp_procedure.hpp>
 #include <bonefish/identifiers/wamp_registration_id_generator.hpp>
 #include <bonefish/identifiers/wamp_request_id_generator.hpp>
 #include <bonefish/identifiers/wamp_registration_id.hpp>
@@ -24,19 +30,30 @@
 #include <bonefish/identifiers/wamp_session_id.hpp>
 #include <bonefish/messages/wamp_message_type.hpp>
 #include <bonefish/utility/wamp_uri.hpp>
+#include <bonefish/utility/wamp_uri_table.hpp>
 
 #include <boost/asio.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <list>
 #include <memory>
+#include <msgpack.hpp>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace bonefish {
 
 class wamp_call_message;
+class wamp_call_options;
+class wamp_cancel_message;
 class wamp_dealer_invocation;
+class wamp_dealer_parked_call;
 class wamp_dealer_registration;
 class wamp_error_message;
 class wamp_register_message;
+class wamp_register_options;
 class wamp_session;
 class wamp_transport;
 class wamp_unregister_message;
@@ -45,25 +62,129 @@ class wamp_yield_message;
 class wamp_dealer
 {
 public:
-    wamp_dealer(boost::asio::io_service& io_service);
+    wamp_dealer(boost::asio::io_service& io_service, wamp_uri_table& uri_table);
     ~wamp_dealer();
 
     void attach_session(const std::shared_ptr<wamp_session>& session);
-    void detach_session(const wamp_session_id& id);
+    void detach_session(const std::shared_ptr<wamp_session>& session);
 
-    void process_call_message(const wamp_session_id& session_id,
+    void process_call_message(const std::shared_ptr<wamp_session>& session,
             const wamp_call_message* call_message);
-    void process_error_message(const wamp_session_id& session_id,
+    void process_cancel_message(const std::shared_ptr<wamp_session>& session,
+            const wamp_cancel_message* cancel_message);
+    void process_error_message(const std::shared_ptr<wamp_session>& session,
             const wamp_error_message* error_message);
-    void process_register_message(const wamp_session_id& session_id,
+    void process_register_message(const std::shared_ptr<wamp_session>& session,
             const wamp_register_message* register_message);
-    void process_unregister_message(const wamp_session_id& session_id,
+    void process_unregister_message(const std::shared_ptr<wamp_session>& session,
             const wamp_unregister_message* unregister_message);
-    void process_yield_message(const wamp_session_id& session_id,
+    void process_yield_message(const std::shared_ptr<wamp_session>& session,
             const wamp_yield_message* yield_message);
 
+    /// The hits, misses and evictions of the caches of cacheable procedures.
+    const wamp_dealer_cache_stats& get_cache_stats() const;
+
+    /// The number of calls waiting for a free slot of a registration with
+    /// limited concurrency.
+    size_t get_call_queue_depth() const;
+
+    /// Calls to procedures that are not registered yet wait for up to the
+    /// grace period for the procedure to be registered. Calls may ask for a
+    /// shorter grace period of their own. The default of 0 fails such calls
+    /// right away.
+    void set_registration_grace_period(unsigned grace_period_ms);
+
+    /// Registers a procedure that runs inside of the router. Calls to it are
+    /// answered directly without sending an invocation to a callee.
+    wamp_registration_id register_procedure(const std::string& procedure,
+            const wamp_procedure& handler);
+
+    /// Registers a procedure that runs inside of the router and completes
+    /// calls later on. Pending calls are subject to the call timeout.
+    wamp_registration_id register_async_procedure(const std::string& procedure,
+            const wamp_async_procedure& handler);
+
+    /// Removes a procedure that was registered inside of the router. Returns
+    /// false if there is no such registration.
+    bool unregister_procedure(const wamp_registration_id& registration_id);
+
 private:
-    void send_error(const std::unique_ptr<wamp_transport>& transport,
+    /// The maximum number of calls that wait for their procedure to be
+    /// registered at any one time. Each session only gets a share of them
+    /// so that a single caller cannot keep the others from parking calls.
+    static const size_t MAX_PARKED_CALLS = 1024;
+    static const size_t MAX_SESSION_PARKED_CALLS = 64;
+
+    /// Processes a call that may have been parked while waiting for its
+    /// procedure to be registered.
+    void process_call_message(const std::shared_ptr<wamp_session>& session,
+            const wamp_call_message* call_message, const wamp_dealer_parked_call* parked_call);
+
+    wamp_dealer_registration* find_registration(const boost::string_ref& procedure) const;
+    bool park_call(const std::shared_ptr<wamp_session>& session,
+            const wamp_call_message* call_message);
+    bool cancel_parked_call(const std::shared_ptr<wamp_session>& session,
+            const wamp_request_id& call_request_id);
+    void dispatch_parked_calls();
+    std::unique_ptr<wamp_dealer_parked_call> take_parked_call(const wamp_request_id& request_id);
+    void parked_call_expiration_handler(const wamp_request_id& request_id,
+            const boost::system::error_code& error);
+
+    void process_pattern_register_message(const std::shared_ptr<wamp_session>& session,
+            const wamp_register_message* register_message, const wamp_register_options& options,
+            wamp_match_policy policy);
+    std::shared_ptr<wamp_dealer_result_cache> create_result_cache(
+            const wamp_register_options& options) const;
+    std::string create_routing_key(const wamp_call_options& options,
+            const msgpack::object& arguments) const;
+    std::shared_ptr<wamp_dealer_call_queue> create_call_queue(
+            const wamp_register_options& options) const;
+    bool erase_pattern_registration(const wamp_registration_id& registration_id);
+
+    void process_fanout_call_message(const std::shared_ptr<wamp_session>& session,
+            const wamp_call_message* call_message, const wamp_dealer_registration& registration,
+            const wamp_request_id& request_id, unsigned timeout_ms);
+    void answer_fanout_invocation(const std::shared_ptr<wamp_session>& callee,
+            const wamp_request_id& request_id);
+    void complete_fanout_invocation(const wamp_request_id& request_id);
+    void process_progressive_yield_message(const std::shared_ptr<wamp_session>& session,
+            const wamp_yield_message* yield_message,
+            const wamp_dealer_invocation& dealer_invocation);
+
+    wamp_registration_id add_native_registration(const std::string& procedure,
+            std::unique_ptr<wamp_dealer_registration>&& registration);
+    void call_native_procedure(const std::shared_ptr<wamp_session>& session,
+            const wamp_call_message* call_message,
+            const wamp_dealer_registration& registration,
+            const wamp_dealer_parked_call* parked_call);
+    void complete_native_procedure(const wamp_request_id& request_id,
+            const wamp_procedure_result& result);
+    void send_procedure_result(const std::shared_ptr<wamp_transport>& transport,
+            const wamp_request_id& request_id, const wamp_procedure_result& result) const;
+
+    /// The callers that are answered when an invocation completes along with
+    /// the request ids of their calls.
+    typedef std::vector<std::pair<std::shared_ptr<wamp_session>, wamp_request_id>> pending_callers;
+
+    bool join_pending_invocation(const std::shared_ptr<wamp_session>& session,
+            const wamp_call_message* call_message, const wamp_request_id& request_id,
+            const wamp_request_id& leader_request_id, unsigned timeout_ms);
+    void erase_callee_invocation(const std::shared_ptr<wamp_session>& callee,
+            const wamp_request_id& request_id);
+    void erase_coalesced_invocation(const wamp_request_id& request_id,
+            const wamp_dealer_invocation& dealer_invocation);
+    bool has_followers(const wamp_dealer_invocation& dealer_invocation) const;
+    pending_callers take_callers(const wamp_request_id& request_id);
+
+    void release_call_queue(const wamp_request_id& request_id,
+            const wamp_dealer_invocation& dealer_invocation);
+    void dispatch_queued_invocations(const std::shared_ptr<wamp_dealer_call_queue>& call_queue);
+
+    void send_interrupt(const std::shared_ptr<wamp_session>& callee,
+            const wamp_request_id& request_id, const std::string& mode) const;
+    void erase_pending_invocation(const wamp_request_id& request_id);
+
+    void send_error(const std::shared_ptr<wamp_transport>& transport,
             const wamp_message_type request_type, const wamp_request_id& request_id,
             const std::string& error) const;
 
@@ -74,28 +195,34 @@ private:
     /// Asynchronous event loop for executing completion handlers.
     boost::asio::io_service& m_io_service;
 
+    /// Interns procedure names for the realm so that they can be tracked by id.
+    wamp_uri_table& m_uri_table;
+
     /// Generates request ids for all invocation requests that are processed.
     wamp_request_id_generator m_request_id_generator;
 
     /// Generates registration ids for all procedures that are registered.
     wamp_registration_id_generator m_registration_id_generator;
 
-    /// Tracks the sessions that are currently attached to the dealer.
-    std::unordered_map<wamp_session_id, std::shared_ptr<wamp_session>> m_sessions;
-
     /// Tracks the registrations that have been made for each session. This allows
     /// for individual unregistrations to occur as well as for all of the outstanding
     /// registrations to be cleaned up when a sessions is closed.
     std::unordered_map<wamp_session_id, std::unordered_set<wamp_registration_id>> m_session_registrations;
 
-    /// Maps each of the registrations to its corresponding procedure name. This
+    /// Maps each of the registrations to its corresponding interned procedure. This
     /// allows for looking up a sessions procedure registrations based on the
     /// registration id.
-    std::unordered_map<wamp_registration_id, std::string> m_registered_procedures;
+    std::unordered_map<wamp_registration_id, wamp_uri_id> m_registered_procedures;
 
-    /// Maps procedure names to the corresponding registration info such as which
+    /// Maps interned procedures to the corresponding registration info such as which
     /// session has registered the procedure to be invoked.
-    std::unordered_map<std::string, std::unique_ptr<wamp_dealer_registration>> m_procedure_registrations;
+    std::unordered_map<wamp_uri_id, std::unique_ptr<wamp_dealer_registration>> m_procedure_registrations;
+
+    /// Tracks the prefix and wildcard registrations by registration id. These
+    /// are resolved through the procedure patterns when there is no exact
+    /// registration for a procedure.
+    std::unordered_map<wamp_registration_id, std::unique_ptr<wamp_dealer_registration>> m_pattern_registrations;
+    wamp_dealer_uri_trie m_procedure_patterns;
 
     /// Tracks pending invocations that have been forwarded to the destination
     /// component. The invocation object tracks enough information to provide a
@@ -112,6 +239,22 @@ private:
     /// callee. This allows for the invocations to be cleaned up properly when the
     /// callee disconnects before it is able to send a yield response.
     std::unordered_map<wamp_session_id, std::unordered_set<wamp_request_id>> m_pending_callee_invocations;
+
+    /// Maps the key of a call to a coalescing procedure to the pending
+    /// invocation that identical calls join.
+    std::unordered_map<std::string, wamp_request_id> m_coalesced_invocations;
+
+    wamp_dealer_cache_stats m_cache_stats;
+    size_t m_call_queue_depth;
+
+    /// Calls that wait for their procedure to be registered in the order in
+    /// which they arrived.
+    unsigned m_registration_grace_period_ms;
+    std::list<std::unique_ptr<wamp_dealer_parked_call>> m_parked_calls;
+
+    /// Lets the completions of asynchronous procedures and queued dispatches detect that the dealer
+    /// has been destroyed before they were invoked.
+    std::shared_ptr<wamp_dealer*> m_lifetime;
 };
 
 } // namespace bonefish
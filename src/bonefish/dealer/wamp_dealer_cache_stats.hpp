@@ -0,0 +1,93 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_DEALER_WAMP_DEALER_CACHE_STATS_HPP
+#define BONEFISH_DEALER_WAMP_DEALER_CACHE_STATS_HPP
+
+#include <cstdint>
+#include <ostream>
+
+namespace bonefish {
+
+/// Counters for the results that the dealer caches for procedures that
+/// were registered as cacheable. Expired entries count as misses.
+class wamp_dealer_cache_stats
+{
+public:
+    wamp_dealer_cache_stats();
+
+    void add_hit();
+    void add_miss();
+    void add_evictions(uint64_t evictions);
+
+    uint64_t get_hits() const;
+    uint64_t get_misses() const;
+    uint64_t get_evictions() const;
+
+private:
+    uint64_t m_hits;
+    uint64_t m_misses;
+    uint64_t m_evictions;
+};
+
+inline wamp_dealer_cache_stats::wamp_dealer_cache_stats()
+    : m_hits(0)
+    , m_misses(0)
+    , m_evictions(0)
+{
+}
+
+inline void wamp_dealer_cache_stats::add_hit()
+{
+    ++m_hits;
+}
+
+inline void wamp_dealer_cache_stats::add_miss()
+{
+    ++m_misses;
+}
+
+inline void wamp_dealer_cache_stats::add_evictions(uint64_t evictions)
+{
+    m_evictions += evictions;
+}
+
+inline uint64_t wamp_dealer_cache_stats::get_hits() const
+{
+    return m_hits;
+}
+
+inline uint64_t wamp_dealer_cache_stats::get_misses() const
+{
+    return m_misses;
+}
+
+inline uint64_t wamp_dealer_cache_stats::get_evictions() const
+{
+    return m_evictions;
+}
+
+inline std::ostream& operator<<(std::ostream& os, const wamp_dealer_cache_stats& stats)
+{
+    os << "hits " << stats.get_hits()
+            << " misses " << stats.get_misses()
+            << " evictions " << stats.get_evictions();
+    return os;
+}
+
+} // namespace bonefish
+
+#endif // BONEFISH_DEALER_WAMP_DEALER_CACHE_STATS_HPP
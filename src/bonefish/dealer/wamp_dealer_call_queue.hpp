@@ -0,0 +1,140 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_DEALER_WAMP_DEALER_CALL_QUEUE_HPP
+#define BONEFISH_DEALER_WAMP_DEALER_CALL_QUEUE_HPP
+
+#include <bonefish/identifiers/wamp_request_id.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+
+namespace bonefish {
+
+/// Limits the number of outstanding invocations of a registration. Calls
+/// that arrive while all of the slots are taken wait in a bounded FIFO until
+/// an outstanding invocation completes.
+class wamp_dealer_call_queue
+{
+public:
+    /// The maximum number of waiting calls used when a registration only
+    /// specifies its concurrency.
+    static const size_t DEFAULT_MAX_SIZE = 1024;
+
+public:
+    wamp_dealer_call_queue(size_t concurrency, size_t max_size);
+    ~wamp_dealer_call_queue();
+
+    wamp_dealer_call_queue(const wamp_dealer_call_queue&) = delete;
+    wamp_dealer_call_queue& operator=(const wamp_dealer_call_queue&) = delete;
+
+    /// Takes a slot for a call that arrived. Fails if all of the slots are
+    /// taken or if other calls are already waiting for one.
+    bool acquire();
+
+    /// Gives back the slot of an invocation that is no longer outstanding.
+    void release();
+
+    /// Adds a call to the back of the queue. Fails if the queue is full.
+    bool push(const wamp_request_id& request_id);
+
+    /// Takes a slot for the call at the front of the queue. Fails if the
+    /// queue is empty or all of the slots are taken.
+    bool pop(wamp_request_id& request_id);
+
+    /// Removes a waiting call that completed without being invoked.
+    bool remove(const wamp_request_id& request_id);
+
+    size_t get_size() const;
+
+private:
+    const size_t m_concurrency;
+    const size_t m_max_size;
+    size_t m_outstanding;
+    std::deque<wamp_request_id> m_request_ids;
+};
+
+inline wamp_dealer_call_queue::wamp_dealer_call_queue(size_t concurrency, size_t max_size)
+    : m_concurrency(concurrency)
+    , m_max_size(max_size)
+    , m_outstanding(0)
+    , m_request_ids()
+{
+}
+
+inline wamp_dealer_call_queue::~wamp_dealer_call_queue()
+{
+}
+
+inline bool wamp_dealer_call_queue::acquire()
+{
+    if (!m_request_ids.empty() || m_outstanding >= m_concurrency) {
+        return false;
+    }
+
+    ++m_outstanding;
+    return true;
+}
+
+inline void wamp_dealer_call_queue::release()
+{
+    if (m_outstanding) {
+        --m_outstanding;
+    }
+}
+
+inline bool wamp_dealer_call_queue::push(const wamp_request_id& request_id)
+{
+    if (m_request_ids.size() >= m_max_size) {
+        return false;
+    }
+
+    m_request_ids.push_back(request_id);
+    return true;
+}
+
+inline bool wamp_dealer_call_queue::pop(wamp_request_id& request_id)
+{
+    if (m_request_ids.empty() || m_outstanding >= m_concurrency) {
+        return false;
+    }
+
+    request_id = m_request_ids.front();
+    m_request_ids.pop_front();
+    ++m_outstanding;
+    return true;
+}
+
+inline bool wamp_dealer_call_queue::remove(const wamp_request_id& request_id)
+{
+    auto request_ids_itr = std::find(m_request_ids.begin(), m_request_ids.end(), request_id);
+    if (request_ids_itr == m_request_ids.end()) {
+        return false;
+    }
+
+    m_request_ids.erase(request_ids_itr);
+    return true;
+}
+
+inline size_t wamp_dealer_call_queue::get_size() const
+{
+    return m_request_ids.size();
+}
+
+} // namespace bonefish
+
+#endif // BONEFISH_DEALER_WAMP_DEALER_CALL_QUEUE_HPP
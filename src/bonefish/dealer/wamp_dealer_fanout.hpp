@@ -0,0 +1,177 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_DEALER_WAMP_DEALER_FANOUT_HPP
+#define BONEFISH_DEALER_WAMP_DEALER_FANOUT_HPP
+
+#include <bonefish/identifiers/wamp_session_id.hpp>
+#include <bonefish/session/wamp_session.hpp>
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <msgpack.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace bonefish {
+
+/// Gathers the answers to a call that was invoked on every callee of a
+/// shared registration. Each callee has a slot in the order in which it
+/// was invoked and the answers are kept until all of the callees have
+/// answered or the call times out.
+class wamp_dealer_fanout
+{
+public:
+    wamp_dealer_fanout();
+    ~wamp_dealer_fanout();
+
+    wamp_dealer_fanout(const wamp_dealer_fanout&) = delete;
+    wamp_dealer_fanout& operator=(const wamp_dealer_fanout&) = delete;
+
+    void add_callee(const std::shared_ptr<wamp_session>& callee);
+
+    /// Records the result of a callee. Returns false if the callee is not
+    /// part of the call or has already answered.
+    bool set_result(const wamp_session_id& session_id, const msgpack::object& arguments,
+            const msgpack::object& arguments_kw);
+
+    /// Records the error of a callee. Returns false if the callee is not
+    /// part of the call or has already answered.
+    bool set_error(const wamp_session_id& session_id, const std::string& error,
+            const msgpack::object& arguments, const msgpack::object& arguments_kw);
+
+    /// The callees that have not answered yet.
+    std::vector<std::shared_ptr<wamp_session>> get_pending_callees() const;
+    bool is_complete() const;
+
+    /// Builds the list of per callee answers. Callees that have not answered
+    /// yet are reported as having timed out.
+    msgpack::object get_results(msgpack::zone& zone) const;
+
+private:
+    struct slot
+    {
+        std::shared_ptr<wamp_session> callee;
+        bool pending;
+        msgpack::object answer;
+    };
+
+    bool set_answer(const wamp_session_id& session_id,
+            const std::map<std::string, msgpack::object>& answer);
+
+private:
+    msgpack::zone m_zone;
+    std::vector<slot> m_slots;
+    std::unordered_map<wamp_session_id, size_t> m_callee_slots;
+    size_t m_pending;
+};
+
+inline wamp_dealer_fanout::wamp_dealer_fanout()
+    : m_zone()
+    , m_slots()
+    , m_callee_slots()
+    , m_pending(0)
+{
+}
+
+inline wamp_dealer_fanout::~wamp_dealer_fanout()
+{
+}
+
+inline void wamp_dealer_fanout::add_callee(const std::shared_ptr<wamp_session>& callee)
+{
+    m_callee_slots[callee->get_session_id()] = m_slots.size();
+    m_slots.push_back(slot { callee, true, msgpack::object() });
+    ++m_pending;
+}
+
+inline bool wamp_dealer_fanout::set_result(const wamp_session_id& session_id,
+        const msgpack::object& arguments, const msgpack::object& arguments_kw)
+{
+    std::map<std::string, msgpack::object> answer;
+    answer["args"] = arguments;
+    answer["kwargs"] = arguments_kw;
+    return set_answer(session_id, answer);
+}
+
+inline bool wamp_dealer_fanout::set_error(const wamp_session_id& session_id,
+        const std::string& error, const msgpack::object& arguments,
+        const msgpack::object& arguments_kw)
+{
+    std::map<std::string, msgpack::object> answer;
+    answer["error"] = msgpack::object(error, m_zone);
+    answer["args"] = arguments;
+    answer["kwargs"] = arguments_kw;
+    return set_answer(session_id, answer);
+}
+
+inline std::vector<std::shared_ptr<wamp_session>> wamp_dealer_fanout::get_pending_callees() const
+{
+    std::vector<std::shared_ptr<wamp_session>> callees;
+    for (const auto& callee_slot : m_slots) {
+        if (callee_slot.pending) {
+            callees.push_back(callee_slot.callee);
+        }
+    }
+
+    return callees;
+}
+
+inline bool wamp_dealer_fanout::is_complete() const
+{
+    return m_pending == 0;
+}
+
+inline msgpack::object wamp_dealer_fanout::get_results(msgpack::zone& zone) const
+{
+    std::map<std::string, std::string> timed_out { { "error", "wamp.error.call_timed_out" } };
+
+    std::vector<msgpack::object> results;
+    results.reserve(m_slots.size());
+    for (const auto& callee_slot : m_slots) {
+        results.push_back(callee_slot.pending
+                ? msgpack::object(timed_out, zone) : callee_slot.answer);
+    }
+
+    return msgpack::object(results, zone);
+}
+
+inline bool wamp_dealer_fanout::set_answer(const wamp_session_id& session_id,
+        const std::map<std::string, msgpack::object>& answer)
+{
+    auto callee_slots_itr = m_callee_slots.find(session_id);
+    if (callee_slots_itr == m_callee_slots.end()) {
+        return false;
+    }
+
+    slot& callee_slot = m_slots[callee_slots_itr->second];
+    if (!callee_slot.pending) {
+        return false;
+    }
+
+    // The answer is copied into the zone of the fanout as the messages that
+    // it came from are released once they have been processed.
+    callee_slot.answer = msgpack::object(answer, m_zone);
+    callee_slot.pending = false;
+    --m_pending;
+    return true;
+}
+
+} // namespace bonefish
+
+#endif // BONEFISH_DEALER_WAMP_DEALER_FANOUT_HPP
@@ -0,0 +1,140 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_DEALER_WAMP_DEALER_HASH_RING_HPP
+#define BONEFISH_DEALER_WAMP_DEALER_HASH_RING_HPP
+
+#include <bonefish/identifiers/wamp_session_id.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace bonefish {
+
+/// A consistent hash ring over the callees of a shared registration. Each
+/// callee is placed on the ring many times so that the keys are spread
+/// evenly and only about 1/N of the keys move when a callee joins or
+/// leaves. Callees are placed by their node key rather than by their
+/// random session id. So a callee that registers with the same node key
+/// after reconnecting or after a router restart owns the same keys again.
+class wamp_dealer_hash_ring
+{
+public:
+    /// The number of points on the ring for each callee.
+    static const unsigned REPLICAS = 128;
+
+public:
+    wamp_dealer_hash_ring();
+    ~wamp_dealer_hash_ring();
+
+    void insert(const std::string& node_key, const wamp_session_id& session_id);
+    void erase(const std::string& node_key, const wamp_session_id& session_id);
+
+    /// Finds the callee that owns the key which is the first callee that
+    /// follows the hash of the key on the ring.
+    const wamp_session_id& find(const std::string& key) const;
+
+    bool empty() const;
+
+private:
+    static uint64_t hash(const unsigned char* data, size_t length);
+    static uint64_t hash(const std::string& node_key, unsigned replica);
+
+private:
+    std::map<uint64_t, wamp_session_id> m_points;
+};
+
+inline wamp_dealer_hash_ring::wamp_dealer_hash_ring()
+    : m_points()
+{
+}
+
+inline wamp_dealer_hash_ring::~wamp_dealer_hash_ring()
+{
+}
+
+inline void wamp_dealer_hash_ring::insert(const std::string& node_key,
+        const wamp_session_id& session_id)
+{
+    // Points that collide with the point of another callee stay with that
+    // callee so that the owner of a key never depends on the join order.
+    for (unsigned replica = 0; replica < REPLICAS; ++replica) {
+        m_points.insert(std::make_pair(hash(node_key, replica), session_id));
+    }
+}
+
+inline void wamp_dealer_hash_ring::erase(const std::string& node_key,
+        const wamp_session_id& session_id)
+{
+    for (unsigned replica = 0; replica < REPLICAS; ++replica) {
+        auto points_itr = m_points.find(hash(node_key, replica));
+        if (points_itr != m_points.end() && points_itr->second == session_id) {
+            m_points.erase(points_itr);
+        }
+    }
+}
+
+inline const wamp_session_id& wamp_dealer_hash_ring::find(const std::string& key) const
+{
+    if (m_points.empty()) {
+        throw std::logic_error("hash ring has no callees");
+    }
+
+    auto points_itr = m_points.lower_bound(
+            hash(reinterpret_cast<const unsigned char*>(key.data()), key.size()));
+    if (points_itr == m_points.end()) {
+        points_itr = m_points.begin();
+    }
+
+    return points_itr->second;
+}
+
+inline bool wamp_dealer_hash_ring::empty() const
+{
+    return m_points.empty();
+}
+
+inline uint64_t wamp_dealer_hash_ring::hash(const unsigned char* data, size_t length)
+{
+    // FNV-1a followed by a finalizer that spreads similar keys across the
+    // entire ring.
+    uint64_t value = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; ++i) {
+        value = (value ^ data[i]) * 1099511628211ULL;
+    }
+
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+inline uint64_t wamp_dealer_hash_ring::hash(const std::string& node_key, unsigned replica)
+{
+    std::string data(node_key);
+    for (size_t i = 0; i < 4; ++i) {
+        data.push_back(static_cast<char>(replica >> (8 * i)));
+    }
+
+    return hash(reinterpret_cast<const unsigned char*>(data.data()), data.size());
+}
+
+} // namespace bonefish
+
+#endif // BONEFISH_DEALER_WAMP_DEALER_HASH_RING_HPP
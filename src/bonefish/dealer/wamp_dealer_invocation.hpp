@@ -17,12 +17,20 @@
 #ifndef BONEFISH_DEALER_WAMP_DEALER_INVOCATION_HPP
 #define BONEFISH_DEALER_WAMP_DEALER_INVOCATION_HPP
 
+#include <bonefish/dealer/wamp_dealer_call_queue.hpp>
+#include <bonefish/dealer/wamp_dealer_fanout.hpp>
+#include <bonefish/dealer/wamp_dealer_result_cache.hpp>
 #include <bonefish/identifiers/wamp_request_id.hpp>
+#include <bonefish/messages/wamp_invocation_message.hpp>
 #include <bonefish/session/wamp_session.hpp>
 
 #include <boost/asio.hpp>
+#include <chrono>
 #include <functional>
+#include <memory>
+#include <string>
 #include <unordered_set>
+#include <vector>
 
 namespace bonefish {
 
@@ -38,25 +46,101 @@ public:
     void set_request_id(const wamp_request_id& request_id);
     void set_session(const std::shared_ptr<wamp_session>& session);
     void set_timeout(timeout_callback callback, unsigned timeout_ms);
+    void set_receive_progress(bool receive_progress);
+    void set_callee(const std::shared_ptr<wamp_session>& callee);
+    void set_canceled(bool canceled);
+    void set_result_cache(const std::shared_ptr<wamp_dealer_result_cache>& result_cache,
+            std::string&& cache_key);
+    void set_coalesce_key(const std::string& coalesce_key);
+    void add_follower(const wamp_request_id& request_id);
+    void set_call_queue(const std::shared_ptr<wamp_dealer_call_queue>& call_queue);
+    void set_queued_message(std::unique_ptr<wamp_invocation_message>&& invocation_message);
+    std::unique_ptr<wamp_invocation_message> take_queued_message();
+    void set_fanout(std::unique_ptr<wamp_dealer_fanout>&& fanout);
 
     const wamp_request_id& get_request_id() const;
     const std::shared_ptr<wamp_session>& get_session() const;
+    bool get_receive_progress() const;
+    const std::shared_ptr<wamp_session>& get_callee() const;
+    bool is_canceled() const;
+    std::shared_ptr<wamp_dealer_result_cache> get_result_cache() const;
+    const std::string& get_cache_key() const;
+    const std::string& get_coalesce_key() const;
+    const std::vector<wamp_request_id>& get_followers() const;
+    const std::shared_ptr<wamp_dealer_call_queue>& get_call_queue() const;
+    bool is_queued() const;
+    wamp_dealer_fanout* get_fanout() const;
+
+    /// The time that is left until the call times out. Calls without a
+    /// timeout never expire.
+    bool has_deadline() const;
+    bool is_expired() const;
+    unsigned get_remaining_ms() const;
 
 private:
     wamp_request_id m_request_id;
 
+    /// Whether the caller accepts progressive results for the call.
+    bool m_receive_progress;
+
     // We use a shared pointer to the session here because there is no
     // convenient way to cleanup pending invocations when a sesson is
     // detached without walking the entire mapping of outstanding
     // invocations. So instead we allow things to simply timeout and
     // clean themselves up naturally.
     std::shared_ptr<wamp_session> m_session;
+
+    /// The session that is processing the invocation. There is no callee
+    /// for procedures that run inside of the router.
+    std::shared_ptr<wamp_session> m_callee;
+
+    /// Whether the callee has already been interrupted by a cancel in the
+    /// kill mode and the call is waiting for the callee to respond.
+    bool m_canceled;
+
+    /// The cache that the final result is stored in. It is not kept alive
+    /// by the invocation so that unregistering drops it right away.
+    std::weak_ptr<wamp_dealer_result_cache> m_result_cache;
+    std::string m_cache_key;
+
+    /// Identical calls to coalescing procedures share a single invocation
+    /// of the callee which tracks the calls that joined it.
+    std::string m_coalesce_key;
+    std::vector<wamp_request_id> m_followers;
+
+    /// The call queue of a registration with limited concurrency. The
+    /// invocation message is held back while the call is waiting in the
+    /// queue and is only sent to the callee once a slot frees up.
+    std::shared_ptr<wamp_dealer_call_queue> m_call_queue;
+    std::unique_ptr<wamp_invocation_message> m_queued_message;
+
+    /// The answers of the callees of a call that was invoked on all of the
+    /// callees of a shared registration. There is no single callee for such
+    /// calls.
+    std::unique_ptr<wamp_dealer_fanout> m_fanout;
+
+    /// When the call times out if it has a timeout.
+    bool m_has_deadline;
+    std::chrono::steady_clock::time_point m_deadline;
+
     boost::asio::deadline_timer m_timeout_timer;
 };
 
 inline wamp_dealer_invocation::wamp_dealer_invocation(boost::asio::io_service& io_service)
     : m_request_id()
+    , m_receive_progress(false)
     , m_session()
+    , m_callee()
+    , m_canceled(false)
+    , m_result_cache()
+    , m_cache_key()
+    , m_coalesce_key()
+    , m_followers()
+    , m_call_queue()
+    , m_queued_message()
+    , m_fanout()
+    , m_has_deadline(false)
+    , m_deadline()
     , m_timeout_timer(io_service)
 {
 }
@@ -83,11 +167,68 @@ inline void wamp_dealer_invocation::set_timeout(timeout_callback callback, unsig
     // insted we just don't arm the timer which gives us an
     // infinite timeout.
     if (timeout_ms) {
+        m_has_deadline = true;
+        m_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
         m_timeout_timer.expires_from_now(boost::posix_time::milliseconds(timeout_ms));
         m_timeout_timer.async_wait(callback);
     }
 }
 
+inline void wamp_dealer_invocation::set_receive_progress(bool receive_progress)
+{
+    m_receive_progress = receive_progress;
+}
+
+inline void wamp_dealer_invocation::set_callee(const std::shared_ptr<wamp_session>& callee)
+{
+    m_callee = callee;
+}
+
+inline void wamp_dealer_invocation::set_canceled(bool canceled)
+{
+    m_canceled = canceled;
+}
+
+inline void wamp_dealer_invocation::set_result_cache(
+        const std::shared_ptr<wamp_dealer_result_cache>& result_cache,
+        std::string&& cache_key)
+{
+    m_result_cache = result_cache;
+    m_cache_key = std::move(cache_key);
+}
+
+inline void wamp_dealer_invocation::set_coalesce_key(const std::string& coalesce_key)
+{
+    m_coalesce_key = coalesce_key;
+}
+
+inline void wamp_dealer_invocation::add_follower(const wamp_request_id& request_id)
+{
+    m_followers.push_back(request_id);
+}
+
+inline void wamp_dealer_invocation::set_call_queue(
+        const std::shared_ptr<wamp_dealer_call_queue>& call_queue)
+{
+    m_call_queue = call_queue;
+}
+
+inline void wamp_dealer_invocation::set_queued_message(
+        std::unique_ptr<wamp_invocation_message>&& invocation_message)
+{
+    m_queued_message = std::move(invocation_message);
+}
+
+inline std::unique_ptr<wamp_invocation_message> wamp_dealer_invocation::take_queued_message()
+{
+    return std::move(m_queued_message);
+}
+
+inline void wamp_dealer_invocation::set_fanout(std::unique_ptr<wamp_dealer_fanout>&& fanout)
+{
+    m_fanout = std::move(fanout);
+}
+
 inline const std::shared_ptr<wamp_session>& wamp_dealer_invocation::get_session() const
 {
     return m_session;
@@ -98,6 +239,80 @@ inline const wamp_request_id& wamp_dealer_invocation::get_request_id() const
     return m_request_id;
 }
 
+inline bool wamp_dealer_invocation::get_receive_progress() const
+{
+    return m_receive_progress;
+}
+
+inline const std::shared_ptr<wamp_session>& wamp_dealer_invocation::get_callee() const
+{
+    return m_callee;
+}
+
+inline bool wamp_dealer_invocation::is_canceled() const
+{
+    return m_canceled;
+}
+
+inline std::shared_ptr<wamp_dealer_result_cache> wamp_dealer_invocation::get_result_cache() const
+{
+    return m_result_cache.lock();
+}
+
+inline const std::string& wamp_dealer_invocation::get_cache_key() const
+{
+    return m_cache_key;
+}
+
+inline const std::string& wamp_dealer_invocation::get_coalesce_key() const
+{
+    return m_coalesce_key;
+}
+
+inline const std::vector<wamp_request_id>& wamp_dealer_invocation::get_followers() const
+{
+    return m_followers;
+}
+
+inline const std::shared_ptr<wamp_dealer_call_queue>&
+wamp_dealer_invocation::get_call_queue() const
+{
+    return m_call_queue;
+}
+
+inline bool wamp_dealer_invocation::is_queued() const
+{
+    return m_queued_message != nullptr;
+}
+
+inline wamp_dealer_fanout* wamp_dealer_invocation::get_fanout() const
+{
+    return m_fanout.get();
+}
+
+inline bool wamp_dealer_invocation::has_deadline() const
+{
+    return m_has_deadline;
+}
+
+inline bool wamp_dealer_invocation::is_expired() const
+{
+    return m_has_deadline && std::chrono::steady_clock::now() >= m_deadline;
+}
+
+inline unsigned wamp_dealer_invocation::get_remaining_ms() const
+{
+    if (is_expired()) {
+        return 0;
+    }
+
+    // A timeout of zero means no timeout at all so anything left is
+    // rounded up to at least a millisecond.
+    const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            m_deadline - std::chrono::steady_clock::now()).count();
+    return remaining > 0 ? static_cast<unsigned>(remaining) : 1U;
+}
+
 } // namespace bonefish
 
 #endif // BONEFISH_DEALER_WAMP_DEALER_INVOCATION_HPP
@@ -0,0 +1,162 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_DEALER_WAMP_DEALER_PARKED_CALL_HPP
+#define BONEFISH_DEALER_WAMP_DEALER_PARKED_CALL_HPP
+
+#include <bonefish/identifiers/wamp_request_id.hpp>
+#include <bonefish/messages/wamp_call_message.hpp>
+#include <bonefish/session/wamp_session.hpp>
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace bonefish {
+
+/// A call to a procedure that is not registered yet. The call is kept
+/// until the procedure is registered or its grace period expires. The
+/// call message is copied as the original is released once it has been
+/// processed.
+class wamp_dealer_parked_call
+{
+public:
+    typedef std::function<void(const boost::system::error_code&)> expiration_callback;
+
+public:
+    wamp_dealer_parked_call(boost::asio::io_service& io_service,
+            const wamp_request_id& request_id, const std::shared_ptr<wamp_session>& session,
+            const wamp_call_message* call_message);
+    ~wamp_dealer_parked_call();
+
+    /// Arms the timer that fails the call with the given error once it
+    /// expires.
+    void set_expiration(expiration_callback callback, unsigned expiration_ms,
+            const std::string& error);
+
+    /// The timeout of the call itself. The time spent parked counts towards
+    /// it. A timeout of 0 means that the call never times out.
+    void set_timeout(unsigned timeout_ms);
+
+    const wamp_request_id& get_request_id() const;
+    const std::shared_ptr<wamp_session>& get_session() const;
+    const wamp_call_message* get_call_message() const;
+    const std::string& get_error() const;
+
+    /// The time that is left until the call times out.
+    bool has_timeout() const;
+    bool is_expired() const;
+    unsigned get_remaining_ms() const;
+
+private:
+    /// Identifies the parked call inside of the dealer. It is unrelated to
+    /// the request id of the call itself.
+    wamp_request_id m_request_id;
+    std::shared_ptr<wamp_session> m_session;
+    std::unique_ptr<wamp_call_message> m_call_message;
+    std::string m_error;
+    bool m_has_timeout;
+    std::chrono::steady_clock::time_point m_deadline;
+    boost::asio::deadline_timer m_expiration_timer;
+};
+
+inline wamp_dealer_parked_call::wamp_dealer_parked_call(boost::asio::io_service& io_service,
+        const wamp_request_id& request_id, const std::shared_ptr<wamp_session>& session,
+        const wamp_call_message* call_message)
+    : m_request_id(request_id)
+    , m_session(session)
+    , m_call_message(new wamp_call_message)
+    , m_error()
+    , m_has_timeout(false)
+    , m_deadline()
+    , m_expiration_timer(io_service)
+{
+    m_call_message->set_request_id(call_message->get_request_id());
+    m_call_message->set_options(call_message->get_options());
+    m_call_message->set_procedure(call_message->get_procedure());
+    m_call_message->set_arguments(call_message->get_arguments());
+    m_call_message->set_arguments_kw(call_message->get_arguments_kw());
+}
+
+inline wamp_dealer_parked_call::~wamp_dealer_parked_call()
+{
+    m_expiration_timer.cancel();
+}
+
+inline void wamp_dealer_parked_call::set_expiration(expiration_callback callback,
+        unsigned expiration_ms, const std::string& error)
+{
+    m_error = error;
+    m_expiration_timer.expires_from_now(boost::posix_time::milliseconds(expiration_ms));
+    m_expiration_timer.async_wait(callback);
+}
+
+inline void wamp_dealer_parked_call::set_timeout(unsigned timeout_ms)
+{
+    if (timeout_ms) {
+        m_has_timeout = true;
+        m_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    }
+}
+
+inline const wamp_request_id& wamp_dealer_parked_call::get_request_id() const
+{
+    return m_request_id;
+}
+
+inline const std::shared_ptr<wamp_session>& wamp_dealer_parked_call::get_session() const
+{
+    return m_session;
+}
+
+inline const wamp_call_message* wamp_dealer_parked_call::get_call_message() const
+{
+    return m_call_message.get();
+}
+
+inline const std::string& wamp_dealer_parked_call::get_error() const
+{
+    return m_error;
+}
+
+inline bool wamp_dealer_parked_call::has_timeout() const
+{
+    return m_has_timeout;
+}
+
+inline bool wamp_dealer_parked_call::is_expired() const
+{
+    return m_has_timeout && std::chrono::steady_clock::now() >= m_deadline;
+}
+
+inline unsigned wamp_dealer_parked_call::get_remaining_ms() const
+{
+    if (is_expired()) {
+        return 0;
+    }
+
+    // A timeout of zero means no timeout at all so anything left is
+    // rounded up to at least a millisecond.
+    const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            m_deadline - std::chrono::steady_clock::now()).count();
+    return remaining > 0 ? static_cast<unsigned>(remaining) : 1U;
+}
+
+} // namespace bonefish
+
+#endif // BONEFISH_DEALER_WAMP_DEALER_PARKED_CALL_HPP
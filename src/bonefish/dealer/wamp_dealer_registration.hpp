@@ -17,18 +17,38 @@
 #ifndef BONEFISH_DEALER_WAMP_DEALER_SUBSCRIPTION_HPP
 #define BONEFISH_DEALER_WAMP_DEALER_SUBSCRIPTION_HPP
 
+#include <bonefish/dealer/wamp_dealer_call_queue.hpp>
+#include <bonefish/dealer/wamp_dealer_hash_ring.hpp>
+#include <bonefish/dealer/wamp_dealer_result_cache.hpp>
+#include <bonefish/dealer/wamp_invoke_policy.hpp>
+#include <bonefish/dealer/wamp_match_policy.hpp>
+#include <bonefish/dealer/wamp_procedure.hpp>
 #include <bonefish/identifiers/wamp_registration_id.hpp>
 #include <bonefish/session/wamp_session.hpp>
 
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
 #include <unordered_set>
+#include <vector>
 
 namespace bonefish {
 
+/// A registered procedure. The procedure is either implemented by one or
+/// more callee sessions or by a procedure that runs inside of the router in
+/// which case there is no session.
 class wamp_dealer_registration
 {
 public:
     wamp_dealer_registration();
     wamp_dealer_registration(const std::shared_ptr<wamp_session>& session,
+            const wamp_registration_id& registration_id,
+            const std::string& node_key = std::string());
+    wamp_dealer_registration(const wamp_procedure& procedure,
+            const wamp_registration_id& registration_id);
+    wamp_dealer_registration(const wamp_async_procedure& procedure,
             const wamp_registration_id& registration_id);
     ~wamp_dealer_registration();
 
@@ -36,23 +56,140 @@ public:
     void set_registration_id(const wamp_registration_id& registration_id);
 
     const wamp_registration_id& get_registration_id() const;
-    const std::shared_ptr<wamp_session>& get_session() const;
+
+    /// The callees of the registration. Registrations are shared between
+    /// callees unless they use the single invoke policy. The node key places
+    /// the callee on the hash ring of the key policy. Callees without a node
+    /// key are placed by their session id.
+    void add_session(const std::shared_ptr<wamp_session>& session,
+            const std::string& node_key = std::string());
+    bool remove_session(const std::shared_ptr<wamp_session>& session);
+    const std::vector<std::shared_ptr<wamp_session>>& get_sessions() const;
+
+    /// Whether one of the callees has been placed on the hash ring by the
+    /// given node key.
+    bool has_node_key(const std::string& node_key) const;
+
+    void set_invoke_policy(wamp_invoke_policy policy);
+    wamp_invoke_policy get_invoke_policy() const;
+
+    /// Selects the callee that the next call is invoked on according to
+    /// the invoke policy. The key is only used by the key policy.
+    const std::shared_ptr<wamp_session>& next_session(const std::string& key);
+
+    /// The pattern of a prefix or wildcard registration. Exact registrations
+    /// are tracked through the uri table and leave the pattern empty.
+    void set_pattern(wamp_match_policy policy, const std::string& pattern);
+    wamp_match_policy get_match_policy() const;
+    const std::string& get_pattern() const;
+
+    /// The cache for the results of a procedure that was registered as
+    /// cacheable. Dropping the registration invalidates its cache.
+    void set_result_cache(const std::shared_ptr<wamp_dealer_result_cache>& result_cache);
+    const std::shared_ptr<wamp_dealer_result_cache>& get_result_cache() const;
+
+    /// Whether identical concurrent calls share a single invocation.
+    void set_coalescing(bool coalescing);
+    bool is_coalescing() const;
+
+    /// Limits the outstanding invocations of the registration. A registration
+    /// without a call queue has no limit.
+    void set_call_queue(const std::shared_ptr<wamp_dealer_call_queue>& call_queue);
+    const std::shared_ptr<wamp_dealer_call_queue>& get_call_queue() const;
+
+    bool is_native() const;
+    const wamp_procedure& get_procedure() const;
+    const wamp_async_procedure& get_async_procedure() const;
+
+private:
+    std::string get_node_key(size_t index) const;
 
 private:
-    std::shared_ptr<wamp_session> m_session;
+    std::vector<std::shared_ptr<wamp_session>> m_sessions;
+
+    /// The node keys of the callees in the same order as the callees.
+    std::vector<std::string> m_node_keys;
+    wamp_invoke_policy m_invoke_policy;
+    size_t m_next_session;
+    wamp_dealer_hash_ring m_hash_ring;
     wamp_registration_id m_registration_id;
+    wamp_procedure m_procedure;
+    wamp_async_procedure m_async_procedure;
+    wamp_match_policy m_match_policy;
+    std::string m_pattern;
+    std::shared_ptr<wamp_dealer_result_cache> m_result_cache;
+    bool m_coalescing;
+    std::shared_ptr<wamp_dealer_call_queue> m_call_queue;
 };
 
 inline wamp_dealer_registration::wamp_dealer_registration()
-    : m_session()
+    : m_sessions()
+    , m_node_keys()
+    , m_invoke_policy(wamp_invoke_policy::SINGLE)
+    , m_next_session(0)
+    , m_hash_ring()
     , m_registration_id()
+    , m_procedure()
+    , m_async_procedure()
+    , m_match_policy(wamp_match_policy::EXACT)
+    , m_pattern()
+    , m_result_cache()
+    , m_coalescing(false)
+    , m_call_queue()
 {
 }
 
 inline wamp_dealer_registration::wamp_dealer_registration(const std::shared_ptr<wamp_session>& session,
+        const wamp_registration_id& registration_id, const std::string& node_key)
+    : m_sessions(1, session)
+    , m_node_keys(1, node_key)
+    , m_invoke_policy(wamp_invoke_policy::SINGLE)
+    , m_next_session(0)
+    , m_hash_ring()
+    , m_registration_id(registration_id)
+    , m_procedure()
+    , m_async_procedure()
+    , m_match_policy(wamp_match_policy::EXACT)
+    , m_pattern()
+    , m_result_cache()
+    , m_coalescing(false)
+    , m_call_queue()
+{
+}
+
+inline wamp_dealer_registration::wamp_dealer_registration(const wamp_procedure& procedure,
+        const wamp_registration_id& registration_id)
+    : m_sessions()
+    , m_node_keys()
+    , m_invoke_policy(wamp_invoke_policy::SINGLE)
+    , m_next_session(0)
+    , m_hash_ring()
+    , m_registration_id(registration_id)
+    , m_procedure(procedure)
+    , m_async_procedure()
+    , m_match_policy(wamp_match_policy::EXACT)
+    , m_pattern()
+    , m_result_cache()
+    , m_coalescing(false)
+    , m_call_queue()
+{
+}
+
+inline wamp_dealer_registration::wamp_dealer_registration(const wamp_async_procedure& procedure,
         const wamp_registration_id& registration_id)
-    : m_session(session)
+    : m_sessions()
+    , m_node_keys()
+    , m_invoke_policy(wamp_invoke_policy::SINGLE)
+    , m_next_session(0)
+    , m_hash_ring()
     , m_registration_id(registration_id)
+    , m_procedure()
+    , m_async_procedure(procedure)
+    , m_match_policy(wamp_match_policy::EXACT)
+    , m_pattern()
+    , m_result_cache()
+    , m_coalescing(false)
+    , m_call_queue()
 {
 }
 
@@ -62,7 +199,15 @@ inline wamp_dealer_registration::~wamp_dealer_registration()
 
 inline void wamp_dealer_registration::set_session(const std::shared_ptr<wamp_session>& session)
 {
-    m_session = session;
+    for (size_t index = 0; index < m_sessions.size(); ++index) {
+        m_hash_ring.erase(get_node_key(index), m_sessions[index]->get_session_id());
+    }
+
+    m_sessions.assign(1, session);
+    m_node_keys.assign(1, std::string());
+    if (m_invoke_policy == wamp_invoke_policy::KEY) {
+        m_hash_ring.insert(get_node_key(0), session->get_session_id());
+    }
 }
 
 inline void wamp_dealer_registration::set_registration_id(const wamp_registration_id& registration_id)
@@ -70,14 +215,168 @@ inline void wamp_dealer_registration::set_registration_id(const wamp_registratio
     m_registration_id = registration_id;
 }
 
-inline const std::shared_ptr<wamp_session>& wamp_dealer_registration::get_session() const
+inline const wamp_registration_id& wamp_dealer_registration::get_registration_id() const
 {
-    return m_session;
+    return m_registration_id;
 }
 
-inline const wamp_registration_id& wamp_dealer_registration::get_registration_id() const
+inline void wamp_dealer_registration::add_session(const std::shared_ptr<wamp_session>& session,
+        const std::string& node_key)
 {
-    return m_registration_id;
+    m_sessions.push_back(session);
+    m_node_keys.push_back(node_key);
+    if (m_invoke_policy == wamp_invoke_policy::KEY) {
+        m_hash_ring.insert(get_node_key(m_sessions.size() - 1), session->get_session_id());
+    }
+}
+
+inline bool wamp_dealer_registration::remove_session(const std::shared_ptr<wamp_session>& session)
+{
+    auto sessions_itr = std::find(m_sessions.begin(), m_sessions.end(), session);
+    if (sessions_itr == m_sessions.end()) {
+        return false;
+    }
+
+    const size_t index = sessions_itr - m_sessions.begin();
+    m_hash_ring.erase(get_node_key(index), session->get_session_id());
+    m_sessions.erase(sessions_itr);
+    m_node_keys.erase(m_node_keys.begin() + index);
+    return true;
+}
+
+inline const std::vector<std::shared_ptr<wamp_session>>&
+wamp_dealer_registration::get_sessions() const
+{
+    return m_sessions;
+}
+
+inline bool wamp_dealer_registration::has_node_key(const std::string& node_key) const
+{
+    return std::find(m_node_keys.begin(), m_node_keys.end(), node_key) != m_node_keys.end();
+}
+
+inline void wamp_dealer_registration::set_invoke_policy(wamp_invoke_policy policy)
+{
+    // Only registrations that route calls by key keep a hash ring.
+    m_invoke_policy = policy;
+    for (size_t index = 0; index < m_sessions.size(); ++index) {
+        const wamp_session_id& session_id = m_sessions[index]->get_session_id();
+        if (m_invoke_policy == wamp_invoke_policy::KEY) {
+            m_hash_ring.insert(get_node_key(index), session_id);
+        } else {
+            m_hash_ring.erase(get_node_key(index), session_id);
+        }
+    }
+}
+
+inline wamp_invoke_policy wamp_dealer_registration::get_invoke_policy() const
+{
+    return m_invoke_policy;
+}
+
+inline const std::shared_ptr<wamp_session>& wamp_dealer_registration::next_session(
+        const std::string& key)
+{
+    if (m_sessions.empty()) {
+        throw std::logic_error("registration has no callees");
+    }
+
+    switch (m_invoke_policy) {
+        case wamp_invoke_policy::LAST:
+            return m_sessions.back();
+        case wamp_invoke_policy::ROUNDROBIN:
+            m_next_session = (m_next_session + 1) % m_sessions.size();
+            return m_sessions[m_next_session];
+        case wamp_invoke_policy::KEY:
+        {
+            const wamp_session_id& session_id = m_hash_ring.find(key);
+            for (const auto& session : m_sessions) {
+                if (session->get_session_id() == session_id) {
+                    return session;
+                }
+            }
+            throw std::logic_error("registration hash ring out of sync");
+        }
+        default:
+            return m_sessions.front();
+    }
+}
+
+inline void wamp_dealer_registration::set_pattern(wamp_match_policy policy,
+        const std::string& pattern)
+{
+    m_match_policy = policy;
+    m_pattern = pattern;
+}
+
+inline wamp_match_policy wamp_dealer_registration::get_match_policy() const
+{
+    return m_match_policy;
+}
+
+inline const std::string& wamp_dealer_registration::get_pattern() const
+{
+    return m_pattern;
+}
+
+inline void wamp_dealer_registration::set_result_cache(
+        const std::shared_ptr<wamp_dealer_result_cache>& result_cache)
+{
+    m_result_cache = result_cache;
+}
+
+inline const std::shared_ptr<wamp_dealer_result_cache>&
+wamp_dealer_registration::get_result_cache() const
+{
+    return m_result_cache;
+}
+
+inline void wamp_dealer_registration::set_coalescing(bool coalescing)
+{
+    m_coalescing = coalescing;
+}
+
+inline bool wamp_dealer_registration::is_coalescing() const
+{
+    return m_coalescing;
+}
+
+inline void wamp_dealer_registration::set_call_queue(
+        const std::shared_ptr<wamp_dealer_call_queue>& call_queue)
+{
+    m_call_queue = call_queue;
+}
+
+inline const std::shared_ptr<wamp_dealer_call_queue>&
+wamp_dealer_registration::get_call_queue() const
+{
+    return m_call_queue;
+}
+
+inline bool wamp_dealer_registration::is_native() const
+{
+    return m_sessions.empty();
+}
+
+inline const wamp_procedure& wamp_dealer_registration::get_procedure() const
+{
+    return m_procedure;
+}
+
+inline const wamp_async_procedure& wamp_dealer_registration::get_async_procedure() const
+{
+    return m_async_procedure;
+}
+
+inline std::string wamp_dealer_registration::get_node_key(size_t index) const
+{
+    // Session ids are random so callees without a node key are placed on
+    // the ring differently every time that they connect.
+    if (!m_node_keys[index].empty()) {
+        return m_node_keys[index];
+    }
+
+    return "session:" + std::to_string(m_sessions[index]->get_session_id().id());
 }
 
 } // namespace bonefish
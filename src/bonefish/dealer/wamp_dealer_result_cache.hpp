@@ -0,0 +1,202 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_DEALER_WAMP_DEALER_RESULT_CACHE_HPP
+#define BONEFISH_DEALER_WAMP_DEALER_RESULT_CACHE_HPP
+
+#include <boost/functional/hash.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <chrono>
+#include <cstddef>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <msgpack.hpp>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace bonefish {
+
+/// A bounded LRU of the results of a procedure that was registered as
+/// cacheable. Entries are keyed by the called procedure along with its
+/// serialized arguments and expire after a fixed time to live. The size
+/// of an entry is its key plus its serialized result.
+class wamp_dealer_result_cache
+{
+public:
+    /// The maximum size used when a registration only specifies a ttl.
+    static const size_t DEFAULT_MAX_SIZE = 1024 * 1024;
+
+    struct result
+    {
+        msgpack::object arguments;
+        msgpack::object arguments_kw;
+    };
+
+public:
+    wamp_dealer_result_cache(unsigned ttl_ms, size_t max_size);
+    ~wamp_dealer_result_cache();
+
+    wamp_dealer_result_cache(const wamp_dealer_result_cache&) = delete;
+    wamp_dealer_result_cache& operator=(const wamp_dealer_result_cache&) = delete;
+
+    /// Builds the key for a call to the procedure with the given arguments.
+    static std::string make_key(const boost::string_ref& procedure,
+            const msgpack::object& arguments, const msgpack::object& arguments_kw);
+
+    /// Finds an unexpired result for the key and marks it as the most
+    /// recently used. Returns nullptr on a miss.
+    const result* find(const std::string& key);
+
+    /// Caches the result for the key and returns the number of entries that
+    /// had to be evicted to make room for it. Results that are larger than
+    /// the cache are not cached.
+    size_t insert(const std::string& key, const msgpack::object& arguments,
+            const msgpack::object& arguments_kw);
+
+    size_t get_size() const;
+
+private:
+    struct entry
+    {
+        std::string key;
+        std::unique_ptr<msgpack::zone> zone;
+        result value;
+        size_t size;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    struct key_hash
+    {
+        size_t operator()(const boost::string_ref& key) const
+        {
+            return boost::hash_range(key.begin(), key.end());
+        }
+    };
+
+    void erase(std::list<entry>::iterator entries_itr);
+
+private:
+    const std::chrono::milliseconds m_ttl;
+    const size_t m_max_size;
+    size_t m_size;
+
+    /// The entries ordered from the most to the least recently used. The
+    /// index refers to the keys stored in the entries.
+    std::list<entry> m_entries;
+    std::unordered_map<boost::string_ref, std::list<entry>::iterator, key_hash> m_index;
+};
+
+inline wamp_dealer_result_cache::wamp_dealer_result_cache(unsigned ttl_ms, size_t max_size)
+    : m_ttl(ttl_ms)
+    , m_max_size(max_size)
+    , m_size(0)
+    , m_entries()
+    , m_index()
+{
+}
+
+inline wamp_dealer_result_cache::~wamp_dealer_result_cache()
+{
+}
+
+inline std::string wamp_dealer_result_cache::make_key(const boost::string_ref& procedure,
+        const msgpack::object& arguments, const msgpack::object& arguments_kw)
+{
+    // The procedure is part of the key because a pattern registration is
+    // called through many procedures. It cannot contain a nul character so
+    // it is unambiguously separated from the serialized arguments.
+    msgpack::sbuffer buffer;
+    buffer.write(procedure.data(), procedure.size());
+    buffer.write("", 1);
+    msgpack::pack(buffer, arguments);
+    msgpack::pack(buffer, arguments_kw);
+
+    return std::string(buffer.data(), buffer.size());
+}
+
+inline const wamp_dealer_result_cache::result* wamp_dealer_result_cache::find(
+        const std::string& key)
+{
+    auto index_itr = m_index.find(key);
+    if (index_itr == m_index.end()) {
+        return nullptr;
+    }
+
+    auto entries_itr = index_itr->second;
+    if (entries_itr->expires <= std::chrono::steady_clock::now()) {
+        erase(entries_itr);
+        return nullptr;
+    }
+
+    m_entries.splice(m_entries.begin(), m_entries, entries_itr);
+    return &entries_itr->value;
+}
+
+inline size_t wamp_dealer_result_cache::insert(const std::string& key,
+        const msgpack::object& arguments, const msgpack::object& arguments_kw)
+{
+    msgpack::sbuffer buffer;
+    msgpack::pack(buffer, arguments);
+    msgpack::pack(buffer, arguments_kw);
+
+    const size_t size = key.size() + buffer.size();
+    if (size > m_max_size) {
+        return 0;
+    }
+
+    auto index_itr = m_index.find(key);
+    if (index_itr != m_index.end()) {
+        erase(index_itr->second);
+    }
+
+    size_t evictions = 0;
+    while (m_size + size > m_max_size) {
+        erase(std::prev(m_entries.end()));
+        ++evictions;
+    }
+
+    m_entries.emplace_front();
+    entry& cached = m_entries.front();
+    cached.key = key;
+    cached.zone.reset(new msgpack::zone);
+    cached.value.arguments = msgpack::object(arguments, *cached.zone);
+    cached.value.arguments_kw = msgpack::object(arguments_kw, *cached.zone);
+    cached.size = size;
+    cached.expires = std::chrono::steady_clock::now() + m_ttl;
+
+    m_index.insert(std::make_pair(boost::string_ref(cached.key), m_entries.begin()));
+    m_size += size;
+
+    return evictions;
+}
+
+inline size_t wamp_dealer_result_cache::get_size() const
+{
+    return m_size;
+}
+
+inline void wamp_dealer_result_cache::erase(std::list<entry>::iterator entries_itr)
+{
+    m_size -= entries_itr->size;
+    m_index.erase(boost::string_ref(entries_itr->key));
+    m_entries.erase(entries_itr);
+}
+
+} // namespace bonefish
+
+#endif // BONEFISH_DEALER_WAMP_DEALER_RESULT_CACHE_HPP
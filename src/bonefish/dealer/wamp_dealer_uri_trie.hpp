@@ -0,0 +1,358 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_DEALER_WAMP_DEALER_URI_TRIE_HPP
+#define BONEFISH_DEALER_WAMP_DEALER_URI_TRIE_HPP
+
+#include <bonefish/dealer/wamp_match_policy.hpp>
+
+#include <boost/functional/hash.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace bonefish {
+
+class wamp_dealer_registration;
+
+/// Resolves procedures against prefix and wildcard registrations. The trie
+/// is keyed by uri components so a lookup walks the components of the
+/// procedure once without copying them. The longest matching prefix wins over any wildcard.
+///
+/// A wildcard lookup prefers exact components over wildcard components from
+/// left to right. It walks all candidate nodes one component at a time
+/// rather than backtracking. Every node lies on the pattern of at least one
+/// registration so there are never more candidates per component than there
+/// are wildcard registrations. A lookup is therefore linear in the number of
+/// components as long as exact and wildcard components do not overlap and
+/// O(components * wildcard registrations) in the worst case.
+class wamp_dealer_uri_trie
+{
+public:
+    wamp_dealer_uri_trie();
+    ~wamp_dealer_uri_trie();
+
+    /// Adds a registration for the pattern. Returns false if the pattern is
+    /// already registered with the same policy.
+    bool insert(wamp_match_policy policy, const std::string& pattern,
+            wamp_dealer_registration* registration);
+
+    /// Removes the registration for the pattern. Returns false if there is
+    /// no such registration.
+    bool erase(wamp_match_policy policy, const std::string& pattern);
+
+    /// Finds the registration that the procedure resolves to or nullptr if
+    /// there is none.
+    wamp_dealer_registration* match(const boost::string_ref& procedure) const;
+
+private:
+    struct component_hash
+    {
+        size_t operator()(const boost::string_ref& component) const
+        {
+            return boost::hash_range(component.begin(), component.end());
+        }
+    };
+
+    struct node
+    {
+        explicit node(const boost::string_ref& component)
+            : key(component.begin(), component.end()), children(), prefixes(), wildcard(nullptr) {}
+
+        /// The uri component of the node. The node is heap allocated so the
+        /// key of its parent's children can refer to it.
+        const std::string key;
+
+        /// Child nodes keyed by uri component. Wildcard components are
+        /// stored under the empty key.
+        std::unordered_map<boost::string_ref, std::unique_ptr<node>, component_hash> children;
+
+        /// Prefix registrations that end within the next component along
+        /// with the leading part of that component that they match.
+        std::vector<std::pair<std::string, wamp_dealer_registration*>> prefixes;
+
+        /// The wildcard registration whose pattern ends at this node.
+        wamp_dealer_registration* wildcard;
+
+        bool empty() const { return children.empty() && prefixes.empty() && !wildcard; }
+    };
+
+private:
+    static bool next_component(const boost::string_ref& uri, size_t& offset,
+            boost::string_ref& component);
+    static std::vector<boost::string_ref> split(const boost::string_ref& uri);
+    static node* find_or_insert(node* parent, const boost::string_ref& component);
+    static bool erase(node* parent, const std::vector<boost::string_ref>& components,
+            size_t index, wamp_match_policy policy);
+
+    wamp_dealer_registration* match_prefix(const boost::string_ref& procedure) const;
+    wamp_dealer_registration* match_wildcard(const boost::string_ref& procedure) const;
+
+private:
+    node m_prefix_root;
+    node m_wildcard_root;
+    size_t m_size;
+
+    /// Scratch buffers for the candidate nodes of a wildcard lookup.
+    mutable std::vector<const node*> m_candidates;
+    mutable std::vector<const node*> m_next_candidates;
+};
+
+inline wamp_dealer_uri_trie::wamp_dealer_uri_trie()
+    : m_prefix_root(boost::string_ref())
+    , m_wildcard_root(boost::string_ref())
+    , m_size(0)
+    , m_candidates()
+    , m_next_candidates()
+{
+}
+
+inline wamp_dealer_uri_trie::~wamp_dealer_uri_trie()
+{
+}
+
+inline bool wamp_dealer_uri_trie::insert(wamp_match_policy policy,
+        const std::string& pattern, wamp_dealer_registration* registration)
+{
+    const std::vector<boost::string_ref> components = split(pattern);
+
+    if (policy == wamp_match_policy::PREFIX) {
+        node* current = &m_prefix_root;
+        for (size_t index = 0; index + 1 < components.size(); ++index) {
+            current = find_or_insert(current, components[index]);
+        }
+
+        const std::string partial = components.back().to_string();
+        for (const auto& prefix : current->prefixes) {
+            if (prefix.first == partial) {
+                return false;
+            }
+        }
+
+        current->prefixes.push_back(std::make_pair(partial, registration));
+    } else if (policy == wamp_match_policy::WILDCARD) {
+        node* current = &m_wildcard_root;
+        for (const auto& component : components) {
+            current = find_or_insert(current, component);
+        }
+
+        if (current->wildcard) {
+            return false;
+        }
+
+        current->wildcard = registration;
+    } else {
+        throw std::invalid_argument("invalid match policy");
+    }
+
+    ++m_size;
+    return true;
+}
+
+inline bool wamp_dealer_uri_trie::erase(wamp_match_policy policy, const std::string& pattern)
+{
+    node* root = (policy == wamp_match_policy::PREFIX) ? &m_prefix_root : &m_wildcard_root;
+    if (!erase(root, split(pattern), 0, policy)) {
+        return false;
+    }
+
+    --m_size;
+    return true;
+}
+
+inline wamp_dealer_registration* wamp_dealer_uri_trie::match(
+        const boost::string_ref& procedure) const
+{
+    // Most realms only use exact registrations so avoid walking the
+    // procedure when there is nothing to match against.
+    if (m_size == 0) {
+        return nullptr;
+    }
+
+    wamp_dealer_registration* registration = match_prefix(procedure);
+    if (!registration) {
+        registration = match_wildcard(procedure);
+    }
+
+    return registration;
+}
+
+inline bool wamp_dealer_uri_trie::next_component(const boost::string_ref& uri, size_t& offset,
+        boost::string_ref& component)
+{
+    // A uri always has one more component than it has separators so the
+    // offset moves past the end of the uri once the last one is returned.
+    if (offset > uri.size()) {
+        return false;
+    }
+
+    const boost::string_ref remainder = uri.substr(offset);
+    const size_t length = std::min(remainder.find('.'), remainder.size());
+    component = remainder.substr(0, length);
+    offset += length + 1;
+    return true;
+}
+
+inline std::vector<boost::string_ref> wamp_dealer_uri_trie::split(const boost::string_ref& uri)
+{
+    std::vector<boost::string_ref> components;
+
+    size_t offset = 0;
+    boost::string_ref component;
+    while (next_component(uri, offset, component)) {
+        components.push_back(component);
+    }
+
+    return components;
+}
+
+inline wamp_dealer_uri_trie::node* wamp_dealer_uri_trie::find_or_insert(node* parent,
+        const boost::string_ref& component)
+{
+    auto children_itr = parent->children.find(component);
+    if (children_itr != parent->children.end()) {
+        return children_itr->second.get();
+    }
+
+    std::unique_ptr<node> child(new node(component));
+    node* result = child.get();
+    parent->children.emplace(boost::string_ref(result->key), std::move(child));
+    return result;
+}
+
+inline bool wamp_dealer_uri_trie::erase(node* parent,
+        const std::vector<boost::string_ref>& components, size_t index,
+        wamp_match_policy policy)
+{
+    // Prefix registrations are stored one level above their last component
+    // whereas wildcard registrations are stored at the node of their last
+    // component.
+    if (policy == wamp_match_policy::PREFIX && index + 1 == components.size()) {
+        auto& prefixes = parent->prefixes;
+        for (auto itr = prefixes.begin(); itr != prefixes.end(); ++itr) {
+            if (itr->first == components[index]) {
+                prefixes.erase(itr);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    if (policy == wamp_match_policy::WILDCARD && index == components.size()) {
+        if (!parent->wildcard) {
+            return false;
+        }
+        parent->wildcard = nullptr;
+        return true;
+    }
+
+    auto children_itr = parent->children.find(components[index]);
+    if (children_itr == parent->children.end()) {
+        return false;
+    }
+
+    if (!erase(children_itr->second.get(), components, index + 1, policy)) {
+        return false;
+    }
+
+    if (children_itr->second->empty()) {
+        parent->children.erase(children_itr);
+    }
+
+    return true;
+}
+
+inline wamp_dealer_registration* wamp_dealer_uri_trie::match_prefix(
+        const boost::string_ref& procedure) const
+{
+    // Deeper nodes and longer partial components always make for a longer
+    // prefix so the last match found while walking down is the longest.
+    wamp_dealer_registration* registration = nullptr;
+    const node* current = &m_prefix_root;
+    size_t offset = 0;
+    boost::string_ref component;
+    while (next_component(procedure, offset, component)) {
+        size_t length = 0;
+        for (const auto& prefix : current->prefixes) {
+            if (component.starts_with(prefix.first) &&
+                    (!registration || prefix.first.size() >= length)) {
+                registration = prefix.second;
+                length = prefix.first.size();
+            }
+        }
+
+        auto children_itr = current->children.find(component);
+        if (children_itr == current->children.end()) {
+            break;
+        }
+        current = children_itr->second.get();
+    }
+
+    return registration;
+}
+
+inline wamp_dealer_registration* wamp_dealer_uri_trie::match_wildcard(
+        const boost::string_ref& procedure) const
+{
+    // The candidates are kept in order of preference. Expanding each of them
+    // into its exact child followed by its wildcard child keeps that order
+    // since earlier components take precedence over later ones. Distinct
+    // paths through the trie always end at distinct nodes so there are no
+    // duplicate candidates.
+    m_candidates.clear();
+    m_candidates.push_back(&m_wildcard_root);
+    size_t offset = 0;
+    boost::string_ref component;
+    while (next_component(procedure, offset, component)) {
+        m_next_candidates.clear();
+        for (const node* candidate : m_candidates) {
+            if (!component.empty()) {
+                auto children_itr = candidate->children.find(component);
+                if (children_itr != candidate->children.end()) {
+                    m_next_candidates.push_back(children_itr->second.get());
+                }
+            }
+
+            auto children_itr = candidate->children.find(boost::string_ref());
+            if (children_itr != candidate->children.end()) {
+                m_next_candidates.push_back(children_itr->second.get());
+            }
+        }
+
+        m_candidates.swap(m_next_candidates);
+        if (m_candidates.empty()) {
+            return nullptr;
+        }
+    }
+
+    for (const node* candidate : m_candidates) {
+        if (candidate->wildcard) {
+            return candidate->wildcard;
+        }
+    }
+
+    return nullptr;
+}
+
+} // namespace bonefish
+
+#endif // BONEFISH_DEALER_WAMP_DEALER_URI_TRIE_HPP
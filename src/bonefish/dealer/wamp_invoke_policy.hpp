@@ -0,0 +1,40 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_DEALER_WAMP_INVOKE_POLICY_HPP
+#define BONEFISH_DEALER_WAMP_INVOKE_POLICY_HPP
+
+#include <cstdint>
+
+namespace bonefish {
+
+/// Which of the callees of a shared registration a call is invoked on.
+/// Only registrations with the single policy are exclusive. The key policy
+/// keeps invoking the same callee for calls with the same key. Callees that
+/// register with the node_key option keep owning the same keys when they
+/// reconnect.
+enum class wamp_invoke_policy : uint8_t
+{
+    SINGLE,
+    FIRST,
+    LAST,
+    ROUNDROBIN,
+    KEY
+};
+
+} // namespace bonefish
+
+#endif // BONEFISH_DEALER_WAMP_INVOKE_POLICY_HPP
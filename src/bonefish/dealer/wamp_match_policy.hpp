@@ -0,0 +1,35 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_DEALER_WAMP_MATCH_POLICY_HPP
+#define BONEFISH_DEALER_WAMP_MATCH_POLICY_HPP
+
+#include <cstdint>
+
+namespace bonefish {
+
+/// How the procedure of a registration is matched against the procedure
+/// of a call.
+enum class wamp_match_policy : uint8_t
+{
+    EXACT,
+    PREFIX,
+    WILDCARD
+};
+
+} // namespace bonefish
+
+#endif // BONEFISH_DEALER_WAMP_MATCH_POLICY_HPP
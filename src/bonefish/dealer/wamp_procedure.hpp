@@ -0,0 +1,166 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_DEALER_WAMP_PROCEDURE_HPP
+#define BONEFISH_DEALER_WAMP_PROCEDURE_HPP
+
+#include <boost/utility/string_ref.hpp>
+#include <functional>
+#include <msgpack.hpp>
+#include <stdexcept>
+#include <string>
+
+namespace bonefish {
+
+/// A call to a procedure that is implemented inside of the router. The
+/// arguments reference the CALL message and are only valid until the
+/// procedure returns. Asynchronous procedures have to copy anything that
+/// they need to complete the call later on.
+class wamp_procedure_call
+{
+public:
+    wamp_procedure_call(const boost::string_ref& procedure,
+            const msgpack::object& arguments,
+            const msgpack::object& arguments_kw);
+
+    const boost::string_ref& get_procedure() const;
+    const msgpack::object& get_arguments() const;
+    const msgpack::object& get_arguments_kw() const;
+
+private:
+    boost::string_ref m_procedure;
+    const msgpack::object& m_arguments;
+    const msgpack::object& m_arguments_kw;
+};
+
+/// The outcome of a call to a procedure that is implemented inside of the
+/// router. The result values are copied into a zone owned by the result.
+/// Setting an error uri turns the result into an error response.
+class wamp_procedure_result
+{
+public:
+    wamp_procedure_result();
+
+    template <typename T>
+    void set_arguments(const T& arguments);
+
+    template <typename T>
+    void set_arguments_kw(const T& arguments_kw);
+
+    void set_error(const std::string& error);
+
+    bool is_error() const;
+    const std::string& get_error() const;
+    const msgpack::object& get_arguments() const;
+    const msgpack::object& get_arguments_kw() const;
+
+private:
+    msgpack::zone m_zone;
+    msgpack::object m_arguments;
+    msgpack::object m_arguments_kw;
+    std::string m_error;
+};
+
+/// A procedure that produces its result before returning.
+typedef std::function<void(const wamp_procedure_call&, wamp_procedure_result&)> wamp_procedure;
+
+/// Completes a call to an asynchronous procedure. It must be invoked on the
+/// router's io service. Completions after the call has timed out or after
+/// the caller has left are dropped.
+typedef std::function<void(const wamp_procedure_result&)> wamp_procedure_completion;
+
+/// A procedure that completes the call at some later point.
+typedef std::function<void(const wamp_procedure_call&,
+        const wamp_procedure_completion&)> wamp_async_procedure;
+
+inline wamp_procedure_call::wamp_procedure_call(const boost::string_ref& procedure,
+        const msgpack::object& arguments,
+        const msgpack::object& arguments_kw)
+    : m_procedure(procedure)
+    , m_arguments(arguments)
+    , m_arguments_kw(arguments_kw)
+{
+}
+
+inline const boost::string_ref& wamp_procedure_call::get_procedure() const
+{
+    return m_procedure;
+}
+
+inline const msgpack::object& wamp_procedure_call::get_arguments() const
+{
+    return m_arguments;
+}
+
+inline const msgpack::object& wamp_procedure_call::get_arguments_kw() const
+{
+    return m_arguments_kw;
+}
+
+inline wamp_procedure_result::wamp_procedure_result()
+    : m_zone()
+    , m_arguments()
+    , m_arguments_kw()
+    , m_error()
+{
+}
+
+template <typename T>
+void wamp_procedure_result::set_arguments(const T& arguments)
+{
+    m_arguments = msgpack::object(arguments, m_zone);
+    if (m_arguments.type != msgpack::type::ARRAY) {
+        throw std::invalid_argument("invalid arguments");
+    }
+}
+
+template <typename T>
+void wamp_procedure_result::set_arguments_kw(const T& arguments_kw)
+{
+    m_arguments_kw = msgpack::object(arguments_kw, m_zone);
+    if (m_arguments_kw.type != msgpack::type::MAP) {
+        throw std::invalid_argument("invalid arguments_kw");
+    }
+}
+
+inline void wamp_procedure_result::set_error(const std::string& error)
+{
+    m_error = error;
+}
+
+inline bool wamp_procedure_result::is_error() const
+{
+    return !m_error.empty();
+}
+
+inline const std::string& wamp_procedure_result::get_error() const
+{
+    return m_error;
+}
+
+inline const msgpack::object& wamp_procedure_result::get_arguments() const
+{
+    return m_arguments;
+}
+
+inline const msgpack::object& wamp_procedure_result::get_arguments_kw() const
+{
+    return m_arguments_kw;
+}
+
+} // namespace bonefish
+
+#endif // BONEFISH_DEALER_WAMP_PROCEDURE_HPP
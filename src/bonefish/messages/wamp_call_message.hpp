@@ -23,6 +23,7 @@
 #include <bonefish/messages/wamp_message_defaults.hpp>
 #include <bonefish/utility/wamp_uri.hpp>
 
+#include <boost/utility/string_ref.hpp>
 #include <cstddef>
 #include <msgpack.hpp>
 #include <ostream>
@@ -51,6 +52,7 @@ public:
     wamp_request_id get_request_id() const;
     const msgpack::object& get_options() const;
     std::string get_procedure() const;
+    boost::string_ref get_procedure_ref() const;
     const msgpack::object& get_arguments() const;
     const msgpack::object& get_arguments_kw() const;
 
@@ -152,6 +154,15 @@ inline std::string wamp_call_message::get_procedure() const
     return m_procedure.as<std::string>();
 }
 
+inline boost::string_ref wamp_call_message::get_procedure_ref() const
+{
+    if (m_procedure.type != msgpack::type::STR) {
+        throw msgpack::type_error();
+    }
+
+    return boost::string_ref(m_procedure.via.str.ptr, m_procedure.via.str.size);
+}
+
 inline const msgpack::object& wamp_call_message::get_arguments() const
 {
     return m_arguments;
@@ -17,10 +17,12 @@
 #include <bonefish/messages/wamp_message_factory.hpp>
 #include <bonefish/messages/wamp_abort_message.hpp>
 #include <bonefish/messages/wamp_call_message.hpp>
+#include <bonefish/messages/wamp_cancel_message.hpp>
 #include <bonefish/messages/wamp_error_message.hpp>
 #include <bonefish/messages/wamp_event_message.hpp>
 #include <bonefish/messages/wamp_goodbye_message.hpp>
 #include <bonefish/messages/wamp_hello_message.hpp>
+#include <bonefish/messages/wamp_interrupt_message.hpp>
 #include <bonefish/messages/wamp_invocation_message.hpp>
 #include <bonefish/messages/wamp_message.hpp>
 #include <bonefish/messages/wamp_publish_message.hpp>
@@ -95,7 +97,7 @@ wamp_message* create_message(wamp_message_type type)
             message = new wamp_call_message;
             break;
         case wamp_message_type::CANCEL:
-            message = nullptr;
+            message = new wamp_cancel_message;
             break;
         case wamp_message_type::RESULT:
             message = new wamp_result_message;
@@ -116,7 +118,7 @@ wamp_message* create_message(wamp_message_type type)
             message = new wamp_invocation_message;
             break;
         case wamp_message_type::INTERRUPT:
-            message = nullptr;
+            message = new wamp_interrupt_message;
             break;
         case wamp_message_type::YIELD:
             message = new wamp_yield_message;
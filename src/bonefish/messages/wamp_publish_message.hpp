@@ -23,6 +23,7 @@
 #include <bonefish/messages/wamp_message_type.hpp>
 #include <bonefish/utility/wamp_uri.hpp>
 
+#include <boost/utility/string_ref.hpp>
 #include <cstddef>
 #include <msgpack.hpp>
 #include <ostream>
@@ -51,6 +52,7 @@ public:
     wamp_request_id get_request_id() const;
     const msgpack::object& get_options() const;
     std::string get_topic() const;
+    boost::string_ref get_topic_ref() const;
     const msgpack::object& get_arguments() const;
     const msgpack::object& get_arguments_kw() const;
 
@@ -150,6 +152,15 @@ inline std::string wamp_publish_message::get_topic() const
     return m_topic.as<std::string>();
 }
 
+inline boost::string_ref wamp_publish_message::get_topic_ref() const
+{
+    if (m_topic.type != msgpack::type::STR) {
+        throw msgpack::type_error();
+    }
+
+    return boost::string_ref(m_topic.via.str.ptr, m_topic.via.str.size);
+}
+
 inline const msgpack::object& wamp_publish_message::get_arguments() const
 {
     return m_arguments;
@@ -23,6 +23,7 @@
 #include <bonefish/messages/wamp_message_type.hpp>
 #include <bonefish/utility/wamp_uri.hpp>
 
+#include <boost/utility/string_ref.hpp>
 #include <cstddef>
 #include <msgpack.hpp>
 #include <ostream>
@@ -49,6 +50,7 @@ public:
     wamp_request_id get_request_id() const;
     const msgpack::object& get_options() const;
     std::string get_procedure() const;
+    boost::string_ref get_procedure_ref() const;
 
     void set_request_id(const wamp_request_id& request_id);
     void set_options(const msgpack::object& options);
@@ -120,6 +122,15 @@ inline std::string wamp_register_message::get_procedure() const
     return m_procedure.as<std::string>();
 }
 
+inline boost::string_ref wamp_register_message::get_procedure_ref() const
+{
+    if (m_procedure.type != msgpack::type::STR) {
+        throw msgpack::type_error();
+    }
+
+    return boost::string_ref(m_procedure.via.str.ptr, m_procedure.via.str.size);
+}
+
 inline void wamp_register_message::set_request_id(const wamp_request_id& request_id)
 {
     m_request_id = msgpack::object(request_id.id());
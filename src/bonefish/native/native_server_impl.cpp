@@ -126,6 +126,10 @@ std::shared_ptr<native_server_endpoint> native_server_impl::on_connect(
     };
     connection->set_disconnected_handler(std::bind(disconnected_handler, server_endpoint));
 
+    // The transport is created once per connection and is shared by any
+    // sessions that are established over the connection.
+    connection->set_transport(std::make_shared<native_transport>(connection));
+
     m_connections.insert(connection);
     m_endpoints_connected[server_endpoint] = connection;
 
@@ -142,13 +146,15 @@ std::shared_ptr<native_component_endpoint> native_server_impl::on_disconnect(
 
     auto connection = itr->second;
     if (connection->has_session_id()) {
-        std::shared_ptr<wamp_router> router =
-                m_routers->get_router(connection->get_realm());
+        const std::shared_ptr<wamp_router>& router = connection->get_router();
         if (router) {
-            router->detach_session(connection->get_session_id());
+            router->detach_session(connection->get_session_slot());
         }
     }
 
+    // The transport holds a reference to the connection so it has to be
+    // released here in order for the connection to be destroyed.
+    connection->set_transport(nullptr);
     m_endpoints_connected.erase(itr);
     m_connections.erase(connection);
 
@@ -172,8 +178,7 @@ void native_server_impl::on_message(
         }
         message->unmarshal(fields, std::move(zone));
 
-        std::unique_ptr<wamp_transport> transport(new native_transport(connection));
-        m_message_processor.process_message(message, std::move(transport), connection.get());
+        m_message_processor.process_message(message, connection.get());
     } catch (const std::exception& e) {
         BONEFISH_TRACE("unhandled exception: %1%", e.what());
     }
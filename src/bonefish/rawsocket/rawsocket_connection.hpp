@@ -23,6 +23,7 @@
 #include <arpa/inet.h>
 #include <boost/asio/buffer.hpp>
 #include <boost/asio/error.hpp>
+#include <boost/asio/io_service.hpp>
 #include <boost/system/error_code.hpp>
 #include <cstdint>
 #include <functional>
@@ -55,11 +56,23 @@ public:
             size_t length,
             boost::system::error_code& error_code) = 0;
 
+    /// The io service that services the connection or null if connections
+    /// of this type are always serviced by the io service of the routers.
+    virtual boost::asio::io_service* get_io_service();
+
+    /// Closes the connection ahead of its destruction. This must be called
+    /// from the thread that services the connection.
+    virtual void close();
+
     void async_handshake();
-    void async_receive();
+
+    /// Starts receiving length prefixed messages. Connections over sockets
+    /// that preserve message boundaries override this and send_message to
+    /// do without the length prefix.
+    virtual void async_receive();
 
     bool send_handshake(uint32_t capabilities);
-    bool send_message(const char* message, size_t length);
+    virtual bool send_message(const char* message, size_t length);
 
     const close_handler& get_close_handler() const;
     const fail_handler& get_fail_handler() const;
@@ -71,6 +84,9 @@ public:
     void set_message_handler(const message_handler& handler);
     void set_handshake_handler(const handshake_handler& handler);
 
+protected:
+    void handle_system_error(const boost::system::error_code& error_code);
+
 private:
     void receive_handshake_handler(
             const boost::system::error_code& error_code, size_t bytes_transferred);
@@ -79,8 +95,6 @@ private:
     void receive_message_body_handler(
             const boost::system::error_code& error_code, size_t bytes_transferred);
 
-    void handle_system_error(const boost::system::error_code& error_code);
-
 private:
     close_handler m_close_handler;
     fail_handler m_fail_handler;
@@ -108,6 +122,15 @@ inline rawsocket_connection::~rawsocket_connection()
 {
 }
 
+inline boost::asio::io_service* rawsocket_connection::get_io_service()
+{
+    return nullptr;
+}
+
+inline void rawsocket_connection::close()
+{
+}
+
 inline void rawsocket_connection::async_handshake()
 {
     std::weak_ptr<rawsocket_connection> weak_self =
@@ -29,6 +29,14 @@ rawsocket_server::rawsocket_server(
 {
 }
 
+rawsocket_server::rawsocket_server(
+        boost::asio::io_service& io_service,
+        const std::shared_ptr<wamp_routers>& routers,
+        const std::shared_ptr<wamp_serializers>& serializers)
+    : m_impl(new rawsocket_server_impl(io_service, routers, serializers))
+{
+}
+
 rawsocket_server::~rawsocket_server()
 {
 }
@@ -17,6 +17,7 @@
 #ifndef BONEFISH_RAWSOCKET_SERVER_HPP
 #define BONEFISH_RAWSOCKET_SERVER_HPP
 
+#include <boost/asio/io_service.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <set>
 #include <memory>
@@ -34,6 +35,14 @@ public:
     rawsocket_server(
             const std::shared_ptr<wamp_routers>& routers,
             const std::shared_ptr<wamp_serializers>& serializers);
+
+    /// Creates a server whose routers run on the given io service. Listeners
+    /// may then accept connections on other io services, messages received
+    /// on those connections are handed over to the routers' io service.
+    rawsocket_server(
+            boost::asio::io_service& io_service,
+            const std::shared_ptr<wamp_routers>& routers,
+            const std::shared_ptr<wamp_serializers>& serializers);
     ~rawsocket_server();
 
     void attach_listener(const std::shared_ptr<rawsocket_listener>& listener);
@@ -36,7 +36,21 @@ namespace bonefish {
 rawsocket_server_impl::rawsocket_server_impl(
         const std::shared_ptr<wamp_routers>& routers,
         const std::shared_ptr<wamp_serializers>& serializers)
-    : m_routers(routers)
+    : m_io_service(nullptr)
+    , m_routers(routers)
+    , m_serializers(serializers)
+    , m_listeners()
+    , m_connections()
+    , m_message_processor(routers)
+{
+}
+
+rawsocket_server_impl::rawsocket_server_impl(
+        boost::asio::io_service& io_service,
+        const std::shared_ptr<wamp_routers>& routers,
+        const std::shared_ptr<wamp_serializers>& serializers)
+    : m_io_service(&io_service)
+    , m_routers(routers)
     , m_serializers(serializers)
     , m_listeners()
     , m_connections()
@@ -125,7 +139,11 @@ void rawsocket_server_impl::on_connect(const std::shared_ptr<rawsocket_connectio
     // initiated by the client. The handshake handler will be called when
     // the handshake arrives.
     connection->async_handshake();
-    m_connections.insert(connection);
+
+    std::shared_ptr<rawsocket_server_impl> shared_self = shared_from_this();
+    dispatch([shared_self, connection]() {
+        shared_self->m_connections.insert(connection);
+    });
 }
 
 void rawsocket_server_impl::on_close(const std::shared_ptr<rawsocket_connection>& connection)
@@ -196,6 +214,12 @@ void rawsocket_server_impl::on_handshake(
     //       decide to support a maximum message length we will have
     //       to report that back to the client here.
     if (connection->send_handshake(htonl(capabilities))) {
+        // The transport is created once per connection and is shared by any
+        // sessions that are established over the connection.
+        connection->set_transport(std::make_shared<rawsocket_transport>(
+                m_serializers->get_serializer(wamp_serializer_type::MSGPACK), connection,
+                get_remote_io_service(connection)));
+
         // Prepare the connection to start receiving wamp messages. We only have to
         // initiate this once and it will then continue to re-arm itself after each
         // message is received. This is effectively what switches us from a handshake
@@ -215,11 +239,25 @@ void rawsocket_server_impl::on_message(
                 m_serializers->get_serializer(wamp_serializer_type::MSGPACK);
         std::unique_ptr<wamp_message> message(
                 serializer->deserialize(buffer, length));
-        std::unique_ptr<wamp_transport> transport(
-                new rawsocket_transport(serializer, connection));
 
-        if (message) {
-            m_message_processor.process_message(message, std::move(transport), connection.get());
+        if (!message) {
+            return;
+        }
+
+        // The message is decoded on the connection's thread. Connections that
+        // are serviced by the routers' thread process it right away. Others
+        // hand it over through the connection's inbox and only wake up the
+        // routers for the first message since they last looked.
+        if (!get_remote_io_service(connection)) {
+            m_message_processor.process_message(message, connection.get());
+            return;
+        }
+
+        if (connection->get_inbox().push(std::move(message))) {
+            std::shared_ptr<rawsocket_server_impl> shared_self = shared_from_this();
+            m_io_service->post([shared_self, connection]() {
+                shared_self->m_message_processor.process_inbox(connection.get());
+            });
         }
     } catch (const std::exception& e) {
         BONEFISH_TRACE("unhandled exception: %1%", e.what());
@@ -228,16 +266,58 @@ void rawsocket_server_impl::on_message(
 
 void rawsocket_server_impl::teardown_connection(
         const std::shared_ptr<rawsocket_connection>& connection)
+{
+    std::shared_ptr<rawsocket_server_impl> shared_self = shared_from_this();
+    dispatch([shared_self, connection]() {
+        shared_self->remove_connection(connection);
+    });
+}
+
+void rawsocket_server_impl::remove_connection(
+        const std::shared_ptr<rawsocket_connection>& connection)
 {
     if (connection->has_session_id()) {
-        std::shared_ptr<wamp_router> router =
-                m_routers->get_router(connection->get_realm());
+        const std::shared_ptr<wamp_router>& router = connection->get_router();
         if (router) {
-            router->detach_session(connection->get_session_id());
+            router->detach_session(connection->get_session_slot());
         }
     }
 
+    // The transport holds a reference to the connection so it has to be
+    // released here in order for the connection to be destroyed.
+    connection->set_transport(nullptr);
     m_connections.erase(connection);
+
+    // A connection serviced by another thread is closed on that thread so
+    // that its socket is not closed while the thread is still using it. The
+    // handler keeps the connection alive until then.
+    boost::asio::io_service* connection_io_service = get_remote_io_service(connection);
+    if (connection_io_service) {
+        std::shared_ptr<rawsocket_connection> closing_connection = connection;
+        connection_io_service->post([closing_connection]() {
+            closing_connection->close();
+        });
+    }
+}
+
+boost::asio::io_service* rawsocket_server_impl::get_remote_io_service(
+        const std::shared_ptr<rawsocket_connection>& connection) const
+{
+    boost::asio::io_service* connection_io_service = connection->get_io_service();
+    if (!m_io_service || connection_io_service == m_io_service) {
+        return nullptr;
+    }
+
+    return connection_io_service;
+}
+
+void rawsocket_server_impl::dispatch(const std::function<void()>& handler)
+{
+    if (m_io_service) {
+        m_io_service->dispatch(handler);
+    } else {
+        handler();
+    }
 }
 
 } // namespace bonefish
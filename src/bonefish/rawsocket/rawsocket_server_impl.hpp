@@ -21,8 +21,10 @@
 #include <bonefish/rawsocket/rawsocket_connection.hpp>
 #include <bonefish/common/wamp_message_processor.hpp>
 
+#include <boost/asio/io_service.hpp>
 #include <boost/asio/ip/address.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <functional>
 #include <set>
 #include <memory>
 
@@ -38,6 +40,10 @@ public:
     rawsocket_server_impl(
             const std::shared_ptr<wamp_routers>& routers,
             const std::shared_ptr<wamp_serializers>& serializers);
+    rawsocket_server_impl(
+            boost::asio::io_service& io_service,
+            const std::shared_ptr<wamp_routers>& routers,
+            const std::shared_ptr<wamp_serializers>& serializers);
     ~rawsocket_server_impl();
 
     void attach_listener(const std::shared_ptr<rawsocket_listener>& listener);
@@ -55,8 +61,20 @@ private:
     void on_fail(const std::shared_ptr<rawsocket_connection>& connection, const char* reason);
 
     void teardown_connection(const std::shared_ptr<rawsocket_connection>& connection);
+    void remove_connection(const std::shared_ptr<rawsocket_connection>& connection);
+
+    /// The io service of the thread that services the connection if that is
+    /// not the io service of the routers.
+    boost::asio::io_service* get_remote_io_service(
+            const std::shared_ptr<rawsocket_connection>& connection) const;
+
+    /// Runs the handler on the io service that drives the routers. Listeners
+    /// may accept connections on other io services in which case only the
+    /// handshake and message decoding happen on the connection's thread.
+    void dispatch(const std::function<void()>& handler);
 
 private:
+    boost::asio::io_service* m_io_service;
     std::shared_ptr<wamp_routers> m_routers;
     std::shared_ptr<wamp_serializers> m_serializers;
 
@@ -21,16 +21,20 @@
 #include <bonefish/serialization/expandable_buffer.hpp>
 #include <bonefish/serialization/wamp_serializer.hpp>
 #include <bonefish/trace/trace.hpp>
+#include <bonefish/transport/wamp_fanout_message.hpp>
 
 #include <iostream>
+#include <string>
 
 namespace bonefish {
 
 rawsocket_transport::rawsocket_transport(
         const std::shared_ptr<wamp_serializer>& serializer,
-        const std::shared_ptr<rawsocket_connection>& connection)
+        const std::shared_ptr<rawsocket_connection>& connection,
+        boost::asio::io_service* connection_io_service)
     : m_serializer(serializer)
     , m_connection(connection)
+    , m_connection_io_service(connection_io_service)
 {
 }
 
@@ -38,7 +42,33 @@ bool rawsocket_transport::send_message(wamp_message&& message)
 {
     BONEFISH_TRACE("sending message: %1%", message_type_to_string(message.get_type()));
     expandable_buffer buffer = m_serializer->serialize(message);
-    return m_connection->send_message(buffer.data(), buffer.size());
+    return send_buffer(buffer.data(), buffer.size());
+}
+
+bool rawsocket_transport::send_fanout_message(wamp_fanout_message& message)
+{
+    BONEFISH_TRACE("sending message: %1%", message_type_to_string(message.get_message().get_type()));
+    const expandable_buffer& buffer = message.serialize(*m_serializer);
+    return send_buffer(buffer.data(), buffer.size());
+}
+
+bool rawsocket_transport::send_buffer(const char* data, size_t length)
+{
+    if (!m_connection_io_service) {
+        return m_connection->send_message(data, length);
+    }
+
+    // Sockets must not be written to by one thread while another one reads
+    // from them so the write is handed over to the connection's thread. The
+    // io service is run by that thread alone so writes stay in order. A
+    // failed write fails the connection which tears down its session.
+    auto payload = std::make_shared<std::string>(data, length);
+    std::shared_ptr<rawsocket_connection> connection = m_connection;
+    m_connection_io_service->post([connection, payload]() {
+        connection->send_message(payload->data(), payload->size());
+    });
+
+    return true;
 }
 
 } // namespace bonefish
@@ -19,6 +19,7 @@
 
 #include <bonefish/transport/wamp_transport.hpp>
 
+#include <boost/asio/io_service.hpp>
 #include <iostream>
 #include <memory>
 
@@ -31,15 +32,23 @@ class wamp_serializer;
 class rawsocket_transport : public wamp_transport
 {
 public:
+    /// If the connection is serviced by the io service of another thread
+    /// then that io service is given and the writes are handed over to it.
     rawsocket_transport(
             const std::shared_ptr<wamp_serializer>& serializer,
-            const std::shared_ptr<rawsocket_connection>& connection);
+            const std::shared_ptr<rawsocket_connection>& connection,
+            boost::asio::io_service* connection_io_service = nullptr);
 
     virtual bool send_message(wamp_message&& message) override;
+    virtual bool send_fanout_message(wamp_fanout_message& message) override;
+
+private:
+    bool send_buffer(const char* data, size_t length);
 
 private:
     std::shared_ptr<wamp_serializer> m_serializer;
     std::shared_ptr<rawsocket_connection> m_connection;
+    boost::asio::io_service* m_connection_io_service;
 };
 
 } // namespace bonefish
@@ -0,0 +1,215 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <bonefish/rawsocket/seqpacket_connection.hpp>
+
+#include <algorithm>
+#include <boost/asio/buffer.hpp>
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+namespace bonefish {
+
+seqpacket_connection::seqpacket_connection(
+        boost::asio::generic::seq_packet_protocol::socket&& socket,
+        const std::shared_ptr<seqpacket_receive_buffers>& buffers)
+    : rawsocket_connection()
+    , m_socket(std::move(socket))
+    , m_receive_flags(0)
+    , m_buffers(buffers)
+    , m_chunked_message()
+    , m_chunked_remaining(0)
+{
+}
+
+seqpacket_connection::~seqpacket_connection()
+{
+    if (m_socket.is_open()) {
+        m_socket.close();
+    }
+}
+
+void seqpacket_connection::async_read(
+        void* data,
+        size_t length,
+        const read_handler& handler)
+{
+    // Only the handshake is read this way. It arrives as a datagram of its
+    // own which has to be exactly the requested length.
+    m_socket.async_receive(boost::asio::buffer(data, length), m_receive_flags,
+            [length, handler](const boost::system::error_code& error_code,
+                    size_t bytes_transferred) {
+        if (!error_code && bytes_transferred == 0) {
+            handler(boost::asio::error::eof, 0);
+        } else if (!error_code && bytes_transferred != length) {
+            handler(boost::asio::error::message_size, bytes_transferred);
+        } else {
+            handler(error_code, bytes_transferred);
+        }
+    });
+}
+
+void seqpacket_connection::write(
+        const void* data,
+        size_t length,
+        boost::system::error_code& error_code)
+{
+    m_socket.send(boost::asio::buffer(data, length), 0, error_code);
+}
+
+void seqpacket_connection::async_receive()
+{
+    std::weak_ptr<seqpacket_connection> weak_self =
+            std::static_pointer_cast<seqpacket_connection>(shared_from_this());
+
+    // Only wait for the socket to become readable. The datagrams are then
+    // received in batches directly from the socket.
+    m_socket.async_receive(boost::asio::null_buffers(), m_receive_flags,
+            [weak_self](const boost::system::error_code& error_code, size_t) {
+        auto shared_self = weak_self.lock();
+        if (shared_self) {
+            shared_self->receive_datagrams(error_code);
+        }
+    });
+}
+
+bool seqpacket_connection::send_message(const char* message, size_t length)
+{
+    boost::system::error_code error_code;
+
+    const std::size_t max_datagram_size = seqpacket_receive_buffers::MAX_DATAGRAM_SIZE;
+    if (length <= max_datagram_size) {
+        write(message, length, error_code);
+    } else {
+        char chunk_header[CHUNK_HEADER_SIZE] = { 0 };
+        const uint32_t message_length = htonl(static_cast<uint32_t>(length));
+        std::memcpy(chunk_header + 4, &message_length, sizeof(message_length));
+        write(chunk_header, sizeof(chunk_header), error_code);
+
+        for (size_t offset = 0; offset < length && !error_code; offset += max_datagram_size) {
+            write(message + offset, std::min(length - offset, max_datagram_size), error_code);
+        }
+    }
+
+    if (error_code) {
+        handle_system_error(error_code);
+        return false;
+    }
+
+    return true;
+}
+
+void seqpacket_connection::receive_datagrams(const boost::system::error_code& error_code)
+{
+    if (error_code) {
+        handle_system_error(error_code);
+        return;
+    }
+
+    const std::size_t batch_size = seqpacket_receive_buffers::BATCH_SIZE;
+    struct iovec vectors[batch_size];
+    struct mmsghdr headers[batch_size];
+    std::memset(headers, 0, sizeof(headers));
+    for (std::size_t i = 0; i < batch_size; ++i) {
+        vectors[i].iov_base = m_buffers->get_buffer(i);
+        vectors[i].iov_len = seqpacket_receive_buffers::MAX_DATAGRAM_SIZE;
+        headers[i].msg_hdr.msg_iov = &vectors[i];
+        headers[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int count = recvmmsg(m_socket.native_handle(), headers, batch_size, MSG_DONTWAIT, nullptr);
+    if (count < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            async_receive();
+        } else {
+            handle_system_error(boost::system::error_code(
+                    errno, boost::system::system_category()));
+        }
+        return;
+    }
+
+    // The handlers may release the last reference held by the server.
+    std::shared_ptr<rawsocket_connection> shared_self = shared_from_this();
+    for (int i = 0; i < count; ++i) {
+        if (headers[i].msg_len == 0) {
+            handle_system_error(boost::asio::error::eof);
+            return;
+        }
+
+        if (headers[i].msg_hdr.msg_flags & MSG_TRUNC) {
+            fail("datagram too large");
+            return;
+        }
+
+        if (!receive_datagram(m_buffers->get_buffer(i), headers[i].msg_len)) {
+            return;
+        }
+    }
+
+    async_receive();
+}
+
+bool seqpacket_connection::receive_datagram(const char* data, size_t length)
+{
+    if (m_chunked_remaining != 0) {
+        if (length > m_chunked_remaining) {
+            fail("invalid message chunk");
+            return false;
+        }
+
+        m_chunked_message.insert(m_chunked_message.end(), data, data + length);
+        m_chunked_remaining -= length;
+        if (m_chunked_remaining != 0) {
+            return true;
+        }
+
+        const auto& message_handler = get_message_handler();
+        assert(message_handler);
+        message_handler(shared_from_this(), m_chunked_message.data(), m_chunked_message.size());
+        m_chunked_message.clear();
+        return true;
+    }
+
+    if (length == CHUNK_HEADER_SIZE && data[0] == 0) {
+        uint32_t message_length;
+        std::memcpy(&message_length, data + 4, sizeof(message_length));
+        message_length = ntohl(message_length);
+        if (message_length == 0 || message_length > MAX_MESSAGE_LENGTH) {
+            BONEFISH_TRACE("invalid message length: %1%", message_length);
+            fail("invalid message length");
+            return false;
+        }
+
+        m_chunked_message.reserve(message_length);
+        m_chunked_remaining = message_length;
+        return true;
+    }
+
+    const auto& message_handler = get_message_handler();
+    assert(message_handler);
+    message_handler(shared_from_this(), data, length);
+    return true;
+}
+
+void seqpacket_connection::fail(const char* reason)
+{
+    const auto& fail_handler = get_fail_handler();
+    fail_handler(shared_from_this(), reason);
+}
+
+} // namespace bonefish
@@ -0,0 +1,117 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_SEQPACKET_CONNECTION_HPP
+#define BONEFISH_SEQPACKET_CONNECTION_HPP
+
+#include <bonefish/rawsocket/rawsocket_connection.hpp>
+
+#include <boost/asio/generic/seq_packet_protocol.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace bonefish {
+
+/// Receive buffers that are shared by the seqpacket connections of a
+/// listener. A batch of datagrams is handed to the message handlers before
+/// the next batch is received so connections that are serviced by the same
+/// thread never use the buffers at the same time.
+class seqpacket_receive_buffers
+{
+public:
+    /// The number of datagrams that are received with a single system call.
+    static const std::size_t BATCH_SIZE = 16;
+
+    /// The largest datagram that is sent or received. Larger messages are
+    /// split into chunks of at most this size.
+    static const std::size_t MAX_DATAGRAM_SIZE = 64 * 1024;
+
+    seqpacket_receive_buffers();
+
+    char* get_buffer(std::size_t index);
+
+private:
+    std::vector<char> m_buffers;
+};
+
+/// A rawsocket connection over a SOCK_SEQPACKET unix domain socket. After
+/// the handshake every message is sent as a single datagram without the
+/// rawsocket length prefix. Messages that do not fit into a datagram are
+/// announced with a chunk header followed by the message split into
+/// datagrams of at most MAX_DATAGRAM_SIZE bytes.
+///
+/// Chunk header:
+///
+///   0x00 0x00 0x00 0x00 LLLL LLLL LLLL LLLL
+///
+/// where L is the total message length in network order. A msgpack encoded
+/// wamp message is an array and therefore never starts with a zero byte.
+class seqpacket_connection :
+        public rawsocket_connection
+{
+public:
+    seqpacket_connection(
+            boost::asio::generic::seq_packet_protocol::socket&& socket,
+            const std::shared_ptr<seqpacket_receive_buffers>& buffers);
+    virtual ~seqpacket_connection() override;
+
+    virtual void async_read(
+            void* data,
+            size_t length,
+            const read_handler& handler) override;
+
+    virtual void write(
+            const void* data,
+            size_t length,
+            boost::system::error_code& error_code) override;
+
+    virtual void async_receive() override;
+    virtual bool send_message(const char* message, size_t length) override;
+
+private:
+    void receive_datagrams(const boost::system::error_code& error_code);
+    bool receive_datagram(const char* data, size_t length);
+    void fail(const char* reason);
+
+private:
+    static const std::size_t CHUNK_HEADER_SIZE = 8;
+    static const uint32_t MAX_MESSAGE_LENGTH = 16 * 1024 * 1024;
+
+    boost::asio::generic::seq_packet_protocol::socket m_socket;
+    boost::asio::socket_base::message_flags m_receive_flags;
+    std::shared_ptr<seqpacket_receive_buffers> m_buffers;
+
+    /// The message that is being reassembled from chunks and the number of
+    /// bytes of it that are still outstanding.
+    std::vector<char> m_chunked_message;
+    std::size_t m_chunked_remaining;
+};
+
+inline seqpacket_receive_buffers::seqpacket_receive_buffers()
+    : m_buffers(BATCH_SIZE * MAX_DATAGRAM_SIZE)
+{
+}
+
+inline char* seqpacket_receive_buffers::get_buffer(std::size_t index)
+{
+    return m_buffers.data() + index * MAX_DATAGRAM_SIZE;
+}
+
+} // namespace bonefish
+
+#endif // BONEFISH_SEQPACKET_CONNECTION_HPP
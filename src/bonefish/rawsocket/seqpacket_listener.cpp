@@ -0,0 +1,85 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <bonefish/rawsocket/seqpacket_listener.hpp>
+#include <bonefish/rawsocket/seqpacket_connection.hpp>
+
+#include <boost/asio/local/stream_protocol.hpp>
+#include <unistd.h>
+
+namespace bonefish {
+
+seqpacket_listener::seqpacket_listener(
+        boost::asio::io_service& io_service,
+        const std::string& path)
+    : rawsocket_listener()
+    , m_path(path)
+    , m_socket(io_service)
+    , m_acceptor(io_service)
+    , m_buffers(std::make_shared<seqpacket_receive_buffers>())
+{
+}
+
+seqpacket_listener::~seqpacket_listener()
+{
+    stop_listening();
+}
+
+void seqpacket_listener::start_listening()
+{
+    if (is_listening()) {
+        return;
+    }
+
+    // The generic endpoint takes its address family from the unix domain
+    // endpoint and its socket type from the seqpacket protocol.
+    const boost::asio::local::stream_protocol::endpoint local_endpoint(m_path);
+    const boost::asio::generic::seq_packet_protocol::endpoint endpoint(local_endpoint);
+
+    unlink(m_path.c_str());
+    m_acceptor.open(endpoint.protocol());
+    m_acceptor.bind(endpoint);
+    m_acceptor.listen();
+
+    assert(get_accept_handler());
+    set_listening(true);
+    async_accept();
+}
+
+void seqpacket_listener::stop_listening()
+{
+    if (!is_listening()) {
+        return;
+    }
+
+    m_acceptor.close();
+    set_listening(false);
+}
+
+std::shared_ptr<rawsocket_connection> seqpacket_listener::create_connection()
+{
+    return std::make_shared<seqpacket_connection>(std::move(m_socket), m_buffers);
+}
+
+void seqpacket_listener::async_accept()
+{
+    m_acceptor.async_accept(m_socket,
+            std::bind(&rawsocket_listener::handle_accept,
+                    shared_from_this(),
+                    std::placeholders::_1));
+}
+
+} // namespace bonefish
@@ -0,0 +1,60 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_SEQPACKET_LISTENER_HPP
+#define BONEFISH_SEQPACKET_LISTENER_HPP
+
+#include <bonefish/rawsocket/rawsocket_listener.hpp>
+
+#include <boost/asio/basic_socket_acceptor.hpp>
+#include <boost/asio/generic/seq_packet_protocol.hpp>
+#include <boost/asio/io_service.hpp>
+#include <memory>
+#include <string>
+
+namespace bonefish {
+
+class seqpacket_receive_buffers;
+
+/// Listens for rawsocket connections on a SOCK_SEQPACKET unix domain socket.
+/// Only supported on Linux.
+class seqpacket_listener :
+        public rawsocket_listener,
+        public std::enable_shared_from_this<seqpacket_listener>
+{
+public:
+    seqpacket_listener(
+            boost::asio::io_service& io_service,
+            const std::string& path);
+    virtual ~seqpacket_listener() override;
+
+    virtual void start_listening() override;
+    virtual void stop_listening() override;
+    virtual std::shared_ptr<rawsocket_connection> create_connection() override;
+
+protected:
+    virtual void async_accept() override;
+
+private:
+    std::string m_path;
+    boost::asio::generic::seq_packet_protocol::socket m_socket;
+    boost::asio::basic_socket_acceptor<boost::asio::generic::seq_packet_protocol> m_acceptor;
+    std::shared_ptr<seqpacket_receive_buffers> m_buffers;
+};
+
+} // namespace bonefish
+
+#endif // BONEFISH_SEQPACKET_LISTENER_HPP
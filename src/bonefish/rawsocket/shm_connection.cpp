@@ -0,0 +1,257 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <bonefish/rawsocket/shm_connection.hpp>
+#include <bonefish/trace/trace.hpp>
+
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/system/system_error.hpp>
+#include <cerrno>
+#include <poll.h>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace bonefish {
+
+shm_connection::shm_connection(
+        boost::asio::io_service& io_service,
+        boost::asio::local::stream_protocol::socket&& socket,
+        std::size_t ring_capacity)
+    : rawsocket_connection()
+    , m_io_service(io_service)
+    , m_socket(std::move(socket))
+    , m_data_event(io_service)
+    , m_segment()
+    , m_error()
+    , m_monitoring(false)
+    , m_read_data(nullptr)
+    , m_read_length(0)
+    , m_read_offset(0)
+    , m_read_handler()
+    , m_event_value(0)
+    , m_control_byte(0)
+{
+    // A failure to set up the segment is reported through the first read
+    // which is the handshake so that the connection is torn down as usual.
+    try {
+        m_segment.create(ring_capacity);
+        m_segment.send(m_socket.native_handle());
+
+        int data_event = dup(m_segment.get_upstream().get_data_event());
+        if (data_event == -1) {
+            throw boost::system::system_error(
+                    boost::system::error_code(errno, boost::system::system_category()), "dup");
+        }
+        m_data_event.assign(data_event);
+    } catch (const boost::system::system_error& e) {
+        BONEFISH_TRACE("failed to set up shared memory: %1%", e.what());
+        m_error = e.code();
+    } catch (const std::exception& e) {
+        BONEFISH_TRACE("failed to set up shared memory: %1%", e.what());
+        m_error = boost::asio::error::invalid_argument;
+    }
+}
+
+shm_connection::~shm_connection()
+{
+    boost::system::error_code error_code;
+    m_data_event.close(error_code);
+    m_socket.close(error_code);
+}
+
+void shm_connection::async_read(
+        void* data,
+        size_t length,
+        const read_handler& handler)
+{
+    m_read_data = static_cast<char*>(data);
+    m_read_length = length;
+    m_read_offset = 0;
+    m_read_handler = handler;
+
+    if (!m_monitoring && !m_error) {
+        m_monitoring = true;
+        async_monitor();
+    }
+
+    continue_read();
+}
+
+void shm_connection::write(
+        const void* data,
+        size_t length,
+        boost::system::error_code& error_code)
+{
+    const char* buffer = static_cast<const char*>(data);
+    shm_channel& downstream = m_segment.get_downstream();
+    while (!m_error) {
+        size_t count = 0;
+        try {
+            count = downstream.write(buffer, length);
+        } catch (const boost::system::system_error& e) {
+            BONEFISH_TRACE("failed to write to shared memory: %1%", e.what());
+            m_error = e.code();
+            break;
+        }
+
+        buffer += count;
+        length -= count;
+        if (length == 0) {
+            error_code = boost::system::error_code();
+            return;
+        }
+
+        if (downstream.get_ring().prepare_writer_wait()) {
+            wait_for_space(error_code);
+            if (error_code) {
+                return;
+            }
+        }
+    }
+
+    error_code = m_error;
+}
+
+void shm_connection::async_monitor()
+{
+    std::weak_ptr<shm_connection> weak_self =
+            std::static_pointer_cast<shm_connection>(shared_from_this());
+
+    // Nothing but the end of the stream is expected on the socket once the
+    // segment has been handed over. Anything else is simply ignored.
+    auto handler = [weak_self](
+            const boost::system::error_code& error_code, size_t bytes_transferred) {
+        auto shared_self = weak_self.lock();
+        if (!shared_self) {
+            return;
+        }
+
+        if (!error_code) {
+            shared_self->async_monitor();
+            return;
+        }
+
+        if (error_code != boost::asio::error::operation_aborted) {
+            shared_self->m_error = error_code;
+            boost::system::error_code ignored;
+            shared_self->m_data_event.cancel(ignored);
+        }
+    };
+
+    m_socket.async_read_some(boost::asio::buffer(&m_control_byte, sizeof(m_control_byte)), handler);
+}
+
+void shm_connection::continue_read()
+{
+    if (m_error) {
+        complete_read(m_error);
+        return;
+    }
+
+    shm_channel& upstream = m_segment.get_upstream();
+    do {
+        try {
+            m_read_offset += upstream.read(
+                    m_read_data + m_read_offset, m_read_length - m_read_offset);
+        } catch (const boost::system::system_error& e) {
+            BONEFISH_TRACE("failed to read from shared memory: %1%", e.what());
+            m_error = e.code();
+            complete_read(m_error);
+            return;
+        }
+
+        if (m_read_offset == m_read_length) {
+            complete_read(boost::system::error_code());
+            return;
+        }
+    } while (!upstream.get_ring().prepare_reader_wait());
+
+    std::weak_ptr<shm_connection> weak_self =
+            std::static_pointer_cast<shm_connection>(shared_from_this());
+
+    auto handler = [weak_self](
+            const boost::system::error_code& error_code, size_t bytes_transferred) {
+        auto shared_self = weak_self.lock();
+        if (!shared_self) {
+            return;
+        }
+
+        // The wait is cancelled when the component goes away in which case
+        // the error that was recorded takes precedence.
+        if (error_code && !shared_self->m_error) {
+            shared_self->m_error = error_code;
+        }
+        shared_self->continue_read();
+    };
+
+    // Reading the eventfd both waits for and clears the wakeup.
+    m_data_event.async_read_some(boost::asio::buffer(&m_event_value, sizeof(m_event_value)), handler);
+}
+
+void shm_connection::complete_read(const boost::system::error_code& error_code)
+{
+    read_handler handler;
+    handler.swap(m_read_handler);
+    if (!handler) {
+        return;
+    }
+
+    // Completions are always posted, as they would be for a socket, so that
+    // a backlog of buffered messages does not recurse through the handlers.
+    const size_t bytes_transferred = m_read_offset;
+    m_io_service.post([handler, error_code, bytes_transferred]() {
+        handler(error_code, bytes_transferred);
+    });
+}
+
+void shm_connection::wait_for_space(boost::system::error_code& error_code)
+{
+    // Writes are synchronous just like they are for the socket based
+    // connections so the writer blocks until the component has made room.
+    // The socket is polled as well so that a component which has gone away
+    // cannot block the router forever.
+    pollfd descriptors[2];
+    descriptors[0].fd = m_segment.get_downstream().get_space_event();
+    descriptors[0].events = POLLIN;
+    descriptors[0].revents = 0;
+    descriptors[1].fd = m_socket.native_handle();
+    descriptors[1].events = 0;
+    descriptors[1].revents = 0;
+
+    int result;
+    do {
+        result = poll(descriptors, 2, -1);
+    } while (result == -1 && errno == EINTR);
+
+    if (result == -1) {
+        error_code = boost::system::error_code(errno, boost::system::system_category());
+        return;
+    }
+
+    if (descriptors[1].revents & (POLLHUP | POLLERR)) {
+        error_code = boost::asio::error::broken_pipe;
+        return;
+    }
+
+    if (descriptors[0].revents & POLLIN) {
+        shm_channel::clear_event(descriptors[0].fd);
+    }
+
+    error_code = boost::system::error_code();
+}
+
+} // namespace bonefish
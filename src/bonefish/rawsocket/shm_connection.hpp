@@ -0,0 +1,83 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_SHM_CONNECTION_HPP
+#define BONEFISH_SHM_CONNECTION_HPP
+
+#include <bonefish/rawsocket/rawsocket_connection.hpp>
+#include <bonefish/rawsocket/shm_segment.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace bonefish {
+
+/// A rawsocket connection whose byte stream is carried by a pair of shared
+/// memory rings rather than by a socket. The unix domain socket that the
+/// component connected with is used to hand over the shared memory segment
+/// and afterwards only to detect when the component goes away.
+class shm_connection : public rawsocket_connection
+{
+public:
+    shm_connection(
+            boost::asio::io_service& io_service,
+            boost::asio::local::stream_protocol::socket&& socket,
+            std::size_t ring_capacity);
+    virtual ~shm_connection() override;
+
+    virtual void async_read(
+            void* data,
+            size_t length,
+            const read_handler& handler) override;
+
+    virtual void write(
+            const void* data,
+            size_t length,
+            boost::system::error_code& error_code) override;
+
+private:
+    void async_monitor();
+    void continue_read();
+    void complete_read(const boost::system::error_code& error_code);
+    void wait_for_space(boost::system::error_code& error_code);
+
+private:
+    boost::asio::io_service& m_io_service;
+    boost::asio::local::stream_protocol::socket m_socket;
+    boost::asio::posix::stream_descriptor m_data_event;
+    shm_segment m_segment;
+
+    /// Set once the segment could not be set up or the component has gone
+    /// away. Any further reads and writes fail with this error.
+    boost::system::error_code m_error;
+    bool m_monitoring;
+
+    char* m_read_data;
+    size_t m_read_length;
+    size_t m_read_offset;
+    read_handler m_read_handler;
+
+    std::uint64_t m_event_value;
+    char m_control_byte;
+};
+
+} // namespace bonefish
+
+#endif // BONEFISH_SHM_CONNECTION_HPP
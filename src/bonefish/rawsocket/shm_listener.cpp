@@ -0,0 +1,83 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <bonefish/rawsocket/shm_listener.hpp>
+#include <bonefish/rawsocket/shm_connection.hpp>
+
+#include <unistd.h>
+
+namespace bonefish {
+
+shm_listener::shm_listener(
+        boost::asio::io_service& io_service,
+        const std::string& path,
+        std::size_t ring_capacity)
+    : rawsocket_listener()
+    , m_io_service(io_service)
+    , m_socket(io_service)
+    , m_acceptor(io_service)
+    , m_endpoint(path)
+    , m_ring_capacity(ring_capacity)
+{
+}
+
+shm_listener::~shm_listener()
+{
+    stop_listening();
+}
+
+void shm_listener::start_listening()
+{
+    if (is_listening()) {
+        return;
+    }
+
+    unlink(m_endpoint.path().c_str());
+    m_acceptor.open(m_endpoint.protocol());
+    m_acceptor.set_option(
+           boost::asio::local::stream_protocol::acceptor::reuse_address(true));
+    m_acceptor.bind(m_endpoint);
+    m_acceptor.listen();
+
+    assert(get_accept_handler());
+    set_listening(true);
+    async_accept();
+}
+
+void shm_listener::stop_listening()
+{
+    if (!is_listening()) {
+        return;
+    }
+
+    m_acceptor.close();
+    set_listening(false);
+}
+
+std::shared_ptr<rawsocket_connection> shm_listener::create_connection()
+{
+    return std::make_shared<shm_connection>(m_io_service, std::move(m_socket), m_ring_capacity);
+}
+
+void shm_listener::async_accept()
+{
+    m_acceptor.async_accept(m_socket,
+            std::bind(&rawsocket_listener::handle_accept,
+                    shared_from_this(),
+                    std::placeholders::_1));
+}
+
+} // namespace bonefish
@@ -0,0 +1,62 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_SHM_LISTENER_HPP
+#define BONEFISH_SHM_LISTENER_HPP
+
+#include <bonefish/rawsocket/rawsocket_listener.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace bonefish {
+
+/// Listens for components on the same host that want to exchange messages
+/// with the router through shared memory. Components connect to the given
+/// unix domain socket path and receive the shared memory segment of their
+/// connection in return.
+class shm_listener :
+        public rawsocket_listener,
+        public std::enable_shared_from_this<shm_listener>
+{
+public:
+    shm_listener(
+            boost::asio::io_service& io_service,
+            const std::string& path,
+            std::size_t ring_capacity);
+    virtual ~shm_listener() override;
+
+    virtual void start_listening() override;
+    virtual void stop_listening() override;
+    virtual std::shared_ptr<rawsocket_connection> create_connection() override;
+
+protected:
+    virtual void async_accept() override;
+
+private:
+    boost::asio::io_service& m_io_service;
+    boost::asio::local::stream_protocol::socket m_socket;
+    boost::asio::local::stream_protocol::acceptor m_acceptor;
+    boost::asio::local::stream_protocol::endpoint m_endpoint;
+    std::size_t m_ring_capacity;
+};
+
+} // namespace bonefish
+
+#endif // BONEFISH_SHM_LISTENER_HPP
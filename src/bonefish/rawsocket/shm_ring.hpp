@@ -0,0 +1,278 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_SHM_RING_HPP
+#define BONEFISH_SHM_RING_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+namespace bonefish {
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+        "shared memory rings require lock free 64-bit atomics");
+
+/// The control block of a ring which lives in shared memory in front of the
+/// ring's data. The positions only ever increase and are masked with the
+/// capacity to find the offset into the data. The producer and consumer
+/// fields live on separate cache lines to avoid false sharing.
+struct shm_ring_header
+{
+    alignas(64) std::atomic<std::uint64_t> write_position;
+    std::atomic<std::uint32_t> reader_waiting;
+    alignas(64) std::atomic<std::uint64_t> read_position;
+    std::atomic<std::uint32_t> writer_waiting;
+};
+
+/// A single producer, single consumer byte ring over shared memory. Each
+/// side only ever modifies its own position so no locking is required.
+///
+/// The peer can write to the control block at any time so each side keeps
+/// its own position in private memory and only publishes it to the control
+/// block. The position of the peer is validated against the capacity before
+/// it is used and a ring whose positions are inconsistent is marked as
+/// corrupted and refuses any further reads and writes.
+///
+/// The waiting flags allow a side that is about to block to ask the other
+/// side for a wakeup. A side announces that it is going to wait and then
+/// checks the ring once more before actually blocking so that a wakeup can
+/// never be lost.
+class shm_ring
+{
+public:
+    /// Returns the amount of shared memory required for a ring of the given
+    /// capacity. The capacity must be a power of two.
+    static std::size_t get_required_size(std::size_t capacity);
+
+    shm_ring();
+    shm_ring(void* memory, std::size_t capacity);
+
+    /// Initializes the control block. Only the side that created the shared
+    /// memory may do this and only before it has been shared.
+    void initialize();
+
+    std::size_t get_capacity() const;
+
+    /// Whether the ring is empty from the point of view of the reader.
+    bool empty() const;
+
+    /// Whether the ring is full from the point of view of the writer.
+    bool full() const;
+
+    /// Whether the peer left the positions in an inconsistent state.
+    bool is_corrupted() const;
+
+    /// Writes as much of the data as currently fits and returns the number
+    /// of bytes that were written.
+    std::size_t write(const void* data, std::size_t length);
+
+    /// Reads as much of the requested data as is currently available and
+    /// returns the number of bytes that were read.
+    std::size_t read(void* data, std::size_t length);
+
+    /// Announces that the reader is about to block. Returns false if data
+    /// became available in the meantime in which case it must not block.
+    bool prepare_reader_wait();
+
+    /// Announces that the writer is about to block. Returns false if space
+    /// became available in the meantime in which case it must not block.
+    bool prepare_writer_wait();
+
+    /// Clears the waiting flag of the reader and returns whether it was set
+    /// in which case the reader has to be woken up.
+    bool take_reader_waiting();
+
+    /// Clears the waiting flag of the writer and returns whether it was set
+    /// in which case the writer has to be woken up.
+    bool take_writer_waiting();
+
+private:
+    shm_ring_header* m_header;
+    char* m_data;
+    std::size_t m_capacity;
+    std::uint64_t m_write_position;
+    std::uint64_t m_read_position;
+    bool m_corrupted;
+};
+
+inline std::size_t shm_ring::get_required_size(std::size_t capacity)
+{
+    return sizeof(shm_ring_header) + capacity;
+}
+
+inline shm_ring::shm_ring()
+    : m_header(nullptr)
+    , m_data(nullptr)
+    , m_capacity(0)
+    , m_write_position(0)
+    , m_read_position(0)
+    , m_corrupted(false)
+{
+}
+
+inline shm_ring::shm_ring(void* memory, std::size_t capacity)
+    : m_header(static_cast<shm_ring_header*>(memory))
+    , m_data(static_cast<char*>(memory) + sizeof(shm_ring_header))
+    , m_capacity(capacity)
+    , m_write_position(0)
+    , m_read_position(0)
+    , m_corrupted(false)
+{
+}
+
+inline void shm_ring::initialize()
+{
+    m_write_position = 0;
+    m_read_position = 0;
+    m_corrupted = false;
+
+    new (m_header) shm_ring_header();
+    m_header->write_position.store(0);
+    m_header->reader_waiting.store(0);
+    m_header->read_position.store(0);
+    m_header->writer_waiting.store(0);
+}
+
+inline std::size_t shm_ring::get_capacity() const
+{
+    return m_capacity;
+}
+
+inline bool shm_ring::empty() const
+{
+    return m_header->write_position.load() == m_read_position;
+}
+
+inline bool shm_ring::full() const
+{
+    return m_write_position - m_header->read_position.load() == m_capacity;
+}
+
+inline bool shm_ring::is_corrupted() const
+{
+    return m_corrupted;
+}
+
+inline std::size_t shm_ring::write(const void* data, std::size_t length)
+{
+    if (m_corrupted) {
+        return 0;
+    }
+
+    const std::uint64_t write_position = m_write_position;
+    const std::uint64_t read_position =
+            m_header->read_position.load(std::memory_order_acquire);
+
+    // The reader can never be ahead of the writer or more than the capacity
+    // behind it.
+    const std::uint64_t used = write_position - read_position;
+    if (read_position > write_position || used > m_capacity) {
+        m_corrupted = true;
+        return 0;
+    }
+
+    const std::size_t available = m_capacity - static_cast<std::size_t>(used);
+    const std::size_t count = std::min(length, available);
+    if (count == 0) {
+        return 0;
+    }
+
+    const std::size_t offset = static_cast<std::size_t>(write_position & (m_capacity - 1));
+    const std::size_t first = std::min(count, m_capacity - offset);
+    std::memcpy(m_data + offset, data, first);
+    std::memcpy(m_data, static_cast<const char*>(data) + first, count - first);
+
+    m_write_position = write_position + count;
+    m_header->write_position.store(m_write_position);
+
+    return count;
+}
+
+inline std::size_t shm_ring::read(void* data, std::size_t length)
+{
+    if (m_corrupted) {
+        return 0;
+    }
+
+    const std::uint64_t read_position = m_read_position;
+    const std::uint64_t write_position =
+            m_header->write_position.load(std::memory_order_acquire);
+
+    // The writer can never be behind the reader or more than the capacity
+    // ahead of it.
+    if (write_position < read_position || write_position - read_position > m_capacity) {
+        m_corrupted = true;
+        return 0;
+    }
+
+    const std::size_t available = static_cast<std::size_t>(write_position - read_position);
+    const std::size_t count = std::min(length, available);
+    if (count == 0) {
+        return 0;
+    }
+
+    const std::size_t offset = static_cast<std::size_t>(read_position & (m_capacity - 1));
+    const std::size_t first = std::min(count, m_capacity - offset);
+    std::memcpy(data, m_data + offset, first);
+    std::memcpy(static_cast<char*>(data) + first, m_data, count - first);
+
+    m_read_position = read_position + count;
+    m_header->read_position.store(m_read_position);
+
+    return count;
+}
+
+inline bool shm_ring::prepare_reader_wait()
+{
+    m_header->reader_waiting.store(1);
+    if (!empty()) {
+        m_header->reader_waiting.store(0);
+        return false;
+    }
+
+    return true;
+}
+
+inline bool shm_ring::prepare_writer_wait()
+{
+    m_header->writer_waiting.store(1);
+    if (!full()) {
+        m_header->writer_waiting.store(0);
+        return false;
+    }
+
+    return true;
+}
+
+inline bool shm_ring::take_reader_waiting()
+{
+    return m_header->reader_waiting.load() != 0 &&
+            m_header->reader_waiting.exchange(0) != 0;
+}
+
+inline bool shm_ring::take_writer_waiting()
+{
+    return m_header->writer_waiting.load() != 0 &&
+            m_header->writer_waiting.exchange(0) != 0;
+}
+
+} // namespace bonefish
+
+#endif // BONEFISH_SHM_RING_HPP
@@ -0,0 +1,365 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <bonefish/rawsocket/shm_segment.hpp>
+
+#include <boost/system/error_code.hpp>
+#include <boost/system/system_error.hpp>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace bonefish {
+
+namespace {
+
+const std::uint32_t SETUP_MAGIC = 0x42465348; // "BFSH"
+const std::uint32_t SETUP_VERSION = 1;
+const std::size_t MIN_RING_CAPACITY = 4096;
+
+/// The setup message that accompanies the file descriptors of a segment.
+struct shm_setup
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint64_t ring_capacity;
+};
+
+/// File descriptors are passed in the order of the memory followed by the
+/// data and space events of the upstream and then the downstream channel.
+const std::size_t DESCRIPTOR_COUNT = 5;
+
+void throw_system_error(const char* what, int error = errno)
+{
+    throw boost::system::system_error(
+            boost::system::error_code(error, boost::system::system_category()), what);
+}
+
+void throw_protocol_error(const char* what)
+{
+    throw_system_error(what, EPROTO);
+}
+
+bool is_valid_ring_capacity(std::uint64_t capacity)
+{
+    return capacity >= MIN_RING_CAPACITY && (capacity & (capacity - 1)) == 0 &&
+            capacity <= (std::uint64_t(1) << 31);
+}
+
+} // namespace
+
+shm_channel::shm_channel()
+    : m_ring()
+    , m_data_event(-1)
+    , m_space_event(-1)
+{
+}
+
+void shm_channel::attach(void* memory, std::size_t capacity, int data_event, int space_event)
+{
+    m_ring = shm_ring(memory, capacity);
+    m_data_event = data_event;
+    m_space_event = space_event;
+}
+
+shm_ring& shm_channel::get_ring()
+{
+    return m_ring;
+}
+
+int shm_channel::get_data_event() const
+{
+    return m_data_event;
+}
+
+int shm_channel::get_space_event() const
+{
+    return m_space_event;
+}
+
+std::size_t shm_channel::write(const void* data, std::size_t length)
+{
+    std::size_t count = m_ring.write(data, length);
+    if (m_ring.is_corrupted()) {
+        throw_protocol_error("corrupted shared memory ring");
+    }
+    if (count != 0 && m_ring.take_reader_waiting()) {
+        signal_event(m_data_event);
+    }
+
+    return count;
+}
+
+std::size_t shm_channel::read(void* data, std::size_t length)
+{
+    std::size_t count = m_ring.read(data, length);
+    if (m_ring.is_corrupted()) {
+        throw_protocol_error("corrupted shared memory ring");
+    }
+    if (count != 0 && m_ring.take_writer_waiting()) {
+        signal_event(m_space_event);
+    }
+
+    return count;
+}
+
+void shm_channel::clear_event(int event)
+{
+    eventfd_t value;
+    while (eventfd_read(event, &value) != 0 && errno == EINTR) {
+        continue;
+    }
+}
+
+void shm_channel::signal_event(int event)
+{
+    // Signaling can only fail if the counter would overflow which cannot
+    // happen as every wakeup clears it again.
+    while (eventfd_write(event, 1) != 0 && errno == EINTR) {
+        continue;
+    }
+}
+
+shm_segment::shm_segment()
+    : m_memory(-1)
+    , m_events{-1, -1, -1, -1}
+    , m_mapping(nullptr)
+    , m_mapping_size(0)
+    , m_ring_capacity(0)
+    , m_upstream()
+    , m_downstream()
+{
+}
+
+shm_segment::~shm_segment()
+{
+    close();
+}
+
+void shm_segment::create(std::size_t ring_capacity)
+{
+    if (!is_valid_ring_capacity(ring_capacity)) {
+        throw std::invalid_argument("invalid shared memory ring capacity");
+    }
+
+    close();
+
+    m_memory = memfd_create("bonefish-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (m_memory == -1) {
+        throw_system_error("memfd_create");
+    }
+
+    if (ftruncate(m_memory, 2 * shm_ring::get_required_size(ring_capacity)) != 0) {
+        throw_system_error("ftruncate");
+    }
+
+    // The size is sealed before the memory is shared so that a component
+    // cannot truncate it underneath the mapping of the router.
+    if (fcntl(m_memory, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0) {
+        throw_system_error("fcntl");
+    }
+
+    for (std::size_t i = 0; i < EVENT_COUNT; ++i) {
+        m_events[i] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (m_events[i] == -1) {
+            throw_system_error("eventfd");
+        }
+    }
+
+    map(ring_capacity, true);
+}
+
+void shm_segment::send(int socket) const
+{
+    shm_setup setup;
+    setup.magic = SETUP_MAGIC;
+    setup.version = SETUP_VERSION;
+    setup.ring_capacity = m_ring_capacity;
+
+    int descriptors[DESCRIPTOR_COUNT] = {
+        m_memory, m_events[0], m_events[1], m_events[2], m_events[3]
+    };
+
+    iovec iov;
+    iov.iov_base = &setup;
+    iov.iov_len = sizeof(setup);
+
+    char control[CMSG_SPACE(sizeof(descriptors))];
+    std::memset(control, 0, sizeof(control));
+
+    msghdr message;
+    std::memset(&message, 0, sizeof(message));
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    cmsghdr* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(descriptors));
+    std::memcpy(CMSG_DATA(header), descriptors, sizeof(descriptors));
+
+    ssize_t result;
+    do {
+        result = sendmsg(socket, &message, MSG_NOSIGNAL);
+    } while (result == -1 && errno == EINTR);
+
+    if (result == -1) {
+        throw_system_error("sendmsg");
+    }
+    if (static_cast<std::size_t>(result) != sizeof(setup)) {
+        throw_protocol_error("short shared memory setup message");
+    }
+}
+
+void shm_segment::receive(int socket)
+{
+    close();
+
+    shm_setup setup;
+    iovec iov;
+    iov.iov_base = &setup;
+    iov.iov_len = sizeof(setup);
+
+    int descriptors[DESCRIPTOR_COUNT];
+    char control[CMSG_SPACE(sizeof(descriptors))];
+
+    msghdr message;
+    std::memset(&message, 0, sizeof(message));
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    ssize_t result;
+    do {
+        result = recvmsg(socket, &message, MSG_WAITALL | MSG_CMSG_CLOEXEC);
+    } while (result == -1 && errno == EINTR);
+
+    if (result == -1) {
+        throw_system_error("recvmsg");
+    }
+
+    // Take ownership of any descriptors that were received before looking at
+    // the setup message so that they are closed again if it is invalid.
+    cmsghdr* header = CMSG_FIRSTHDR(&message);
+    if (header && header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS &&
+            header->cmsg_len == CMSG_LEN(sizeof(descriptors))) {
+        std::memcpy(descriptors, CMSG_DATA(header), sizeof(descriptors));
+        m_memory = descriptors[0];
+        for (std::size_t i = 0; i < EVENT_COUNT; ++i) {
+            m_events[i] = descriptors[i + 1];
+        }
+    } else {
+        throw_protocol_error("missing shared memory descriptors");
+    }
+
+    if (static_cast<std::size_t>(result) != sizeof(setup) || (message.msg_flags & MSG_CTRUNC)) {
+        throw_protocol_error("truncated shared memory setup message");
+    }
+    if (setup.magic != SETUP_MAGIC || setup.version != SETUP_VERSION) {
+        throw_protocol_error("unsupported shared memory setup message");
+    }
+    if (!is_valid_ring_capacity(setup.ring_capacity)) {
+        throw_protocol_error("invalid shared memory ring capacity");
+    }
+
+    struct stat status;
+    if (fstat(m_memory, &status) != 0) {
+        throw_system_error("fstat");
+    }
+
+    const std::size_t ring_capacity = static_cast<std::size_t>(setup.ring_capacity);
+    if (static_cast<std::uint64_t>(status.st_size) < 2 * shm_ring::get_required_size(ring_capacity)) {
+        throw_protocol_error("shared memory segment is too small");
+    }
+
+    map(ring_capacity, false);
+}
+
+shm_channel& shm_segment::get_upstream()
+{
+    return m_upstream;
+}
+
+shm_channel& shm_segment::get_downstream()
+{
+    return m_downstream;
+}
+
+std::size_t shm_segment::get_ring_capacity() const
+{
+    return m_ring_capacity;
+}
+
+void shm_segment::map(std::size_t ring_capacity, bool initialize)
+{
+    const std::size_t ring_size = shm_ring::get_required_size(ring_capacity);
+    void* mapping = mmap(nullptr, 2 * ring_size,
+            PROT_READ | PROT_WRITE, MAP_SHARED, m_memory, 0);
+    if (mapping == MAP_FAILED) {
+        throw_system_error("mmap");
+    }
+
+    m_mapping = mapping;
+    m_mapping_size = 2 * ring_size;
+    m_ring_capacity = ring_capacity;
+
+    char* memory = static_cast<char*>(m_mapping);
+    m_upstream.attach(memory, ring_capacity, m_events[0], m_events[1]);
+    m_downstream.attach(memory + ring_size, ring_capacity, m_events[2], m_events[3]);
+
+    if (initialize) {
+        m_upstream.get_ring().initialize();
+        m_downstream.get_ring().initialize();
+    }
+}
+
+void shm_segment::close()
+{
+    m_upstream = shm_channel();
+    m_downstream = shm_channel();
+
+    if (m_mapping) {
+        munmap(m_mapping, m_mapping_size);
+        m_mapping = nullptr;
+        m_mapping_size = 0;
+    }
+    m_ring_capacity = 0;
+
+    if (m_memory != -1) {
+        ::close(m_memory);
+        m_memory = -1;
+    }
+
+    for (std::size_t i = 0; i < EVENT_COUNT; ++i) {
+        if (m_events[i] != -1) {
+            ::close(m_events[i]);
+            m_events[i] = -1;
+        }
+    }
+}
+
+} // namespace bonefish
@@ -0,0 +1,117 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_SHM_SEGMENT_HPP
+#define BONEFISH_SHM_SEGMENT_HPP
+
+#include <bonefish/rawsocket/shm_ring.hpp>
+
+#include <cstddef>
+
+namespace bonefish {
+
+/// One direction of a shared memory connection. The data event is signaled
+/// by the writer when the reader is waiting for data and the space event is
+/// signaled by the reader when the writer is waiting for space.
+class shm_channel
+{
+public:
+    shm_channel();
+
+    void attach(void* memory, std::size_t capacity, int data_event, int space_event);
+
+    shm_ring& get_ring();
+    int get_data_event() const;
+    int get_space_event() const;
+
+    /// Writes as much of the data as fits into the ring and wakes up the
+    /// reader if it is waiting. Throws boost::system::system_error if the
+    /// peer corrupted the ring.
+    std::size_t write(const void* data, std::size_t length);
+
+    /// Reads as much of the requested data as is available and wakes up the
+    /// writer if it is waiting for space. Throws boost::system::system_error
+    /// if the peer corrupted the ring.
+    std::size_t read(void* data, std::size_t length);
+
+    /// Resets an event after it has been signaled.
+    static void clear_event(int event);
+
+private:
+    static void signal_event(int event);
+
+private:
+    shm_ring m_ring;
+    int m_data_event;
+    int m_space_event;
+};
+
+/// A shared memory segment holding the two rings of a connection between a
+/// component and the router along with the eventfds used for wakeups. The
+/// router creates the segment and hands it over to the component through a
+/// unix domain socket which then only serves to detect when either side has
+/// gone away.
+///
+/// Errors are reported by throwing boost::system::system_error.
+class shm_segment
+{
+public:
+    static const std::size_t DEFAULT_RING_CAPACITY = 1024 * 1024;
+
+    shm_segment();
+    ~shm_segment();
+
+    shm_segment(const shm_segment&) = delete;
+    shm_segment& operator=(const shm_segment&) = delete;
+
+    /// Creates a new segment with rings of the given capacity which must be
+    /// a power of two of at least 4KiB.
+    void create(std::size_t ring_capacity);
+
+    /// Sends the segment to the peer of a connected unix domain socket.
+    void send(int socket) const;
+
+    /// Receives and maps a segment sent by the peer of a connected unix
+    /// domain socket.
+    void receive(int socket);
+
+    /// The channel carrying messages from the component to the router.
+    shm_channel& get_upstream();
+
+    /// The channel carrying messages from the router to the component.
+    shm_channel& get_downstream();
+
+    std::size_t get_ring_capacity() const;
+
+private:
+    void map(std::size_t ring_capacity, bool initialize);
+    void close();
+
+private:
+    static const std::size_t EVENT_COUNT = 4;
+
+    int m_memory;
+    int m_events[EVENT_COUNT];
+    void* m_mapping;
+    std::size_t m_mapping_size;
+    std::size_t m_ring_capacity;
+    shm_channel m_upstream;
+    shm_channel m_downstream;
+};
+
+} // namespace bonefish
+
+#endif // BONEFISH_SHM_SEGMENT_HPP
@@ -30,7 +30,9 @@ class tcp_connection :
         public rawsocket_connection
 {
 public:
-    tcp_connection(boost::asio::ip::tcp::socket&& socket);
+    /// The io service is the one that services the socket.
+    tcp_connection(boost::asio::io_service& io_service,
+            boost::asio::ip::tcp::socket&& socket);
     virtual ~tcp_connection() override;
 
     virtual void async_read(
@@ -43,12 +45,18 @@ public:
             size_t length,
             boost::system::error_code& error_code) override;
 
+    virtual boost::asio::io_service* get_io_service() override;
+    virtual void close() override;
+
 private:
+    boost::asio::io_service& m_io_service;
     boost::asio::ip::tcp::socket m_socket;
 };
 
-inline tcp_connection::tcp_connection(boost::asio::ip::tcp::socket&& socket)
+inline tcp_connection::tcp_connection(boost::asio::io_service& io_service,
+        boost::asio::ip::tcp::socket&& socket)
     : rawsocket_connection()
+    , m_io_service(io_service)
     , m_socket(std::move(socket))
 {
     // Disable Nagle algorithm to get lower latency (and lower throughput).
@@ -78,6 +86,17 @@ inline void tcp_connection::write(
     boost::asio::write(m_socket, boost::asio::buffer(data, length), error_code);
 }
 
+inline boost::asio::io_service* tcp_connection::get_io_service()
+{
+    return &m_io_service;
+}
+
+inline void tcp_connection::close()
+{
+    boost::system::error_code error_code;
+    m_socket.close(error_code);
+}
+
 } // namespace bonefish
 
 #endif // BONEFISH_TCP_CONNECTION_HPP
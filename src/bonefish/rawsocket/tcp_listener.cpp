@@ -16,20 +16,57 @@
 
 #include <bonefish/rawsocket/tcp_listener.hpp>
 #include <bonefish/rawsocket/tcp_connection.hpp>
+#include <bonefish/trace/trace.hpp>
+
+#include <boost/asio/detail/socket_option.hpp>
+#include <stdexcept>
 
 namespace bonefish {
 
+#if defined(SO_REUSEPORT)
+typedef boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT> reuse_port;
+#endif
+
+tcp_listener::acceptor::acceptor(boost::asio::io_service& io_service)
+    : m_io_service(io_service)
+    , m_socket(io_service)
+    , m_acceptor(io_service)
+{
+}
+
 tcp_listener::tcp_listener(
         boost::asio::io_service& io_service,
         const boost::asio::ip::address& ip_address,
         uint16_t port)
     : rawsocket_listener()
-    , m_socket(io_service)
-    , m_acceptor(io_service)
+    , m_acceptors(1, std::make_shared<acceptor>(io_service))
     , m_endpoint(ip_address, port)
 {
 }
 
+tcp_listener::tcp_listener(
+        const std::vector<boost::asio::io_service*>& io_services,
+        const boost::asio::ip::address& ip_address,
+        uint16_t port)
+    : rawsocket_listener()
+    , m_acceptors()
+    , m_endpoint(ip_address, port)
+{
+    if (io_services.empty()) {
+        throw std::invalid_argument("no io services to accept connections on");
+    }
+
+#if !defined(SO_REUSEPORT)
+    if (io_services.size() > 1) {
+        throw std::invalid_argument("multiple acceptors require SO_REUSEPORT support");
+    }
+#endif
+
+    for (boost::asio::io_service* io_service : io_services) {
+        m_acceptors.push_back(std::make_shared<acceptor>(*io_service));
+    }
+}
+
 tcp_listener::~tcp_listener()
 {
     stop_listening();
@@ -41,11 +78,20 @@ void tcp_listener::start_listening()
         return;
     }
 
-    m_acceptor.open(m_endpoint.protocol());
-    m_acceptor.set_option(
-           boost::asio::ip::tcp::acceptor::reuse_address(true));
-    m_acceptor.bind(m_endpoint);
-    m_acceptor.listen();
+    for (const auto& acceptor : m_acceptors) {
+        acceptor->m_acceptor.open(m_endpoint.protocol());
+        acceptor->m_acceptor.set_option(
+               boost::asio::ip::tcp::acceptor::reuse_address(true));
+#if defined(SO_REUSEPORT)
+        if (m_acceptors.size() > 1) {
+            acceptor->m_acceptor.set_option(reuse_port(true));
+        }
+#endif
+        acceptor->m_acceptor.bind(m_endpoint);
+        acceptor->m_acceptor.listen();
+    }
+
+    BONEFISH_TRACE("listening on %1% with %2% acceptor(s)", m_endpoint % m_acceptors.size());
 
     set_listening(true);
     assert(get_accept_handler());
@@ -58,21 +104,52 @@ void tcp_listener::stop_listening()
         return;
     }
 
-    m_acceptor.close();
+    // Each acceptor is closed on its own io service so that it does not
+    // race with an accept that is completing on that thread.
+    for (const auto& acceptor : m_acceptors) {
+        std::shared_ptr<tcp_listener::acceptor> closing_acceptor = acceptor;
+        acceptor->m_io_service.dispatch([closing_acceptor]() {
+            boost::system::error_code error_code;
+            closing_acceptor->m_acceptor.close(error_code);
+        });
+    }
     set_listening(false);
 }
 
 std::shared_ptr<rawsocket_connection> tcp_listener::create_connection()
 {
-    return std::make_shared<tcp_connection>(std::move(m_socket));
+    const auto& acceptor = m_acceptors.front();
+    return std::make_shared<tcp_connection>(acceptor->m_io_service, std::move(acceptor->m_socket));
 }
 
 void tcp_listener::async_accept()
 {
-    m_acceptor.async_accept(m_socket,
-            std::bind(&rawsocket_listener::handle_accept,
+    for (const auto& acceptor : m_acceptors) {
+        async_accept(acceptor);
+    }
+}
+
+void tcp_listener::async_accept(const std::shared_ptr<acceptor>& acceptor)
+{
+    acceptor->m_acceptor.async_accept(acceptor->m_socket,
+            std::bind(&tcp_listener::on_accept,
                     shared_from_this(),
+                    acceptor,
                     std::placeholders::_1));
 }
 
+void tcp_listener::on_accept(const std::shared_ptr<acceptor>& acceptor,
+        const boost::system::error_code& error_code)
+{
+    if (error_code) {
+        return;
+    }
+
+    assert(get_accept_handler());
+    const auto& accept_handler = get_accept_handler();
+    accept_handler(std::make_shared<tcp_connection>(
+            acceptor->m_io_service, std::move(acceptor->m_socket)));
+    async_accept(acceptor);
+}
+
 } // namespace bonefish
@@ -23,9 +23,14 @@
 #include <boost/asio/ip/tcp.hpp>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace bonefish {
 
+/// Listens for rawsocket connections on a tcp port. A listener created with
+/// several io services opens one SO_REUSEPORT acceptor on each of them so
+/// that the kernel spreads incoming connections across their threads. Each
+/// connection stays on the io service of the acceptor that accepted it.
 class tcp_listener :
         public rawsocket_listener,
         public std::enable_shared_from_this<tcp_listener>
@@ -35,6 +40,10 @@ public:
             boost::asio::io_service& io_service,
             const boost::asio::ip::address& ip_address,
             uint16_t port);
+    tcp_listener(
+            const std::vector<boost::asio::io_service*>& io_services,
+            const boost::asio::ip::address& ip_address,
+            uint16_t port);
     virtual ~tcp_listener() override;
 
     virtual void start_listening() override;
@@ -45,8 +54,21 @@ protected:
     virtual void async_accept() override;
 
 private:
-    boost::asio::ip::tcp::socket m_socket;
-    boost::asio::ip::tcp::acceptor m_acceptor;
+    struct acceptor
+    {
+        explicit acceptor(boost::asio::io_service& io_service);
+
+        boost::asio::io_service& m_io_service;
+        boost::asio::ip::tcp::socket m_socket;
+        boost::asio::ip::tcp::acceptor m_acceptor;
+    };
+
+    void async_accept(const std::shared_ptr<acceptor>& acceptor);
+    void on_accept(const std::shared_ptr<acceptor>& acceptor,
+            const boost::system::error_code& error_code);
+
+private:
+    std::vector<std::shared_ptr<acceptor>> m_acceptors;
     boost::asio::ip::tcp::endpoint m_endpoint;
 };
 
@@ -0,0 +1,79 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_URING_CONNECTION_HPP
+#define BONEFISH_URING_CONNECTION_HPP
+
+#include <bonefish/rawsocket/rawsocket_connection.hpp>
+#include <bonefish/rawsocket/uring_service.hpp>
+#include <bonefish/rawsocket/uring_socket.hpp>
+
+#include <memory>
+
+namespace bonefish {
+
+class uring_connection : public rawsocket_connection
+{
+public:
+    uring_connection(const std::shared_ptr<uring_service>& service, int socket);
+    virtual ~uring_connection() override;
+
+    virtual void async_read(
+            void* data,
+            size_t length,
+            const read_handler& handler) override;
+
+    virtual void write(
+            const void* data,
+            size_t length,
+            boost::system::error_code& error_code) override;
+
+private:
+    std::shared_ptr<uring_socket> m_socket;
+};
+
+inline uring_connection::uring_connection(
+        const std::shared_ptr<uring_service>& service, int socket)
+    : rawsocket_connection()
+    , m_socket(std::make_shared<uring_socket>(service, socket))
+{
+}
+
+inline uring_connection::~uring_connection()
+{
+    // The socket lingers until its outstanding operations have completed.
+    m_socket->close();
+}
+
+inline void uring_connection::async_read(
+        void* data,
+        size_t length,
+        const read_handler& handler)
+{
+    m_socket->async_read(data, length, handler);
+}
+
+inline void uring_connection::write(
+        const void* data,
+        size_t length,
+        boost::system::error_code& error_code)
+{
+    m_socket->write(data, length, error_code);
+}
+
+} // namespace bonefish
+
+#endif // BONEFISH_URING_CONNECTION_HPP
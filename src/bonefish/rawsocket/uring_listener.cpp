@@ -0,0 +1,196 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <bonefish/rawsocket/uring_listener.hpp>
+#include <bonefish/rawsocket/uring_connection.hpp>
+#include <bonefish/trace/trace.hpp>
+
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace bonefish {
+
+uring_listener::uring_listener(
+        const std::shared_ptr<uring_service>& service,
+        const boost::asio::ip::address& ip_address,
+        uint16_t port)
+    : rawsocket_listener()
+    , m_service(service)
+    , m_acceptor(service->get_io_service())
+    , m_endpoint(boost::asio::ip::tcp::endpoint(ip_address, port))
+    , m_path()
+    , m_accept(*this)
+    , m_accept_keep_alive()
+    , m_multishot(true)
+    , m_accepted_socket(-1)
+    , m_retry_timer(service->get_io_service())
+{
+}
+
+uring_listener::uring_listener(
+        const std::shared_ptr<uring_service>& service,
+        const std::string& path)
+    : rawsocket_listener()
+    , m_service(service)
+    , m_acceptor(service->get_io_service())
+    , m_endpoint(boost::asio::local::stream_protocol::endpoint(path))
+    , m_path(path)
+    , m_accept(*this)
+    , m_accept_keep_alive()
+    , m_multishot(true)
+    , m_accepted_socket(-1)
+    , m_retry_timer(service->get_io_service())
+{
+}
+
+uring_listener::~uring_listener()
+{
+    stop_listening();
+}
+
+void uring_listener::start_listening()
+{
+    if (is_listening()) {
+        return;
+    }
+
+    if (!m_path.empty()) {
+        unlink(m_path.c_str());
+    }
+
+    m_acceptor.open(m_endpoint.protocol());
+    m_acceptor.set_option(
+           boost::asio::socket_base::reuse_address(true));
+    m_acceptor.bind(m_endpoint);
+    m_acceptor.listen();
+
+    m_service->start();
+
+    assert(get_accept_handler());
+    set_listening(true);
+    async_accept();
+}
+
+void uring_listener::stop_listening()
+{
+    if (!is_listening()) {
+        return;
+    }
+
+    set_listening(false);
+    boost::system::error_code ignored;
+    m_retry_timer.cancel(ignored);
+    if (m_accept_keep_alive) {
+        io_uring_sqe* sqe = m_service->get_sqe(nullptr);
+        if (sqe) {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->addr = reinterpret_cast<std::uint64_t>(static_cast<uring_operation*>(&m_accept));
+        }
+    }
+    m_acceptor.close();
+}
+
+std::shared_ptr<rawsocket_connection> uring_listener::create_connection()
+{
+    const int socket = m_accepted_socket;
+    m_accepted_socket = -1;
+
+    if (m_path.empty()) {
+        // Disable Nagle algorithm to get lower latency (and lower throughput).
+        int no_delay = 1;
+        setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+    }
+
+    return std::make_shared<uring_connection>(m_service, socket);
+}
+
+void uring_listener::async_accept()
+{
+    // A multishot accept stays armed across connections so there is
+    // nothing to do if one is already in flight.
+    if (m_accept_keep_alive || !is_listening()) {
+        return;
+    }
+
+    io_uring_sqe* sqe = m_service->get_sqe(&m_accept);
+    if (!sqe) {
+        retry_accept();
+        return;
+    }
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = m_acceptor.native_handle();
+    sqe->accept_flags = SOCK_CLOEXEC;
+    if (m_multishot) {
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    }
+
+    m_accept_keep_alive = shared_from_this();
+}
+
+void uring_listener::on_accept(int result, std::uint32_t flags)
+{
+    std::shared_ptr<uring_listener> shared_self = m_accept_keep_alive;
+    if (!(flags & IORING_CQE_F_MORE)) {
+        m_accept_keep_alive.reset();
+    }
+
+    if (result >= 0) {
+        if (!is_listening()) {
+            close(result);
+            return;
+        }
+
+        m_accepted_socket = result;
+        handle_accept(boost::system::error_code());
+        return;
+    }
+
+    if (result == -EINVAL && m_multishot) {
+        BONEFISH_TRACE("multishot accept is not supported, falling back to single accepts");
+        m_multishot = false;
+    } else if (result != -ECANCELED) {
+        BONEFISH_TRACE("failed to accept connection: %1%", std::strerror(-result));
+    }
+
+    // Accepting again right away would only fail again until some file
+    // descriptors or memory have been released.
+    if (result == -EMFILE || result == -ENFILE || result == -ENOBUFS || result == -ENOMEM) {
+        retry_accept();
+        return;
+    }
+
+    async_accept();
+}
+
+void uring_listener::retry_accept()
+{
+    std::weak_ptr<uring_listener> weak_self = shared_from_this();
+    m_retry_timer.expires_from_now(boost::posix_time::milliseconds(ACCEPT_RETRY_DELAY_MS));
+    m_retry_timer.async_wait([weak_self](const boost::system::error_code& error_code) {
+        auto shared_self = weak_self.lock();
+        if (shared_self && !error_code) {
+            shared_self->async_accept();
+        }
+    });
+}
+
+} // namespace bonefish
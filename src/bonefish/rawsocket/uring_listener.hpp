@@ -0,0 +1,94 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_URING_LISTENER_HPP
+#define BONEFISH_URING_LISTENER_HPP
+
+#include <bonefish/rawsocket/rawsocket_listener.hpp>
+#include <bonefish/rawsocket/uring_service.hpp>
+
+#include <boost/asio/basic_socket_acceptor.hpp>
+#include <boost/asio/deadline_timer.hpp>
+#include <boost/asio/generic/stream_protocol.hpp>
+#include <boost/asio/ip/address.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace bonefish {
+
+/// A tcp or uds listener whose connections are serviced by io_uring. A
+/// single multishot accept keeps delivering new connections without being
+/// re-armed. Kernels that predate multishot accept fall back to re-arming
+/// a regular accept after each connection.
+class uring_listener :
+        public rawsocket_listener,
+        public std::enable_shared_from_this<uring_listener>
+{
+public:
+    uring_listener(
+            const std::shared_ptr<uring_service>& service,
+            const boost::asio::ip::address& ip_address,
+            uint16_t port);
+    uring_listener(
+            const std::shared_ptr<uring_service>& service,
+            const std::string& path);
+    virtual ~uring_listener() override;
+
+    virtual void start_listening() override;
+    virtual void stop_listening() override;
+    virtual std::shared_ptr<rawsocket_connection> create_connection() override;
+
+protected:
+    virtual void async_accept() override;
+
+private:
+    class accept_operation : public uring_operation
+    {
+    public:
+        explicit accept_operation(uring_listener& listener) : m_listener(listener) {}
+        virtual void complete(int result, std::uint32_t flags) override
+        {
+            m_listener.on_accept(result, flags);
+        }
+
+    private:
+        uring_listener& m_listener;
+    };
+
+    void on_accept(int result, std::uint32_t flags);
+    void retry_accept();
+
+private:
+    /// How long to wait before accepting again after running out of file
+    /// descriptors or memory.
+    static const long ACCEPT_RETRY_DELAY_MS = 100;
+
+    std::shared_ptr<uring_service> m_service;
+    boost::asio::basic_socket_acceptor<boost::asio::generic::stream_protocol> m_acceptor;
+    boost::asio::generic::stream_protocol::endpoint m_endpoint;
+    std::string m_path;
+
+    accept_operation m_accept;
+    std::shared_ptr<uring_listener> m_accept_keep_alive;
+    bool m_multishot;
+    int m_accepted_socket;
+    boost::asio::deadline_timer m_retry_timer;
+};
+
+} // namespace bonefish
+
+#endif // BONEFISH_URING_LISTENER_HPP
@@ -0,0 +1,475 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <bonefish/rawsocket/uring_service.hpp>
+#include <bonefish/rawsocket/uring_socket.hpp>
+#include <bonefish/trace/trace.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <boost/asio/buffer.hpp>
+#include <boost/system/error_code.hpp>
+#include <boost/system/system_error.hpp>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace bonefish {
+
+namespace {
+
+int io_uring_setup(unsigned entries, io_uring_params* params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int io_uring_enter(int ring, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, ring, to_submit, min_complete, flags,
+            nullptr, 0));
+}
+
+int io_uring_register(int ring, unsigned opcode, void* arg, unsigned nr_args)
+{
+    return static_cast<int>(syscall(__NR_io_uring_register, ring, opcode, arg, nr_args));
+}
+
+void throw_system_error(const char* what)
+{
+    throw boost::system::system_error(
+            boost::system::error_code(errno, boost::system::system_category()), what);
+}
+
+unsigned load_acquire(const unsigned* value)
+{
+    return reinterpret_cast<const std::atomic<unsigned>*>(value)->load(std::memory_order_acquire);
+}
+
+void store_release(unsigned* value, unsigned new_value)
+{
+    reinterpret_cast<std::atomic<unsigned>*>(value)->store(new_value, std::memory_order_release);
+}
+
+} // namespace
+
+bool uring_service::is_supported()
+{
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int ring = io_uring_setup(8, &params);
+    if (ring < 0) {
+        return false;
+    }
+
+    const std::size_t probe_size = sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+    std::vector<char> probe_buffer(probe_size, 0);
+    io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(probe_buffer.data());
+    bool supported = io_uring_register(ring, IORING_REGISTER_PROBE, probe, 256) == 0;
+    close(ring);
+
+    if (!supported) {
+        return false;
+    }
+
+    const unsigned required[] = {
+        IORING_OP_ACCEPT,
+        IORING_OP_ASYNC_CANCEL,
+        IORING_OP_PROVIDE_BUFFERS,
+        IORING_OP_RECV,
+        IORING_OP_SENDMSG
+    };
+
+    for (unsigned opcode : required) {
+        if (opcode > probe->last_op || !(probe->ops[opcode].flags & IO_URING_OP_SUPPORTED)) {
+            return false;
+        }
+    }
+
+    // Selected buffers are only reported reliably with the single mmap and
+    // nodrop features which both predate multishot accept.
+    return (params.features & IORING_FEAT_SINGLE_MMAP) && (params.features & IORING_FEAT_NODROP);
+}
+
+uring_service::uring_service(
+        boost::asio::io_service& io_service,
+        unsigned entries,
+        std::size_t buffer_count,
+        std::size_t buffer_size)
+    : m_io_service(io_service)
+    , m_ring(-1)
+    , m_event(io_service)
+    , m_event_value(0)
+    , m_sq_mapping(nullptr)
+    , m_sq_mapping_size(0)
+    , m_cq_mapping(nullptr)
+    , m_cq_mapping_size(0)
+    , m_sqes(nullptr)
+    , m_sqes_size(0)
+    , m_sq_head(nullptr)
+    , m_sq_tail(nullptr)
+    , m_sq_mask(nullptr)
+    , m_sq_array(nullptr)
+    , m_sq_entries(0)
+    , m_sq_pending(0)
+    , m_cq_head(nullptr)
+    , m_cq_tail(nullptr)
+    , m_cq_mask(nullptr)
+    , m_cqes(nullptr)
+    , m_buffers()
+    , m_buffer_count(buffer_count)
+    , m_buffer_size(buffer_size)
+    , m_unprovided_buffers()
+    , m_started(false)
+    , m_deferred_scheduled(false)
+    , m_flushes()
+    , m_flushing()
+{
+    if (buffer_count == 0 || buffer_count > 65536 || buffer_size == 0) {
+        throw std::invalid_argument("invalid io_uring buffer configuration");
+    }
+
+    // Each connection may have a receive and a few linked sends in flight
+    // so the completion queue is sized generously to avoid overflowing.
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = entries * 4;
+
+    m_ring = io_uring_setup(entries, &params);
+    if (m_ring < 0) {
+        throw_system_error("io_uring_setup");
+    }
+
+    try {
+        m_sq_mapping_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        m_cq_mapping_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            m_sq_mapping_size = std::max(m_sq_mapping_size, m_cq_mapping_size);
+        }
+
+        m_sq_mapping = mmap(nullptr, m_sq_mapping_size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_SQ_RING);
+        if (m_sq_mapping == MAP_FAILED) {
+            m_sq_mapping = nullptr;
+            throw_system_error("mmap");
+        }
+
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            m_cq_mapping = m_sq_mapping;
+        } else {
+            m_cq_mapping = mmap(nullptr, m_cq_mapping_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_CQ_RING);
+            if (m_cq_mapping == MAP_FAILED) {
+                m_cq_mapping = nullptr;
+                throw_system_error("mmap");
+            }
+        }
+
+        m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            throw_system_error("mmap");
+        }
+        m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+        char* sq = static_cast<char*>(m_sq_mapping);
+        m_sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        m_sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        m_sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        m_sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        m_sq_entries = params.sq_entries;
+
+        char* cq = static_cast<char*>(m_cq_mapping);
+        m_cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        m_cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        m_cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        int event = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (event == -1) {
+            throw_system_error("eventfd");
+        }
+        m_event.assign(event);
+
+        if (io_uring_register(m_ring, IORING_REGISTER_EVENTFD, &event, 1) != 0) {
+            throw_system_error("io_uring_register");
+        }
+    } catch (...) {
+        stop();
+        throw;
+    }
+}
+
+uring_service::~uring_service()
+{
+    stop();
+}
+
+void uring_service::start()
+{
+    if (m_started) {
+        return;
+    }
+
+    m_started = true;
+    m_buffers.resize(m_buffer_count * m_buffer_size);
+
+    io_uring_sqe* sqe = get_sqe(nullptr);
+    if (!sqe) {
+        throw std::runtime_error("failed to provide buffers to io_uring");
+    }
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = static_cast<int>(m_buffer_count);
+    sqe->addr = reinterpret_cast<std::uint64_t>(m_buffers.data());
+    sqe->len = static_cast<std::uint32_t>(m_buffer_size);
+    sqe->off = 0;
+    sqe->buf_group = BUFFER_GROUP;
+
+    submit();
+    async_wait();
+}
+
+void uring_service::stop()
+{
+    boost::system::error_code ignored;
+    m_event.close(ignored);
+
+    if (m_sqes) {
+        munmap(m_sqes, m_sqes_size);
+        m_sqes = nullptr;
+    }
+    if (m_cq_mapping && m_cq_mapping != m_sq_mapping) {
+        munmap(m_cq_mapping, m_cq_mapping_size);
+    }
+    m_cq_mapping = nullptr;
+    if (m_sq_mapping) {
+        munmap(m_sq_mapping, m_sq_mapping_size);
+        m_sq_mapping = nullptr;
+    }
+    if (m_ring != -1) {
+        close(m_ring);
+        m_ring = -1;
+    }
+
+    m_started = false;
+}
+
+boost::asio::io_service& uring_service::get_io_service()
+{
+    return m_io_service;
+}
+
+io_uring_sqe* uring_service::get_sqe(uring_operation* operation)
+{
+    if (m_ring == -1) {
+        throw std::logic_error("io_uring service has been stopped");
+    }
+
+    unsigned tail = *m_sq_tail;
+    if (tail - load_acquire(m_sq_head) == m_sq_entries) {
+        submit();
+        tail = *m_sq_tail;
+
+        // The kernel refused the submission so every entry is still owned
+        // by it and none of them may be overwritten.
+        if (tail - load_acquire(m_sq_head) == m_sq_entries) {
+            BONEFISH_TRACE("io_uring submission queue is full");
+            return nullptr;
+        }
+    }
+
+    const unsigned index = tail & *m_sq_mask;
+    io_uring_sqe* sqe = &m_sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->user_data = reinterpret_cast<std::uint64_t>(operation);
+
+    m_sq_array[index] = index;
+    store_release(m_sq_tail, tail + 1);
+    ++m_sq_pending;
+    schedule_submit();
+
+    return sqe;
+}
+
+bool uring_service::reserve_sqes(unsigned count)
+{
+    if (m_sq_entries - (*m_sq_tail - load_acquire(m_sq_head)) < count) {
+        submit();
+    }
+
+    return m_sq_entries - (*m_sq_tail - load_acquire(m_sq_head)) >= count;
+}
+
+std::uint16_t uring_service::get_buffer_group() const
+{
+    return BUFFER_GROUP;
+}
+
+std::size_t uring_service::get_buffer_size() const
+{
+    return m_buffer_size;
+}
+
+const char* uring_service::get_buffer(std::uint16_t buffer_id) const
+{
+    return m_buffers.data() + buffer_id * m_buffer_size;
+}
+
+void uring_service::provide_buffer(std::uint16_t buffer_id)
+{
+    if (m_ring == -1) {
+        return;
+    }
+
+    io_uring_sqe* sqe = get_sqe(nullptr);
+    if (!sqe) {
+        m_unprovided_buffers.push_back(buffer_id);
+        return;
+    }
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = 1;
+    sqe->addr = reinterpret_cast<std::uint64_t>(get_buffer(buffer_id));
+    sqe->len = static_cast<std::uint32_t>(m_buffer_size);
+    sqe->off = buffer_id;
+    sqe->buf_group = BUFFER_GROUP;
+}
+
+void uring_service::schedule_flush(const std::shared_ptr<uring_socket>& socket)
+{
+    m_flushes.push_back(socket);
+    if (!m_deferred_scheduled) {
+        m_deferred_scheduled = true;
+        std::weak_ptr<uring_service> weak_self = shared_from_this();
+        m_io_service.post([weak_self]() {
+            auto shared_self = weak_self.lock();
+            if (shared_self) {
+                shared_self->run_deferred();
+            }
+        });
+    }
+}
+
+void uring_service::schedule_submit()
+{
+    if (!m_deferred_scheduled && m_started) {
+        m_deferred_scheduled = true;
+        std::weak_ptr<uring_service> weak_self = shared_from_this();
+        m_io_service.post([weak_self]() {
+            auto shared_self = weak_self.lock();
+            if (shared_self) {
+                shared_self->run_deferred();
+            }
+        });
+    }
+}
+
+void uring_service::submit()
+{
+    while (m_sq_pending != 0) {
+        int result = io_uring_enter(m_ring, m_sq_pending, 0, 0);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            // The completion queue is full so make some room before trying
+            // to submit again.
+            if (errno == EBUSY || errno == EAGAIN) {
+                reap();
+                continue;
+            }
+
+            BONEFISH_TRACE("failed to submit to io_uring: %1%", std::strerror(errno));
+            return;
+        }
+        m_sq_pending -= std::min(m_sq_pending, static_cast<unsigned>(result));
+    }
+}
+
+void uring_service::provide_unprovided_buffers()
+{
+    std::vector<std::uint16_t> buffer_ids;
+    buffer_ids.swap(m_unprovided_buffers);
+    for (std::uint16_t buffer_id : buffer_ids) {
+        provide_buffer(buffer_id);
+    }
+}
+
+void uring_service::async_wait()
+{
+    std::weak_ptr<uring_service> weak_self = shared_from_this();
+    auto handler = [weak_self](const boost::system::error_code& error_code, size_t) {
+        auto shared_self = weak_self.lock();
+        if (!shared_self || error_code == boost::asio::error::operation_aborted) {
+            return;
+        }
+
+        shared_self->reap();
+        shared_self->provide_unprovided_buffers();
+        shared_self->submit();
+        shared_self->async_wait();
+    };
+
+    // Reading the eventfd both waits for and clears the notification.
+    m_event.async_read_some(boost::asio::buffer(&m_event_value, sizeof(m_event_value)), handler);
+}
+
+void uring_service::reap()
+{
+    // The head is reloaded on every iteration since completions may end up
+    // reaping recursively when they have to wait for room to submit.
+    for (;;) {
+        const unsigned head = *m_cq_head;
+        if (head == load_acquire(m_cq_tail)) {
+            break;
+        }
+
+        const io_uring_cqe& cqe = m_cqes[head & *m_cq_mask];
+        uring_operation* operation = reinterpret_cast<uring_operation*>(cqe.user_data);
+        const int result = cqe.res;
+        const std::uint32_t flags = cqe.flags;
+
+        // Release the entry before dispatching as the operation may well
+        // submit new work which could otherwise overflow the queue.
+        store_release(m_cq_head, head + 1);
+
+        if (operation) {
+            operation->complete(result, flags);
+        } else if (result < 0) {
+            BONEFISH_TRACE("io_uring operation failed: %1%", std::strerror(-result));
+        }
+    }
+}
+
+void uring_service::run_deferred()
+{
+    m_deferred_scheduled = false;
+
+    m_flushing.swap(m_flushes);
+    for (const auto& socket : m_flushing) {
+        socket->flush();
+    }
+    m_flushing.clear();
+
+    submit();
+}
+
+} // namespace bonefish
@@ -0,0 +1,152 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_URING_SERVICE_HPP
+#define BONEFISH_URING_SERVICE_HPP
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <linux/io_uring.h>
+#include <memory>
+#include <vector>
+
+namespace bonefish {
+
+class uring_socket;
+
+/// An operation that has been submitted to the io_uring. Operations are
+/// owned by whoever submitted them and have to stay alive until their final
+/// completion has been delivered.
+class uring_operation
+{
+public:
+    virtual ~uring_operation() = default;
+    virtual void complete(int result, std::uint32_t flags) = 0;
+};
+
+/// Drives an io_uring instance from a boost io_service. Completions are
+/// picked up through an eventfd registered with the ring so the ring is
+/// serviced by the same thread as everything else. Submissions are batched
+/// and handed to the kernel once per io_service turn.
+///
+/// The service also owns the pool of provided buffers that receives are
+/// served from so that idle connections do not hold on to any buffers.
+///
+/// Errors during setup are reported by throwing boost::system::system_error.
+class uring_service :
+        public std::enable_shared_from_this<uring_service>
+{
+public:
+    static const unsigned DEFAULT_ENTRIES = 4096;
+    static const std::size_t DEFAULT_BUFFER_COUNT = 4096;
+    static const std::size_t DEFAULT_BUFFER_SIZE = 4096;
+
+    /// Returns whether the running kernel supports all of the io_uring
+    /// operations that the service relies on.
+    static bool is_supported();
+
+    uring_service(
+            boost::asio::io_service& io_service,
+            unsigned entries = DEFAULT_ENTRIES,
+            std::size_t buffer_count = DEFAULT_BUFFER_COUNT,
+            std::size_t buffer_size = DEFAULT_BUFFER_SIZE);
+    ~uring_service();
+
+    uring_service(const uring_service&) = delete;
+    uring_service& operator=(const uring_service&) = delete;
+
+    /// Provides the receive buffers to the kernel and starts servicing
+    /// completions. Calling this more than once has no effect.
+    void start();
+    void stop();
+
+    boost::asio::io_service& get_io_service();
+
+    /// Returns a cleared submission queue entry for the given operation. The
+    /// operation may be null for submissions whose completion is ignored.
+    /// Returns null if the queue is still full after submitting to the
+    /// kernel in which case the operation has to be failed.
+    io_uring_sqe* get_sqe(uring_operation* operation);
+
+    /// Makes sure that the given number of entries can be queued without an
+    /// intermediate submission which would break up a chain of linked ones.
+    /// Returns false if there is not enough room even after submitting.
+    bool reserve_sqes(unsigned count);
+
+    std::uint16_t get_buffer_group() const;
+    std::size_t get_buffer_size() const;
+    const char* get_buffer(std::uint16_t buffer_id) const;
+
+    /// Returns a buffer that was selected by a receive back to the kernel.
+    void provide_buffer(std::uint16_t buffer_id);
+
+    /// Flushes the socket's queued writes once the current handler returns.
+    void schedule_flush(const std::shared_ptr<uring_socket>& socket);
+
+private:
+    void schedule_submit();
+    void submit();
+    void provide_unprovided_buffers();
+    void async_wait();
+    void reap();
+    void run_deferred();
+
+private:
+    static const std::uint16_t BUFFER_GROUP = 1;
+
+    boost::asio::io_service& m_io_service;
+    int m_ring;
+    boost::asio::posix::stream_descriptor m_event;
+    std::uint64_t m_event_value;
+
+    void* m_sq_mapping;
+    std::size_t m_sq_mapping_size;
+    void* m_cq_mapping;
+    std::size_t m_cq_mapping_size;
+    io_uring_sqe* m_sqes;
+    std::size_t m_sqes_size;
+
+    unsigned* m_sq_head;
+    unsigned* m_sq_tail;
+    unsigned* m_sq_mask;
+    unsigned* m_sq_array;
+    unsigned m_sq_entries;
+    unsigned m_sq_pending;
+
+    unsigned* m_cq_head;
+    unsigned* m_cq_tail;
+    unsigned* m_cq_mask;
+    io_uring_cqe* m_cqes;
+
+    std::vector<char> m_buffers;
+    std::size_t m_buffer_count;
+    std::size_t m_buffer_size;
+
+    /// Buffers that could not be returned to the kernel because the
+    /// submission queue was full. They are retried as completions arrive.
+    std::vector<std::uint16_t> m_unprovided_buffers;
+
+    bool m_started;
+    bool m_deferred_scheduled;
+    std::vector<std::shared_ptr<uring_socket>> m_flushes;
+    std::vector<std::shared_ptr<uring_socket>> m_flushing;
+};
+
+} // namespace bonefish
+
+#endif // BONEFISH_URING_SERVICE_HPP
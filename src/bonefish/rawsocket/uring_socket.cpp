@@ -0,0 +1,375 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <bonefish/rawsocket/uring_socket.hpp>
+
+#include <algorithm>
+#include <boost/asio/error.hpp>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+namespace bonefish {
+
+uring_socket::uring_socket(const std::shared_ptr<uring_service>& service, int socket)
+    : m_service(service)
+    , m_socket(socket)
+    , m_receive(*this)
+    , m_receive_keep_alive()
+    , m_sends()
+    , m_send_results()
+    , m_send_count(0)
+    , m_send_keep_alive()
+    , m_sends_in_flight(0)
+    , m_read_data(nullptr)
+    , m_read_length(0)
+    , m_read_offset(0)
+    , m_read_handler()
+    , m_dispatching(false)
+    , m_read_completed(false)
+    , m_read_error()
+    , m_buffer_id(-1)
+    , m_buffered_data(nullptr)
+    , m_buffered_length(0)
+    , m_queued()
+    , m_sending()
+    , m_sending_offset(0)
+    , m_iovecs()
+    , m_messages()
+    , m_flush_scheduled(false)
+    , m_error()
+    , m_closed(false)
+    , m_shutdown(false)
+{
+    for (size_t i = 0; i < MAX_LINKED_SENDS; ++i) {
+        m_sends[i].bind(this, i);
+    }
+}
+
+uring_socket::~uring_socket()
+{
+    release_buffer();
+    ::close(m_socket);
+}
+
+void uring_socket::async_read(void* data, size_t length, const read_handler& handler)
+{
+    m_read_data = static_cast<char*>(data);
+    m_read_length = length;
+    m_read_offset = 0;
+    m_read_handler = handler;
+
+    if (m_dispatching) {
+        continue_read();
+        return;
+    }
+
+    // Handlers are never invoked from within the initiating call so a read
+    // that can be satisfied right away is completed on the next turn.
+    m_dispatching = true;
+    continue_read();
+    m_dispatching = false;
+
+    if (m_read_completed) {
+        std::weak_ptr<uring_socket> weak_self = shared_from_this();
+        m_service->get_io_service().post([weak_self]() {
+            auto shared_self = weak_self.lock();
+            if (shared_self) {
+                shared_self->dispatch_read();
+            }
+        });
+    }
+}
+
+void uring_socket::write(const void* data, size_t length, boost::system::error_code& error_code)
+{
+    if (m_error) {
+        error_code = m_error;
+        return;
+    }
+    if (m_closed) {
+        error_code = boost::asio::error::shut_down;
+        return;
+    }
+
+    const char* buffer = static_cast<const char*>(data);
+    m_queued.insert(m_queued.end(), buffer, buffer + length);
+    if (!m_flush_scheduled) {
+        m_flush_scheduled = true;
+        m_service->schedule_flush(shared_from_this());
+    }
+
+    error_code = boost::system::error_code();
+}
+
+void uring_socket::flush()
+{
+    m_flush_scheduled = false;
+    if (m_sends_in_flight != 0 || m_queued.empty() || m_shutdown) {
+        return;
+    }
+
+    m_sending.swap(m_queued);
+    m_sending_offset = 0;
+    submit_send();
+}
+
+void uring_socket::close()
+{
+    m_closed = true;
+    m_read_handler = nullptr;
+    release_buffer();
+
+    // Anything that has already been written is still sent before the
+    // socket is shut down, just as it would be for a blocking socket.
+    if (m_sends_in_flight == 0 && m_queued.empty()) {
+        shutdown();
+    }
+}
+
+void uring_socket::continue_read()
+{
+    if (m_buffered_length != 0) {
+        const size_t count = std::min(m_buffered_length, m_read_length - m_read_offset);
+        std::memcpy(m_read_data + m_read_offset, m_buffered_data, count);
+        m_read_offset += count;
+        m_buffered_data += count;
+        m_buffered_length -= count;
+        if (m_buffered_length == 0) {
+            release_buffer();
+        }
+    }
+
+    if (m_read_offset == m_read_length) {
+        complete_read(boost::system::error_code());
+    } else if (m_error) {
+        complete_read(m_error);
+    } else if (!m_receive_keep_alive) {
+        submit_receive();
+    }
+}
+
+void uring_socket::dispatch_read()
+{
+    // Completing a read usually starts the next one which may well complete
+    // right away from the buffered data. Looping here rather than recursing
+    // keeps the stack flat no matter how many messages have been buffered.
+    auto shared_self = shared_from_this();
+    m_dispatching = true;
+    while (m_read_completed && m_read_handler) {
+        m_read_completed = false;
+        read_handler handler;
+        handler.swap(m_read_handler);
+        handler(m_read_error, m_read_offset);
+    }
+    m_read_completed = false;
+    m_dispatching = false;
+}
+
+void uring_socket::complete_read(const boost::system::error_code& error_code)
+{
+    m_read_error = error_code;
+    m_read_completed = true;
+    if (!m_dispatching) {
+        dispatch_read();
+    }
+}
+
+void uring_socket::release_buffer()
+{
+    if (m_buffer_id != -1) {
+        m_service->provide_buffer(static_cast<std::uint16_t>(m_buffer_id));
+        m_buffer_id = -1;
+        m_buffered_data = nullptr;
+        m_buffered_length = 0;
+    }
+}
+
+void uring_socket::submit_receive()
+{
+    if (m_closed) {
+        return;
+    }
+
+    io_uring_sqe* sqe = m_service->get_sqe(&m_receive);
+    if (!sqe) {
+        m_error = boost::asio::error::no_buffer_space;
+        shutdown();
+        complete_read(m_error);
+        return;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = m_socket;
+    sqe->len = static_cast<std::uint32_t>(m_service->get_buffer_size());
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = m_service->get_buffer_group();
+
+    m_receive_keep_alive = shared_from_this();
+}
+
+void uring_socket::submit_send()
+{
+    const size_t max_chunk = MAX_SEND_CHUNK;
+    size_t offset = m_sending_offset;
+    size_t count = 0;
+    while (offset < m_sending.size() && count < MAX_LINKED_SENDS) {
+        const size_t length = std::min(max_chunk, m_sending.size() - offset);
+        m_iovecs[count].iov_base = m_sending.data() + offset;
+        m_iovecs[count].iov_len = length;
+
+        std::memset(&m_messages[count], 0, sizeof(msghdr));
+        m_messages[count].msg_iov = &m_iovecs[count];
+        m_messages[count].msg_iovlen = 1;
+
+        offset += length;
+        ++count;
+    }
+
+    // A send that cannot be submitted fails the connection just like a
+    // failed send would.
+    if (!m_service->reserve_sqes(static_cast<unsigned>(count))) {
+        m_error = boost::asio::error::no_buffer_space;
+        m_sending.clear();
+        m_queued.clear();
+        shutdown();
+        return;
+    }
+
+    // Without MSG_WAITALL a short send counts as a success so the linked
+    // sends after it would still go out and leave a gap in the stream.
+    for (size_t i = 0; i < count; ++i) {
+        io_uring_sqe* sqe = m_service->get_sqe(&m_sends[i]);
+        sqe->opcode = IORING_OP_SENDMSG;
+        sqe->fd = m_socket;
+        sqe->addr = reinterpret_cast<std::uint64_t>(&m_messages[i]);
+        sqe->len = 1;
+        sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+        if (i + 1 < count) {
+            sqe->flags = IOSQE_IO_LINK;
+        }
+        m_send_results[i] = 0;
+    }
+
+    m_send_count = count;
+    m_sends_in_flight = count;
+    m_send_keep_alive = shared_from_this();
+}
+
+void uring_socket::on_receive(int result, std::uint32_t flags)
+{
+    auto shared_self = std::move(m_receive_keep_alive);
+
+    if (flags & IORING_CQE_F_BUFFER) {
+        const std::uint16_t buffer_id = static_cast<std::uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT);
+        if (result > 0 && !m_closed) {
+            m_buffer_id = buffer_id;
+            m_buffered_data = m_service->get_buffer(buffer_id);
+            m_buffered_length = static_cast<size_t>(result);
+        } else {
+            m_service->provide_buffer(buffer_id);
+        }
+    }
+
+    if (m_closed) {
+        return;
+    }
+
+    if (result == -ENOBUFS) {
+        // Every provided buffer is currently in use. Other connections will
+        // return theirs as they consume them so simply try again later.
+        std::weak_ptr<uring_socket> weak_self = shared_self;
+        m_service->get_io_service().post([weak_self]() {
+            auto shared_self = weak_self.lock();
+            if (shared_self && shared_self->m_read_handler && !shared_self->m_receive_keep_alive) {
+                shared_self->submit_receive();
+            }
+        });
+        return;
+    }
+
+    if (result == 0) {
+        m_error = boost::asio::error::eof;
+    } else if (result < 0) {
+        m_error = boost::system::error_code(-result, boost::system::system_category());
+    }
+
+    if (m_read_handler) {
+        continue_read();
+    }
+}
+
+void uring_socket::on_send(std::size_t chunk, int result)
+{
+    --m_sends_in_flight;
+    m_send_results[chunk] = result;
+    if (m_sends_in_flight != 0) {
+        return;
+    }
+
+    // The chunks are walked in order so that the next send starts at the
+    // first byte that has not been sent. A short or failed chunk breaks the
+    // chain which cancels every chunk after it. Should a later chunk have
+    // been sent anyway the stream has a gap and the connection is failed.
+    bool complete = true;
+    for (size_t i = 0; i < m_send_count; ++i) {
+        const int chunk_result = m_send_results[i];
+        if (!complete) {
+            if (chunk_result > 0 && !m_error) {
+                m_error = boost::asio::error::broken_pipe;
+            }
+            continue;
+        }
+
+        if (chunk_result > 0) {
+            m_sending_offset += static_cast<size_t>(chunk_result);
+        } else if (chunk_result != -ECANCELED && !m_error) {
+            m_error = boost::system::error_code(-chunk_result, boost::system::system_category());
+        }
+        complete = chunk_result == static_cast<int>(m_iovecs[i].iov_len);
+    }
+
+    auto shared_self = std::move(m_send_keep_alive);
+    if (m_error) {
+        // Shutting the socket down fails the pending receive which is how
+        // the error makes its way to the connection.
+        m_sending.clear();
+        m_queued.clear();
+        shutdown();
+        return;
+    }
+
+    if (m_sending_offset < m_sending.size()) {
+        submit_send();
+        return;
+    }
+
+    m_sending.clear();
+    if (!m_queued.empty()) {
+        flush();
+    } else if (m_closed) {
+        shutdown();
+    }
+}
+
+void uring_socket::shutdown()
+{
+    if (!m_shutdown) {
+        m_shutdown = true;
+        ::shutdown(m_socket, SHUT_RDWR);
+    }
+}
+
+} // namespace bonefish
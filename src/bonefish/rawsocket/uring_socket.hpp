@@ -0,0 +1,159 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_URING_SOCKET_HPP
+#define BONEFISH_URING_SOCKET_HPP
+
+#include <bonefish/rawsocket/uring_service.hpp>
+
+#include <boost/system/error_code.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <vector>
+
+namespace bonefish {
+
+/// A connected stream socket serviced by io_uring.
+///
+/// Receives select one of the service's provided buffers so that no memory
+/// is tied up by connections that are idle. Writes are queued and flushed
+/// once per io_service turn as a chain of linked vectored sends which keeps
+/// the kernel from reordering them. Sends go through sendmsg rather than
+/// writev so that MSG_NOSIGNAL and MSG_WAITALL can be set. The latter makes
+/// a short send fail and break the chain so that the sends after it never
+/// leave a gap in the stream.
+///
+/// The socket keeps itself alive for as long as any of its operations are
+/// in flight, so it is safe to drop the last reference at any time.
+class uring_socket :
+        public std::enable_shared_from_this<uring_socket>
+{
+public:
+    using read_handler = std::function<void(const boost::system::error_code&, size_t)>;
+
+public:
+    uring_socket(const std::shared_ptr<uring_service>& service, int socket);
+    ~uring_socket();
+
+    uring_socket(const uring_socket&) = delete;
+    uring_socket& operator=(const uring_socket&) = delete;
+
+    void async_read(void* data, size_t length, const read_handler& handler);
+    void write(const void* data, size_t length, boost::system::error_code& error_code);
+
+    /// Sends any queued writes.
+    void flush();
+
+    /// Shuts the socket down once all queued writes have been sent.
+    void close();
+
+private:
+    class receive_operation : public uring_operation
+    {
+    public:
+        explicit receive_operation(uring_socket& socket) : m_socket(socket) {}
+        virtual void complete(int result, std::uint32_t flags) override
+        {
+            m_socket.on_receive(result, flags);
+        }
+
+    private:
+        uring_socket& m_socket;
+    };
+
+    class send_operation : public uring_operation
+    {
+    public:
+        send_operation() : m_socket(nullptr), m_chunk(0) {}
+        void bind(uring_socket* socket, std::size_t chunk)
+        {
+            m_socket = socket;
+            m_chunk = chunk;
+        }
+        virtual void complete(int result, std::uint32_t flags) override
+        {
+            m_socket->on_send(m_chunk, result);
+        }
+
+    private:
+        uring_socket* m_socket;
+        std::size_t m_chunk;
+    };
+
+    void continue_read();
+    void dispatch_read();
+    void complete_read(const boost::system::error_code& error_code);
+    void release_buffer();
+    void submit_receive();
+    void submit_send();
+    void on_receive(int result, std::uint32_t flags);
+    void on_send(std::size_t chunk, int result);
+    void shutdown();
+
+private:
+    /// Queued writes are split into chunks of at most this size which are
+    /// submitted together as a chain of linked send operations.
+    static const std::size_t MAX_SEND_CHUNK = 64 * 1024;
+    static const std::size_t MAX_LINKED_SENDS = 16;
+
+    std::shared_ptr<uring_service> m_service;
+    int m_socket;
+
+    receive_operation m_receive;
+    std::shared_ptr<uring_socket> m_receive_keep_alive;
+
+    /// One operation per chunk of the chain so that each chunk's result is
+    /// known on its own.
+    send_operation m_sends[MAX_LINKED_SENDS];
+    int m_send_results[MAX_LINKED_SENDS];
+    std::size_t m_send_count;
+    std::shared_ptr<uring_socket> m_send_keep_alive;
+    std::size_t m_sends_in_flight;
+
+    /// The read that is currently pending.
+    char* m_read_data;
+    size_t m_read_length;
+    size_t m_read_offset;
+    read_handler m_read_handler;
+    bool m_dispatching;
+    bool m_read_completed;
+    boost::system::error_code m_read_error;
+
+    /// The provided buffer that was selected by the last receive and the
+    /// part of it that has not been consumed yet.
+    int m_buffer_id;
+    const char* m_buffered_data;
+    size_t m_buffered_length;
+
+    std::vector<char> m_queued;
+    std::vector<char> m_sending;
+    size_t m_sending_offset;
+    iovec m_iovecs[MAX_LINKED_SENDS];
+    msghdr m_messages[MAX_LINKED_SENDS];
+    bool m_flush_scheduled;
+
+    boost::system::error_code m_error;
+    bool m_closed;
+    bool m_shutdown;
+};
+
+} // namespace bonefish
+
+#endif // BONEFISH_URING_SOCKET_HPP
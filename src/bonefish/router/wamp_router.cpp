@@ -17,8 +17,10 @@
 #include <bonefish/router/wamp_router.hpp>
 #include <bonefish/broker/wamp_broker.hpp>
 #include <bonefish/dealer/wamp_dealer.hpp>
+#include <bonefish/identifiers/wamp_registration_id.hpp>
 #include <bonefish/identifiers/wamp_session_id.hpp>
 #include <bonefish/identifiers/wamp_session_id_generator.hpp>
+#include <bonefish/identifiers/wamp_subscription_id.hpp>
 #include <bonefish/messages/wamp_abort_message.hpp>
 #include <bonefish/messages/wamp_error_message.hpp>
 #include <bonefish/messages/wamp_goodbye_message.hpp>
@@ -30,6 +32,7 @@
 #include <bonefish/roles/wamp_role.hpp>
 #include <bonefish/router/wamp_router_impl.hpp>
 #include <bonefish/session/wamp_session.hpp>
+#include <bonefish/session/wamp_session_slot.hpp>
 
 #include <iostream>
 #include <stdexcept>
@@ -73,69 +76,118 @@ void wamp_router::close_session(const wamp_session_id& session_id, const std::st
     m_impl->close_session(session_id, reason);
 }
 
-bool wamp_router::detach_session(const wamp_session_id& session_id)
+bool wamp_router::detach_session(const wamp_session_slot& slot)
 {
-    return m_impl->detach_session(session_id);
+    return m_impl->detach_session(slot);
 }
 
-void wamp_router::process_hello_message(const wamp_session_id& session_id,
+void wamp_router::process_hello_message(const wamp_session_slot& slot,
         const wamp_hello_message* hello_message)
 {
-    m_impl->process_hello_message(session_id, hello_message);
+    m_impl->process_hello_message(slot, hello_message);
 }
 
-void wamp_router::process_goodbye_message(const wamp_session_id& session_id,
+void wamp_router::process_goodbye_message(const wamp_session_slot& slot,
         const wamp_goodbye_message* goodbye_message)
 {
-    m_impl->process_goodbye_message(session_id, goodbye_message);
+    m_impl->process_goodbye_message(slot, goodbye_message);
 }
 
-void wamp_router::process_call_message(const wamp_session_id& session_id,
+void wamp_router::process_call_message(const wamp_session_slot& slot,
         const wamp_call_message* call_message)
 {
-    m_impl->process_call_message(session_id, call_message);
+    m_impl->process_call_message(slot, call_message);
 }
 
-void wamp_router::process_error_message(const wamp_session_id& session_id,
+void wamp_router::process_cancel_message(const wamp_session_slot& slot,
+        const wamp_cancel_message* cancel_message)
+{
+    m_impl->process_cancel_message(slot, cancel_message);
+}
+
+void wamp_router::process_error_message(const wamp_session_slot& slot,
         const wamp_error_message* error_message)
 {
-    m_impl->process_error_message(session_id, error_message);
+    m_impl->process_error_message(slot, error_message);
 }
 
-void wamp_router::process_publish_message(const wamp_session_id& session_id,
+void wamp_router::process_publish_message(const wamp_session_slot& slot,
         const wamp_publish_message* publish_message)
 {
-    m_impl->process_publish_message(session_id, publish_message);
+    m_impl->process_publish_message(slot, publish_message);
 }
 
-void wamp_router::process_register_message(const wamp_session_id& session_id,
+void wamp_router::process_register_message(const wamp_session_slot& slot,
         const wamp_register_message* register_message)
 {
-    m_impl->process_register_message(session_id, register_message);
+    m_impl->process_register_message(slot, register_message);
 }
 
-void wamp_router::process_subscribe_message(const wamp_session_id& session_id,
+void wamp_router::process_subscribe_message(const wamp_session_slot& slot,
         const wamp_subscribe_message* subscribe_message)
 {
-    m_impl->process_subscribe_message(session_id, subscribe_message);
+    m_impl->process_subscribe_message(slot, subscribe_message);
 }
 
-void wamp_router::process_unregister_message(const wamp_session_id& session_id,
+void wamp_router::process_unregister_message(const wamp_session_slot& slot,
         const wamp_unregister_message* unregister_message)
 {
-    m_impl->process_unregister_message(session_id, unregister_message);
+    m_impl->process_unregister_message(slot, unregister_message);
 }
 
-void wamp_router::process_unsubscribe_message(const wamp_session_id& session_id,
+void wamp_router::process_unsubscribe_message(const wamp_session_slot& slot,
         const wamp_unsubscribe_message* unsubscribe_message)
 {
-    m_impl->process_unsubscribe_message(session_id, unsubscribe_message);
+    m_impl->process_unsubscribe_message(slot, unsubscribe_message);
 }
 
-void wamp_router::process_yield_message(const wamp_session_id& session_id,
+void wamp_router::process_yield_message(const wamp_session_slot& slot,
         const wamp_yield_message* yield_message)
 {
-    m_impl->process_yield_message(session_id, yield_message);
+    m_impl->process_yield_message(slot, yield_message);
+}
+
+wamp_registration_id wamp_router::register_procedure(const std::string& procedure,
+        const wamp_procedure& handler)
+{
+    return m_impl->register_procedure(procedure, handler);
+}
+
+wamp_registration_id wamp_router::register_async_procedure(const std::string& procedure,
+        const wamp_async_procedure& handler)
+{
+    return m_impl->register_async_procedure(procedure, handler);
+}
+
+bool wamp_router::unregister_procedure(const wamp_registration_id& registration_id)
+{
+    return m_impl->unregister_procedure(registration_id);
+}
+
+wamp_subscription_id wamp_router::subscribe_event_handler(const std::string& topic,
+        const wamp_event_handler& handler)
+{
+    return m_impl->subscribe_event_handler(topic, handler);
+}
+
+bool wamp_router::unsubscribe_event_handler(const wamp_subscription_id& subscription_id)
+{
+    return m_impl->unsubscribe_event_handler(subscription_id);
+}
+
+const wamp_dealer_cache_stats& wamp_router::get_cache_stats() const
+{
+    return m_impl->get_cache_stats();
+}
+
+size_t wamp_router::get_call_queue_depth() const
+{
+    return m_impl->get_call_queue_depth();
+}
+
+void wamp_router::set_registration_grace_period(unsigned grace_period_ms)
+{
+    m_impl->set_registration_grace_period(grace_period_ms);
 }
 
 } // namespace bonefish
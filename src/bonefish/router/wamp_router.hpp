@@ -17,7 +17,12 @@
 #ifndef BONEFISH_WAMP_ROUTER_HPP
 #define BONEFISH_WAMP_ROUTER_HPP
 
+#include <bonefish/broker/wamp_event.hpp>
+#include <bonefish/dealer/wamp_dealer_cache_stats.hpp>
+#include <bonefish/dealer/wamp_procedure.hpp>
+
 #include <boost/asio/io_service.hpp>
+#include <cstddef>
 #include <memory>
 #include <string>
 
@@ -26,16 +31,20 @@ namespace bonefish {
 class wamp_broker;
 class wamp_dealer;
 class wamp_call_message;
+class wamp_cancel_message;
 class wamp_error_message;
 class wamp_goodbye_message;
 class wamp_hello_message;
 class wamp_publish_message;
 class wamp_register_message;
+class wamp_registration_id;
 class wamp_router_impl;
 class wamp_session;
 class wamp_session_id;
 class wamp_session_id_generator;
+class wamp_session_slot;
 class wamp_subscribe_message;
+class wamp_subscription_id;
 class wamp_unregister_message;
 class wamp_unsubscribe_message;
 class wamp_welcome_details;
@@ -53,29 +62,60 @@ public:
     bool has_session(const wamp_session_id& session_id);
     bool attach_session(const std::shared_ptr<wamp_session>& session);
     void close_session(const wamp_session_id& session_id, const std::string& reason);
-    bool detach_session(const wamp_session_id& session_id);
+    bool detach_session(const wamp_session_slot& slot);
 
-    void process_call_message(const wamp_session_id& session_id,
+    void process_call_message(const wamp_session_slot& slot,
             const wamp_call_message* call_message);
-    void process_error_message(const wamp_session_id& session_id,
+    void process_cancel_message(const wamp_session_slot& slot,
+            const wamp_cancel_message* cancel_message);
+    void process_error_message(const wamp_session_slot& slot,
             const wamp_error_message* error_message);
-    void process_hello_message(const wamp_session_id& session_id,
+    void process_hello_message(const wamp_session_slot& slot,
             const wamp_hello_message* hello_message);
-    void process_goodbye_message(const wamp_session_id& session_id,
+    void process_goodbye_message(const wamp_session_slot& slot,
             const wamp_goodbye_message* goodbye_message);
-    void process_publish_message(const wamp_session_id& session_id,
+    void process_publish_message(const wamp_session_slot& slot,
             const wamp_publish_message* publish_message);
-    void process_register_message(const wamp_session_id& session_id,
+    void process_register_message(const wamp_session_slot& slot,
             const wamp_register_message* register_message);
-    void process_subscribe_message(const wamp_session_id& session_id,
+    void process_subscribe_message(const wamp_session_slot& slot,
             const wamp_subscribe_message* subscribe_message);
-    void process_unregister_message(const wamp_session_id& session_id,
+    void process_unregister_message(const wamp_session_slot& slot,
             const wamp_unregister_message* unregister_message);
-    void process_unsubscribe_message(const wamp_session_id& session_id,
+    void process_unsubscribe_message(const wamp_session_slot& slot,
             const wamp_unsubscribe_message* unsubscribe_message);
-    void process_yield_message(const wamp_session_id& session_id,
+    void process_yield_message(const wamp_session_slot& slot,
             const wamp_yield_message* yield_message);
 
+    /// Registers a procedure that runs inside of the router.
+    wamp_registration_id register_procedure(const std::string& procedure,
+            const wamp_procedure& handler);
+
+    /// Registers a procedure that runs inside of the router and completes
+    /// calls asynchronously on the router's io service.
+    wamp_registration_id register_async_procedure(const std::string& procedure,
+            const wamp_async_procedure& handler);
+
+    bool unregister_procedure(const wamp_registration_id& registration_id);
+
+    /// Subscribes a handler inside of the router that is invoked for every
+    /// publication to the topic while the publication is processed.
+    wamp_subscription_id subscribe_event_handler(const std::string& topic,
+            const wamp_event_handler& handler);
+
+    bool unsubscribe_event_handler(const wamp_subscription_id& subscription_id);
+
+    /// The hits, misses and evictions of the caches of cacheable procedures.
+    const wamp_dealer_cache_stats& get_cache_stats() const;
+
+    /// The number of calls waiting for a free slot of a registration with
+    /// limited concurrency.
+    size_t get_call_queue_depth() const;
+
+    /// How long calls to procedures that are not registered yet wait for
+    /// the procedure to be registered.
+    void set_registration_grace_period(unsigned grace_period_ms);
+
 private:
     std::unique_ptr<wamp_router_impl> m_impl;
 };
@@ -43,11 +43,13 @@ namespace bonefish {
 
 wamp_router_impl::wamp_router_impl(boost::asio::io_service& io_service, const std::string& realm)
     : m_realm(realm)
-    , m_broker(realm)
-    , m_dealer(io_service)
+    , m_uri_table()
+    , m_broker(realm, m_uri_table)
+    , m_dealer(io_service, m_uri_table)
     , m_welcome_details()
     , m_session_id_generator(wamp_session_id_factory::create(realm))
     , m_sessions()
+    , m_session_slots()
 {
     // Setup the broker role and supported features
     wamp_role broker_role(wamp_role_type::BROKER);
@@ -57,6 +59,10 @@ wamp_router_impl::wamp_router_impl(boost::asio::io_service& io_service, const st
     // Setup the dealer role and supported features
     wamp_role_features dealer_features;
     dealer_features.set_attribute("call_timeout", true);
+    dealer_features.set_attribute("call_canceling", true);
+    dealer_features.set_attribute("pattern_based_registration", true);
+    dealer_features.set_attribute("progressive_call_results", true);
+    dealer_features.set_attribute("shared_registration", true);
 
     wamp_role dealer_role(wamp_role_type::DEALER);
     dealer_role.set_features(std::move(dealer_features));
@@ -80,18 +86,18 @@ const std::shared_ptr<wamp_session_id_generator>& wamp_router_impl::get_session_
 
 bool wamp_router_impl::has_session(const wamp_session_id& session_id)
 {
-    return m_sessions.find(session_id) != m_sessions.end();
+    return m_session_slots.find(session_id) != m_session_slots.end();
 }
 
 void wamp_router_impl::close_session(const wamp_session_id& session_id, const std::string& reason)
 {
-    auto session_itr = m_sessions.find(session_id);
-    if (session_itr == m_sessions.end()) {
+    auto session_slots_itr = m_session_slots.find(session_id);
+    if (session_slots_itr == m_session_slots.end()) {
         throw std::logic_error("session does not exist");
     }
 
-    BONEFISH_TRACE("closing session: %1%", *session_itr->second);
-    auto& session = session_itr->second;
+    const auto& session = get_session(session_slots_itr->second);
+    BONEFISH_TRACE("closing session: %1%", *session);
     if (session->get_state() == wamp_session_state::OPEN) {
         std::unique_ptr<wamp_goodbye_message> goodbye_message(new wamp_goodbye_message);
         goodbye_message->set_reason(reason);
@@ -105,17 +111,20 @@ void wamp_router_impl::close_session(const wamp_session_id& session_id, const st
 bool wamp_router_impl::attach_session(const std::shared_ptr<wamp_session>& session)
 {
     BONEFISH_TRACE("attaching session: %1%", *session);
-    auto result = m_sessions.insert(
-            std::make_pair(session->get_session_id(), session));
+    auto result = m_session_slots.insert(
+            std::make_pair(session->get_session_id(), wamp_session_slot()));
 
     if (result.second) {
-        if (session->get_role(wamp_role_type::CALLER) ||
-                session->get_role(wamp_role_type::CALLEE)) {
+        result.first->second = m_sessions.insert(session);
+        session->set_slot(result.first->second);
+
+        if (session->has_role(wamp_role_type::CALLER) ||
+                session->has_role(wamp_role_type::CALLEE)) {
             m_dealer.attach_session(session);
         }
 
-        if (session->get_role(wamp_role_type::SUBSCRIBER) ||
-                session->get_role(wamp_role_type::PUBLISHER)) {
+        if (session->has_role(wamp_role_type::SUBSCRIBER) ||
+                session->has_role(wamp_role_type::PUBLISHER)) {
             m_broker.attach_session(session);
         }
 
@@ -127,39 +136,36 @@ bool wamp_router_impl::attach_session(const std::shared_ptr<wamp_session>& sessi
     return false;
 }
 
-bool wamp_router_impl::detach_session(const wamp_session_id& session_id)
+bool wamp_router_impl::detach_session(const wamp_session_slot& slot)
 {
-    auto session_itr = m_sessions.find(session_id);
-    if (session_itr == m_sessions.end()) {
+    // Take a copy of the session so that it outlives its removal from the
+    // session table below.
+    std::shared_ptr<wamp_session> session = m_sessions.get(slot);
+    if (!session) {
         return false;
     }
 
-    const auto& session = session_itr->second;
-
-    if (session->get_role(wamp_role_type::CALLER) ||
-            session->get_role(wamp_role_type::CALLEE)) {
-        m_dealer.detach_session(session_id);
+    if (session->has_role(wamp_role_type::CALLER) ||
+            session->has_role(wamp_role_type::CALLEE)) {
+        m_dealer.detach_session(session);
     }
 
-    if (session->get_role(wamp_role_type::SUBSCRIBER) ||
-            session->get_role(wamp_role_type::PUBLISHER)) {
-        m_broker.detach_session(session_id);
+    if (session->has_role(wamp_role_type::SUBSCRIBER) ||
+            session->has_role(wamp_role_type::PUBLISHER)) {
+        m_broker.detach_session(session);
     }
 
-    m_sessions.erase(session_itr);
+    m_session_slots.erase(session->get_session_id());
+    m_sessions.erase(slot);
+    session->set_slot(wamp_session_slot());
 
     return true;
 }
 
-void wamp_router_impl::process_hello_message(const wamp_session_id& session_id,
+void wamp_router_impl::process_hello_message(const wamp_session_slot& slot,
         const wamp_hello_message* hello_message)
 {
-    auto session_itr = m_sessions.find(session_id);
-    if (session_itr == m_sessions.end()) {
-        throw std::logic_error("session does not exist");
-    }
-
-    auto& session = session_itr->second;
+    const auto& session = get_session(slot);
     BONEFISH_TRACE("%1%, %2%", *session % *hello_message);
     if (session->get_state() != wamp_session_state::NONE) {
         std::unique_ptr<wamp_abort_message> abort_message(new wamp_abort_message);
@@ -181,7 +187,7 @@ void wamp_router_impl::process_hello_message(const wamp_session_id& session_id,
     session->set_state(wamp_session_state::OPEN);
 
     std::unique_ptr<wamp_welcome_message> welcome_message(new wamp_welcome_message);
-    welcome_message->set_session_id(session_id);
+    welcome_message->set_session_id(session->get_session_id());
     welcome_message->set_details(m_welcome_details.marshal(welcome_message->get_zone()));
 
     // If we fail to send the welcome message it is most likely that the
@@ -194,15 +200,10 @@ void wamp_router_impl::process_hello_message(const wamp_session_id& session_id,
     }
 }
 
-void wamp_router_impl::process_goodbye_message(const wamp_session_id& session_id,
+void wamp_router_impl::process_goodbye_message(const wamp_session_slot& slot,
         const wamp_goodbye_message* goodbye_message)
 {
-    auto session_itr = m_sessions.find(session_id);
-    if (session_itr == m_sessions.end()) {
-        throw std::logic_error("session does not exist");
-    }
-
-    auto& session = session_itr->second;
+    const auto& session = get_session(slot);
     if (session->get_state() == wamp_session_state::OPEN) {
         std::unique_ptr<wamp_goodbye_message> message(new wamp_goodbye_message);
         message->set_reason("wamp.error.goodbye_and_out");
@@ -219,57 +220,117 @@ void wamp_router_impl::process_goodbye_message(const wamp_session_id& session_id
     }
 }
 
-void wamp_router_impl::process_call_message(const wamp_session_id& session_id,
+void wamp_router_impl::process_call_message(const wamp_session_slot& slot,
         const wamp_call_message* call_message)
 {
-    m_dealer.process_call_message(session_id, call_message);
+    m_dealer.process_call_message(get_session(slot), call_message);
+}
+
+void wamp_router_impl::process_cancel_message(const wamp_session_slot& slot,
+        const wamp_cancel_message* cancel_message)
+{
+    m_dealer.process_cancel_message(get_session(slot), cancel_message);
 }
 
-void wamp_router_impl::process_error_message(const wamp_session_id& session_id,
+void wamp_router_impl::process_error_message(const wamp_session_slot& slot,
         const wamp_error_message* error_message)
 {
     const auto request_type = error_message->get_request_type();
     if (request_type == wamp_message_type::INVOCATION) {
-        m_dealer.process_error_message(session_id, error_message);
+        m_dealer.process_error_message(get_session(slot), error_message);
     } else {
         throw std::logic_error("received an unexpected error message");
     }
 }
 
-void wamp_router_impl::process_publish_message(const wamp_session_id& session_id,
+void wamp_router_impl::process_publish_message(const wamp_session_slot& slot,
         const wamp_publish_message* publish_message)
 {
-    m_broker.process_publish_message(session_id, publish_message);
+    m_broker.process_publish_message(get_session(slot), publish_message);
 }
 
-void wamp_router_impl::process_register_message(const wamp_session_id& session_id,
+void wamp_router_impl::process_register_message(const wamp_session_slot& slot,
         const wamp_register_message* register_message)
 {
-    m_dealer.process_register_message(session_id, register_message);
+    m_dealer.process_register_message(get_session(slot), register_message);
 }
 
-void wamp_router_impl::process_subscribe_message(const wamp_session_id& session_id,
+void wamp_router_impl::process_subscribe_message(const wamp_session_slot& slot,
         const wamp_subscribe_message* subscribe_message)
 {
-    m_broker.process_subscribe_message(session_id, subscribe_message);
+    m_broker.process_subscribe_message(get_session(slot), subscribe_message);
 }
 
-void wamp_router_impl::process_unregister_message(const wamp_session_id& session_id,
+void wamp_router_impl::process_unregister_message(const wamp_session_slot& slot,
         const wamp_unregister_message* unregister_message)
 {
-    m_dealer.process_unregister_message(session_id, unregister_message);
+    m_dealer.process_unregister_message(get_session(slot), unregister_message);
 }
 
-void wamp_router_impl::process_unsubscribe_message(const wamp_session_id& session_id,
+void wamp_router_impl::process_unsubscribe_message(const wamp_session_slot& slot,
         const wamp_unsubscribe_message* unsubscribe_message)
 {
-    m_broker.process_unsubscribe_message(session_id, unsubscribe_message);
+    m_broker.process_unsubscribe_message(get_session(slot), unsubscribe_message);
 }
 
-void wamp_router_impl::process_yield_message(const wamp_session_id& session_id,
+void wamp_router_impl::process_yield_message(const wamp_session_slot& slot,
         const wamp_yield_message* yield_message)
 {
-    m_dealer.process_yield_message(session_id, yield_message);
+    m_dealer.process_yield_message(get_session(slot), yield_message);
+}
+
+wamp_registration_id wamp_router_impl::register_procedure(const std::string& procedure,
+        const wamp_procedure& handler)
+{
+    return m_dealer.register_procedure(procedure, handler);
+}
+
+wamp_registration_id wamp_router_impl::register_async_procedure(const std::string& procedure,
+        const wamp_async_procedure& handler)
+{
+    return m_dealer.register_async_procedure(procedure, handler);
+}
+
+bool wamp_router_impl::unregister_procedure(const wamp_registration_id& registration_id)
+{
+    return m_dealer.unregister_procedure(registration_id);
+}
+
+const std::shared_ptr<wamp_session>& wamp_router_impl::get_session(
+        const wamp_session_slot& slot) const
+{
+    const auto& session = m_sessions.get(slot);
+    if (!session) {
+        throw std::logic_error("session does not exist");
+    }
+
+    return session;
+}
+
+wamp_subscription_id wamp_router_impl::subscribe_event_handler(const std::string& topic,
+        const wamp_event_handler& handler)
+{
+    return m_broker.subscribe_event_handler(topic, handler);
+}
+
+bool wamp_router_impl::unsubscribe_event_handler(const wamp_subscription_id& subscription_id)
+{
+    return m_broker.unsubscribe_event_handler(subscription_id);
+}
+
+const wamp_dealer_cache_stats& wamp_router_impl::get_cache_stats() const
+{
+    return m_dealer.get_cache_stats();
+}
+
+size_t wamp_router_impl::get_call_queue_depth() const
+{
+    return m_dealer.get_call_queue_depth();
+}
+
+void wamp_router_impl::set_registration_grace_period(unsigned grace_period_ms)
+{
+    m_dealer.set_registration_grace_period(grace_period_ms);
 }
 
 } // namespace bonefish
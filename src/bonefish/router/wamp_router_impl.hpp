@@ -20,6 +20,9 @@
 #include <bonefish/broker/wamp_broker.hpp>
 #include <bonefish/dealer/wamp_dealer.hpp>
 #include <bonefish/messages/wamp_welcome_details.hpp>
+#include <bonefish/session/wamp_session_slot.hpp>
+#include <bonefish/session/wamp_session_table.hpp>
+#include <bonefish/utility/wamp_uri_table.hpp>
 
 #include <boost/asio.hpp>
 #include <memory>
@@ -28,15 +31,18 @@
 namespace bonefish {
 
 class wamp_call_message;
+class wamp_cancel_message;
 class wamp_error_message;
 class wamp_goodbye_message;
 class wamp_hello_message;
 class wamp_publish_message;
 class wamp_register_message;
+class wamp_registration_id;
 class wamp_session;
 class wamp_session_id;
 class wamp_session_id_generator;
 class wamp_subscribe_message;
+class wamp_subscription_id;
 class wamp_unregister_message;
 class wamp_unsubscribe_message;
 class wamp_yield_message;
@@ -53,36 +59,75 @@ public:
     bool has_session(const wamp_session_id& session_id);
     void close_session(const wamp_session_id& session_id, const std::string& reason);
     bool attach_session(const std::shared_ptr<wamp_session>& session);
-    bool detach_session(const wamp_session_id& session_id);
+    bool detach_session(const wamp_session_slot& slot);
 
-    void process_call_message(const wamp_session_id& session_id,
+    void process_call_message(const wamp_session_slot& slot,
             const wamp_call_message* call_message);
-    void process_error_message(const wamp_session_id& session_id,
+    void process_cancel_message(const wamp_session_slot& slot,
+            const wamp_cancel_message* cancel_message);
+    void process_error_message(const wamp_session_slot& slot,
             const wamp_error_message* error_message);
-    void process_hello_message(const wamp_session_id& session_id,
+    void process_hello_message(const wamp_session_slot& slot,
             const wamp_hello_message* hello_message);
-    void process_goodbye_message(const wamp_session_id& session_id,
+    void process_goodbye_message(const wamp_session_slot& slot,
             const wamp_goodbye_message* goodbye_message);
-    void process_publish_message(const wamp_session_id& session_id,
+    void process_publish_message(const wamp_session_slot& slot,
             const wamp_publish_message* publish_message);
-    void process_register_message(const wamp_session_id& session_id,
+    void process_register_message(const wamp_session_slot& slot,
             const wamp_register_message* register_message);
-    void process_subscribe_message(const wamp_session_id& session_id,
+    void process_subscribe_message(const wamp_session_slot& slot,
             const wamp_subscribe_message* subscribe_message);
-    void process_unregister_message(const wamp_session_id& session_id,
+    void process_unregister_message(const wamp_session_slot& slot,
             const wamp_unregister_message* unregister_message);
-    void process_unsubscribe_message(const wamp_session_id& session_id,
+    void process_unsubscribe_message(const wamp_session_slot& slot,
             const wamp_unsubscribe_message* unsubscribe_message);
-    void process_yield_message(const wamp_session_id& session_id,
+    void process_yield_message(const wamp_session_slot& slot,
             const wamp_yield_message* yield_message);
 
+    /// Registers a procedure that runs inside of the router.
+    wamp_registration_id register_procedure(const std::string& procedure,
+            const wamp_procedure& handler);
+
+    /// Registers a procedure that runs inside of the router and completes
+    /// calls asynchronously on the router's io service.
+    wamp_registration_id register_async_procedure(const std::string& procedure,
+            const wamp_async_procedure& handler);
+
+    bool unregister_procedure(const wamp_registration_id& registration_id);
+
+    /// Subscribes a handler inside of the router that is invoked for every
+    /// publication to the topic while the publication is processed.
+    wamp_subscription_id subscribe_event_handler(const std::string& topic,
+            const wamp_event_handler& handler);
+
+    bool unsubscribe_event_handler(const wamp_subscription_id& subscription_id);
+
+    /// The hits, misses and evictions of the caches of cacheable procedures.
+    const wamp_dealer_cache_stats& get_cache_stats() const;
+    size_t get_call_queue_depth() const;
+    void set_registration_grace_period(unsigned grace_period_ms);
+
+private:
+    const std::shared_ptr<wamp_session>& get_session(const wamp_session_slot& slot) const;
+
 private:
     std::string m_realm;
+
+    // The uri table must be declared before the broker and the dealer as
+    // they share the table and it must outlive both of them.
+    wamp_uri_table m_uri_table;
     wamp_broker m_broker;
     wamp_dealer m_dealer;
     wamp_welcome_details m_welcome_details;
     std::shared_ptr<wamp_session_id_generator> m_session_id_generator;
-    std::unordered_map<wamp_session_id, std::shared_ptr<wamp_session>> m_sessions;
+
+    /// The sessions attached to the router. Messages resolve their session
+    /// through the slot cached on the connection rather than by session id.
+    wamp_session_table m_sessions;
+
+    /// Maps session ids to their slots for the operations that are only
+    /// given a session id such as checking for session id collisions.
+    std::unordered_map<wamp_session_id, wamp_session_slot> m_session_slots;
 };
 
 } // namespace bonefish
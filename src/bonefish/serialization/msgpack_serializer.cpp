@@ -20,6 +20,7 @@
 
 #include <iostream>
 #include <msgpack.hpp>
+#include <new>
 #include <sstream>
 #include <stdexcept>
 
@@ -37,10 +38,24 @@ bool reference_func(type::object_type type, std::size_t length, void* user_data)
 
 namespace bonefish {
 
-wamp_message* msgpack_serializer::deserialize(const char* buffer, size_t length) const
+namespace {
+
+typedef std::shared_ptr<const void> buffer_owner;
+
+bool reference_buffer(msgpack::type::object_type type, std::size_t length, void* user_data)
 {
-    msgpack::unpacked item = msgpack::unpack(buffer, length, msgpack::reference_func);
+    // The buffer outlives the unpacked item so there is no need to copy any
+    // STR, BIN or EXT out of it.
+    return true;
+}
 
+void release_buffer_owner(void* owner)
+{
+    static_cast<buffer_owner*>(owner)->~buffer_owner();
+}
+
+wamp_message* unmarshal_message(msgpack::unpacked& item)
+{
     std::vector<msgpack::object> fields;
     item.get().convert(&fields);
 
@@ -59,6 +74,30 @@ wamp_message* msgpack_serializer::deserialize(const char* buffer, size_t length)
     return message.release();
 }
 
+} // namespace
+
+wamp_message* msgpack_serializer::deserialize(const char* buffer, size_t length) const
+{
+    msgpack::unpacked item = msgpack::unpack(buffer, length, msgpack::reference_func);
+    return unmarshal_message(item);
+}
+
+wamp_message* msgpack_serializer::deserialize_referenced(const char* buffer, size_t length,
+        const std::shared_ptr<const void>& owner) const
+{
+    msgpack::unpacked item = msgpack::unpack(buffer, length, reference_buffer);
+
+    // The owner is placed in the zone itself so that handing it over to the
+    // message does not require an allocation of its own. It is released
+    // along with the zone once the message no longer needs the buffer.
+    msgpack::zone& zone = *item.zone();
+    void* storage = zone.allocate_align(sizeof(buffer_owner));
+    new (storage) buffer_owner(owner);
+    zone.push_finalizer(&release_buffer_owner, storage);
+
+    return unmarshal_message(item);
+}
+
 expandable_buffer msgpack_serializer::serialize(const wamp_message& message) const
 {
     expandable_buffer buffer(10*1024);
@@ -21,6 +21,7 @@
 #include <bonefish/serialization/wamp_serializer_type.hpp>
 
 #include <cstddef>
+#include <memory>
 
 namespace bonefish {
 
@@ -34,6 +35,8 @@ public:
 
     virtual wamp_serializer_type get_type() const override;
     virtual wamp_message* deserialize(const char* buffer, size_t length) const override;
+    virtual wamp_message* deserialize_referenced(const char* buffer, size_t length,
+            const std::shared_ptr<const void>& owner) const override;
     virtual expandable_buffer serialize(const wamp_message& message) const override;
 };
 
@@ -21,6 +21,7 @@
 #include <bonefish/serialization/wamp_serializer_type.hpp>
 
 #include <cstddef>
+#include <memory>
 #include <msgpack.hpp>
 
 namespace bonefish
@@ -37,6 +38,13 @@ public:
     virtual wamp_serializer_type get_type() const = 0;
     virtual wamp_message* deserialize(const char* buffer, size_t length) const = 0;
     virtual expandable_buffer serialize(const wamp_message& message) const = 0;
+
+    /// Deserializes a message from a buffer that is kept alive by the given
+    /// owner. Serializers may reference the buffer from the message instead
+    /// of copying out of it, in which case the message holds on to the owner
+    /// for as long as it needs the buffer.
+    virtual wamp_message* deserialize_referenced(const char* buffer, size_t length,
+            const std::shared_ptr<const void>& owner) const;
 };
 
 inline wamp_serializer::wamp_serializer()
@@ -47,6 +55,12 @@ inline wamp_serializer::~wamp_serializer()
 {
 }
 
+inline wamp_message* wamp_serializer::deserialize_referenced(const char* buffer, size_t length,
+        const std::shared_ptr<const void>& owner) const
+{
+    return deserialize(buffer, length);
+}
+
 } // namespace bonefish
 
 #endif // BONEFISH_SERIALIZATION_WAMP_SERIALIZER_HPP
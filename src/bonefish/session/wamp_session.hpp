@@ -19,10 +19,12 @@
 
 #include <bonefish/identifiers/wamp_session_id.hpp>
 #include <bonefish/roles/wamp_role.hpp>
+#include <bonefish/session/wamp_session_slot.hpp>
 #include <bonefish/session/wamp_session_state.hpp>
 #include <bonefish/transport/wamp_transport.hpp>
 #include <bonefish/websocket/websocket_config.hpp>
 
+#include <cstdint>
 #include <memory>
 #include <ostream>
 #include <string>
@@ -43,37 +45,51 @@ public:
     wamp_session(
             const wamp_session_id& id,
             const std::string& realm,
-            std::unique_ptr<wamp_transport> transport);
+            const std::shared_ptr<wamp_transport>& transport);
     ~wamp_session();
     wamp_session(wamp_session const&) = delete;
     wamp_session& operator=(wamp_session const&) = delete;
 
     const std::string& get_realm() const;
     wamp_session_state get_state() const;
+    bool has_role(wamp_role_type type) const;
     const wamp_role* get_role(wamp_role_type type) const;
     const std::unordered_set<wamp_role>& get_roles() const;
     const wamp_session_id& get_session_id() const;
-    const std::unique_ptr<wamp_transport>& get_transport() const;
+    const wamp_session_slot& get_slot() const;
+    const std::shared_ptr<wamp_transport>& get_transport() const;
 
     void set_state(wamp_session_state session_state);
+    void set_slot(const wamp_session_slot& slot);
     void set_roles(const std::unordered_set<wamp_role>& roles);
     void set_roles(std::unordered_set<wamp_role>&& roles);
     void add_role(const wamp_role& role);
     void add_role(wamp_role&& role);
 
+private:
+    static uint32_t role_mask(wamp_role_type type);
+    void update_role_mask();
+
 private:
     const std::string m_realm;
     wamp_session_id m_session_id;
+    wamp_session_slot m_slot;
     wamp_session_state m_session_state;
     std::unordered_set<wamp_role> m_roles;
-    std::unique_ptr<wamp_transport> m_transport;
+
+    /// A bitmask of the role types in m_roles so that role checks on the
+    /// hot path do not have to search the set of roles.
+    uint32_t m_role_mask;
+    std::shared_ptr<wamp_transport> m_transport;
 };
 
 inline wamp_session::wamp_session()
     : m_realm()
     , m_session_id()
+    , m_slot()
     , m_session_state(wamp_session_state::NONE)
     , m_roles()
+    , m_role_mask(0)
     , m_transport()
 {
 }
@@ -81,12 +97,14 @@ inline wamp_session::wamp_session()
 inline wamp_session::wamp_session(
         const wamp_session_id& id,
         const std::string& realm,
-        std::unique_ptr<wamp_transport> transport)
+        const std::shared_ptr<wamp_transport>& transport)
     : m_realm(realm)
     , m_session_id(id)
+    , m_slot()
     , m_session_state(wamp_session_state::NONE)
     , m_roles()
-    , m_transport(std::move(transport))
+    , m_role_mask(0)
+    , m_transport(transport)
 {
 }
 
@@ -104,6 +122,11 @@ inline wamp_session_state wamp_session::get_state() const
     return m_session_state;
 }
 
+inline bool wamp_session::has_role(wamp_role_type type) const
+{
+    return (m_role_mask & role_mask(type)) != 0;
+}
+
 inline const wamp_role* wamp_session::get_role(wamp_role_type type) const
 {
     for (const auto& role : m_roles) {
@@ -125,7 +148,12 @@ inline const wamp_session_id& wamp_session::get_session_id() const
     return m_session_id;
 }
 
-inline const std::unique_ptr<wamp_transport>& wamp_session::get_transport() const
+inline const wamp_session_slot& wamp_session::get_slot() const
+{
+    return m_slot;
+}
+
+inline const std::shared_ptr<wamp_transport>& wamp_session::get_transport() const
 {
     return m_transport;
 }
@@ -135,26 +163,48 @@ inline void wamp_session::set_state(wamp_session_state state)
     m_session_state = state;
 }
 
+inline void wamp_session::set_slot(const wamp_session_slot& slot)
+{
+    m_slot = slot;
+}
+
 inline void wamp_session::set_roles(const std::unordered_set<wamp_role>& roles)
 {
     m_roles = roles;
+    update_role_mask();
 }
 
 inline void wamp_session::set_roles(std::unordered_set<wamp_role>&& roles)
 {
     m_roles = std::move(roles);
+    update_role_mask();
 }
 
 inline void wamp_session::add_role(const wamp_role& role)
 {
     m_roles.insert(role);
+    m_role_mask |= role_mask(role.get_type());
 }
 
 inline void wamp_session::add_role(wamp_role&& role)
 {
+    m_role_mask |= role_mask(role.get_type());
     m_roles.insert(std::move(role));
 }
 
+inline uint32_t wamp_session::role_mask(wamp_role_type type)
+{
+    return 1u << static_cast<uint32_t>(type);
+}
+
+inline void wamp_session::update_role_mask()
+{
+    m_role_mask = 0;
+    for (const auto& role : m_roles) {
+        m_role_mask |= role_mask(role.get_type());
+    }
+}
+
 inline std::ostream& operator<<(std::ostream& os, const wamp_session& session)
 {
     os << "session [" << session.get_session_id() << ","
@@ -0,0 +1,100 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_SESSION_WAMP_SESSION_SLOT_HPP
+#define BONEFISH_SESSION_WAMP_SESSION_SLOT_HPP
+
+#include <cstdint>
+#include <limits>
+#include <ostream>
+
+namespace bonefish {
+
+/// A handle to a session stored in a wamp_session_table. The generation
+/// is bumped each time a slot is released so that a stale handle held by
+/// a connection can never resolve to a session that reused the slot.
+class wamp_session_slot
+{
+public:
+    static const uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+public:
+    wamp_session_slot();
+    wamp_session_slot(uint32_t index, uint32_t generation);
+
+    bool is_valid() const;
+    uint32_t index() const;
+    uint32_t generation() const;
+
+    bool operator==(const wamp_session_slot& other) const;
+    bool operator!=(const wamp_session_slot& other) const;
+
+private:
+    uint32_t m_index;
+    uint32_t m_generation;
+};
+
+inline wamp_session_slot::wamp_session_slot()
+    : m_index(INVALID_INDEX)
+    , m_generation(0)
+{
+}
+
+inline wamp_session_slot::wamp_session_slot(uint32_t index, uint32_t generation)
+    : m_index(index)
+    , m_generation(generation)
+{
+}
+
+inline bool wamp_session_slot::is_valid() const
+{
+    return m_index != INVALID_INDEX;
+}
+
+inline uint32_t wamp_session_slot::index() const
+{
+    return m_index;
+}
+
+inline uint32_t wamp_session_slot::generation() const
+{
+    return m_generation;
+}
+
+inline bool wamp_session_slot::operator==(const wamp_session_slot& other) const
+{
+    return m_index == other.m_index && m_generation == other.m_generation;
+}
+
+inline bool wamp_session_slot::operator!=(const wamp_session_slot& other) const
+{
+    return !(*this == other);
+}
+
+inline std::ostream& operator<<(std::ostream& os, const wamp_session_slot& slot)
+{
+    if (slot.is_valid()) {
+        os << slot.index() << ":" << slot.generation();
+    } else {
+        os << "<<invalid>>";
+    }
+
+    return os;
+}
+
+} // namespace bonefish
+
+#endif // BONEFISH_SESSION_WAMP_SESSION_SLOT_HPP
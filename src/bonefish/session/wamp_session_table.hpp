@@ -0,0 +1,137 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_SESSION_WAMP_SESSION_TABLE_HPP
+#define BONEFISH_SESSION_WAMP_SESSION_TABLE_HPP
+
+#include <bonefish/session/wamp_session.hpp>
+#include <bonefish/session/wamp_session_slot.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace bonefish {
+
+/// A slot allocated table of sessions. Sessions are stored in a dense array
+/// and are resolved from a wamp_session_slot with a single index and a
+/// generation check. Released slots are recycled for new sessions.
+class wamp_session_table
+{
+public:
+    wamp_session_table();
+    ~wamp_session_table();
+    wamp_session_table(wamp_session_table const&) = delete;
+    wamp_session_table& operator=(wamp_session_table const&) = delete;
+
+    wamp_session_slot insert(const std::shared_ptr<wamp_session>& session);
+    bool erase(const wamp_session_slot& slot);
+
+    /// Resolves a slot to its session. Returns an empty pointer if the
+    /// slot is invalid or has since been released.
+    const std::shared_ptr<wamp_session>& get(const wamp_session_slot& slot) const;
+
+    size_t size() const;
+    size_t capacity() const;
+
+private:
+    struct slot_entry
+    {
+        std::shared_ptr<wamp_session> m_session;
+        uint32_t m_generation;
+    };
+
+private:
+    std::vector<slot_entry> m_slots;
+    std::vector<uint32_t> m_free_slots;
+    size_t m_size;
+    std::shared_ptr<wamp_session> m_null_session;
+};
+
+inline wamp_session_table::wamp_session_table()
+    : m_slots()
+    , m_free_slots()
+    , m_size(0)
+    , m_null_session()
+{
+}
+
+inline wamp_session_table::~wamp_session_table()
+{
+}
+
+inline wamp_session_slot wamp_session_table::insert(const std::shared_ptr<wamp_session>& session)
+{
+    uint32_t index;
+    if (!m_free_slots.empty()) {
+        index = m_free_slots.back();
+        m_free_slots.pop_back();
+    } else {
+        if (m_slots.size() >= wamp_session_slot::INVALID_INDEX) {
+            throw std::overflow_error("session table is full");
+        }
+        index = static_cast<uint32_t>(m_slots.size());
+        m_slots.push_back(slot_entry{nullptr, 0});
+    }
+
+    auto& entry = m_slots[index];
+    entry.m_session = session;
+    ++m_size;
+
+    return wamp_session_slot(index, entry.m_generation);
+}
+
+inline bool wamp_session_table::erase(const wamp_session_slot& slot)
+{
+    if (!get(slot)) {
+        return false;
+    }
+
+    auto& entry = m_slots[slot.index()];
+    entry.m_session.reset();
+    ++entry.m_generation;
+    m_free_slots.push_back(slot.index());
+    --m_size;
+
+    return true;
+}
+
+inline const std::shared_ptr<wamp_session>& wamp_session_table::get(
+        const wamp_session_slot& slot) const
+{
+    if (slot.index() >= m_slots.size()) {
+        return m_null_session;
+    }
+
+    const auto& entry = m_slots[slot.index()];
+    return entry.m_generation == slot.generation() ? entry.m_session : m_null_session;
+}
+
+inline size_t wamp_session_table::size() const
+{
+    return m_size;
+}
+
+inline size_t wamp_session_table::capacity() const
+{
+    return m_slots.size();
+}
+
+} // namespace bonefish
+
+#endif // BONEFISH_SESSION_WAMP_SESSION_TABLE_HPP
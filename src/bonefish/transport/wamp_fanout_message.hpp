@@ -0,0 +1,98 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_TRANSPORT_WAMP_FANOUT_MESSAGE_HPP
+#define BONEFISH_TRANSPORT_WAMP_FANOUT_MESSAGE_HPP
+
+#include <bonefish/serialization/expandable_buffer.hpp>
+#include <bonefish/serialization/wamp_serializer.hpp>
+#include <bonefish/serialization/wamp_serializer_type.hpp>
+
+#include <cstddef>
+#include <memory>
+
+namespace bonefish {
+
+class wamp_message;
+
+/// A message that is being sent to many sessions at once such as an event
+/// for all of the subscribers of a topic. The message is serialized at most
+/// once per serializer type and transports may additionally attach their own
+/// framed representation so that it can be shared by all of their peers.
+class wamp_fanout_message
+{
+public:
+    explicit wamp_fanout_message(wamp_message& message);
+
+    wamp_fanout_message(const wamp_fanout_message&) = delete;
+    wamp_fanout_message& operator=(const wamp_fanout_message&) = delete;
+
+    wamp_message& get_message();
+
+    /// Returns the message serialized with the given serializer, serializing
+    /// it on first use.
+    const expandable_buffer& serialize(const wamp_serializer& serializer);
+
+    /// Returns the transport specific frame that was attached for the given
+    /// serializer type or an empty pointer if there is none yet.
+    const std::shared_ptr<void>& get_frame(wamp_serializer_type type) const;
+    void set_frame(wamp_serializer_type type, const std::shared_ptr<void>& frame);
+
+private:
+    static const std::size_t SERIALIZER_TYPE_COUNT = 2;
+
+    wamp_message& m_message;
+    std::unique_ptr<expandable_buffer> m_buffers[SERIALIZER_TYPE_COUNT];
+    std::shared_ptr<void> m_frames[SERIALIZER_TYPE_COUNT];
+};
+
+inline wamp_fanout_message::wamp_fanout_message(wamp_message& message)
+    : m_message(message)
+    , m_buffers()
+    , m_frames()
+{
+}
+
+inline wamp_message& wamp_fanout_message::get_message()
+{
+    return m_message;
+}
+
+inline const expandable_buffer& wamp_fanout_message::serialize(const wamp_serializer& serializer)
+{
+    std::unique_ptr<expandable_buffer>& buffer =
+            m_buffers[static_cast<std::size_t>(serializer.get_type())];
+    if (!buffer) {
+        buffer.reset(new expandable_buffer(serializer.serialize(m_message)));
+    }
+
+    return *buffer;
+}
+
+inline const std::shared_ptr<void>& wamp_fanout_message::get_frame(wamp_serializer_type type) const
+{
+    return m_frames[static_cast<std::size_t>(type)];
+}
+
+inline void wamp_fanout_message::set_frame(wamp_serializer_type type,
+        const std::shared_ptr<void>& frame)
+{
+    m_frames[static_cast<std::size_t>(type)] = frame;
+}
+
+} // namespace bonefish
+
+#endif // BONEFISH_TRANSPORT_WAMP_FANOUT_MESSAGE_HPP
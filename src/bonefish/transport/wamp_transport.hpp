@@ -17,6 +17,10 @@
 #ifndef BONEFISH_TRANSPORT_WAMP_TRANSPORT_HPP
 #define BONEFISH_TRANSPORT_WAMP_TRANSPORT_HPP
 
+#include <bonefish/transport/wamp_fanout_message.hpp>
+
+#include <utility>
+
 namespace bonefish {
 
 class wamp_message;
@@ -26,8 +30,17 @@ class wamp_transport
 public:
     virtual ~wamp_transport() = default;
     virtual bool send_message(wamp_message&& message) = 0;
+
+    /// Sends a message that is shared with other transports. Transports that
+    /// can reuse the serialized or framed message should override this.
+    virtual bool send_fanout_message(wamp_fanout_message& message);
 };
 
+inline bool wamp_transport::send_fanout_message(wamp_fanout_message& message)
+{
+    return send_message(std::move(message.get_message()));
+}
+
 } // namespace bonefish
 
 #endif // BONEFISH_TRANSPORT_WAMP_TRANSPORT_HPP
@@ -0,0 +1,78 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <bonefish/utility/wamp_uri_table.hpp>
+
+#include <stdexcept>
+
+namespace bonefish {
+
+const wamp_uri_id wamp_uri_table::INVALID_URI_ID;
+
+wamp_uri_id wamp_uri_table::acquire(const boost::string_ref& uri)
+{
+    auto uri_ids_itr = m_uri_ids.find(uri);
+    if (uri_ids_itr != m_uri_ids.end()) {
+        m_entries[uri_ids_itr->second].m_references++;
+        return uri_ids_itr->second;
+    }
+
+    wamp_uri_id uri_id;
+    if (!m_free_ids.empty()) {
+        uri_id = m_free_ids.back();
+        m_free_ids.pop_back();
+    } else {
+        if (m_entries.size() >= INVALID_URI_ID) {
+            throw std::overflow_error("uri table is full");
+        }
+        uri_id = static_cast<wamp_uri_id>(m_entries.size());
+        m_entries.push_back(uri_entry());
+    }
+
+    auto& entry = m_entries[uri_id];
+    entry.m_uri.reset(new std::string(uri.data(), uri.size()));
+    entry.m_references = 1;
+    m_uri_ids.insert(std::make_pair(boost::string_ref(*entry.m_uri), uri_id));
+
+    return uri_id;
+}
+
+void wamp_uri_table::release(const wamp_uri_id& uri_id)
+{
+    if (uri_id >= m_entries.size() || !m_entries[uri_id].m_uri) {
+        throw std::logic_error("uri id does not exist");
+    }
+
+    auto& entry = m_entries[uri_id];
+    if (--entry.m_references != 0) {
+        return;
+    }
+
+    m_uri_ids.erase(boost::string_ref(*entry.m_uri));
+    entry.m_uri.reset();
+    m_free_ids.push_back(uri_id);
+}
+
+const std::string& wamp_uri_table::get_uri(const wamp_uri_id& uri_id) const
+{
+    if (uri_id >= m_entries.size() || !m_entries[uri_id].m_uri) {
+        throw std::logic_error("uri id does not exist");
+    }
+
+    return *m_entries[uri_id].m_uri;
+}
+
+} // namespace bonefish
@@ -0,0 +1,111 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_UTILITY_WAMP_URI_TABLE_HPP
+#define BONEFISH_UTILITY_WAMP_URI_TABLE_HPP
+
+#include <boost/functional/hash.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace bonefish {
+
+/// A dense integer identifier for an interned URI.
+typedef uint32_t wamp_uri_id;
+
+/// Interns topic and procedure URIs for a realm and maps them to dense integer
+/// ids. Lookups take a string reference into the decoded message so that no
+/// temporary strings need to be constructed on the hot path. Interned URIs are
+/// reference counted and their ids are recycled once the last reference is
+/// released.
+class wamp_uri_table
+{
+public:
+    static const wamp_uri_id INVALID_URI_ID = std::numeric_limits<wamp_uri_id>::max();
+
+public:
+    wamp_uri_table();
+    ~wamp_uri_table();
+    wamp_uri_table(wamp_uri_table const&) = delete;
+    wamp_uri_table& operator=(wamp_uri_table const&) = delete;
+
+    /// Interns the uri if required and adds a reference to it.
+    wamp_uri_id acquire(const boost::string_ref& uri);
+
+    /// Drops a reference to the uri. The id is recycled when no references remain.
+    void release(const wamp_uri_id& uri_id);
+
+    /// Looks up the id of an interned uri. Returns INVALID_URI_ID if the uri
+    /// has not been interned.
+    wamp_uri_id find(const boost::string_ref& uri) const;
+
+    const std::string& get_uri(const wamp_uri_id& uri_id) const;
+    size_t size() const;
+
+private:
+    struct uri_hash
+    {
+        size_t operator()(const boost::string_ref& uri) const
+        {
+            return boost::hash_range(uri.begin(), uri.end());
+        }
+    };
+
+    struct uri_entry
+    {
+        // The string is heap allocated so that the references used as keys
+        // in the lookup table remain stable when the entries are resized.
+        std::unique_ptr<std::string> m_uri;
+        size_t m_references;
+    };
+
+private:
+    std::vector<uri_entry> m_entries;
+    std::vector<wamp_uri_id> m_free_ids;
+    std::unordered_map<boost::string_ref, wamp_uri_id, uri_hash> m_uri_ids;
+};
+
+inline wamp_uri_table::wamp_uri_table()
+    : m_entries()
+    , m_free_ids()
+    , m_uri_ids()
+{
+}
+
+inline wamp_uri_table::~wamp_uri_table()
+{
+}
+
+inline wamp_uri_id wamp_uri_table::find(const boost::string_ref& uri) const
+{
+    auto uri_ids_itr = m_uri_ids.find(uri);
+    return uri_ids_itr != m_uri_ids.end() ? uri_ids_itr->second : INVALID_URI_ID;
+}
+
+inline size_t wamp_uri_table::size() const
+{
+    return m_uri_ids.size();
+}
+
+} // namespace bonefish
+
+#endif // BONEFISH_UTILITY_WAMP_URI_TABLE_HPP
@@ -0,0 +1,154 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_WEBSOCKET_WEBSOCKET_BATCH_HPP
+#define BONEFISH_WEBSOCKET_WEBSOCKET_BATCH_HPP
+
+#include <bonefish/websocket/websocket_protocol.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace bonefish {
+
+/// Packs and unpacks the messages of the batched wamp subprotocols. JSON
+/// batches terminate each message with a 0x1E record separator and msgpack
+/// batches prefix each message with its length as a 32 bit big endian value.
+class websocket_batch
+{
+public:
+    static const char JSON_SEPARATOR = 0x1E;
+
+    explicit websocket_batch(websocket_subprotocol subprotocol);
+
+    void append(const char* data, std::size_t length);
+    void clear();
+
+    bool empty() const;
+    std::size_t size() const;
+    const std::string& get_data() const;
+
+    /// Invokes the handler with the data and length of each message in
+    /// the batch. Throws if the batch is malformed.
+    template <typename Handler>
+    static void split(websocket_subprotocol subprotocol,
+            const char* data, std::size_t length, Handler&& handler);
+
+private:
+    websocket_subprotocol m_subprotocol;
+    std::string m_data;
+};
+
+inline websocket_batch::websocket_batch(websocket_subprotocol subprotocol)
+    : m_subprotocol(subprotocol)
+    , m_data()
+{
+    if (!is_batched_subprotocol(subprotocol)) {
+        throw std::invalid_argument("subprotocol is not batched");
+    }
+}
+
+inline void websocket_batch::append(const char* data, std::size_t length)
+{
+    if (m_subprotocol == websocket_subprotocol::JSON_BATCHED) {
+        m_data.append(data, length);
+        m_data += JSON_SEPARATOR;
+    } else {
+        if (length > UINT32_MAX) {
+            throw std::length_error("message too large for batch");
+        }
+
+        const uint32_t prefix = static_cast<uint32_t>(length);
+        m_data.push_back(static_cast<char>((prefix >> 24) & 0xFF));
+        m_data.push_back(static_cast<char>((prefix >> 16) & 0xFF));
+        m_data.push_back(static_cast<char>((prefix >> 8) & 0xFF));
+        m_data.push_back(static_cast<char>(prefix & 0xFF));
+        m_data.append(data, length);
+    }
+}
+
+inline void websocket_batch::clear()
+{
+    m_data.clear();
+}
+
+inline bool websocket_batch::empty() const
+{
+    return m_data.empty();
+}
+
+inline std::size_t websocket_batch::size() const
+{
+    return m_data.size();
+}
+
+inline const std::string& websocket_batch::get_data() const
+{
+    return m_data;
+}
+
+template <typename Handler>
+void websocket_batch::split(websocket_subprotocol subprotocol,
+        const char* data, std::size_t length, Handler&& handler)
+{
+    const char* const end = data + length;
+
+    if (subprotocol == websocket_subprotocol::JSON_BATCHED) {
+        // Be lenient about a missing separator after the last message and
+        // about empty records as neither can be mistaken for a message.
+        while (data != end) {
+            const char* separator = data;
+            while (separator != end && *separator != JSON_SEPARATOR) {
+                ++separator;
+            }
+
+            if (separator != data) {
+                handler(data, static_cast<std::size_t>(separator - data));
+            }
+
+            data = (separator == end) ? end : separator + 1;
+        }
+    } else if (subprotocol == websocket_subprotocol::MSGPACK_BATCHED) {
+        while (data != end) {
+            if (end - data < 4) {
+                throw std::runtime_error("truncated msgpack batch length prefix");
+            }
+
+            const unsigned char* prefix = reinterpret_cast<const unsigned char*>(data);
+            const std::size_t message_length =
+                    (static_cast<std::size_t>(prefix[0]) << 24) |
+                    (static_cast<std::size_t>(prefix[1]) << 16) |
+                    (static_cast<std::size_t>(prefix[2]) << 8) |
+                    static_cast<std::size_t>(prefix[3]);
+            data += 4;
+
+            if (static_cast<std::size_t>(end - data) < message_length) {
+                throw std::runtime_error("truncated msgpack batch message");
+            }
+
+            handler(data, message_length);
+            data += message_length;
+        }
+    } else {
+        throw std::invalid_argument("subprotocol is not batched");
+    }
+}
+
+} // namespace bonefish
+
+#endif // BONEFISH_WEBSOCKET_WEBSOCKET_BATCH_HPP
@@ -0,0 +1,115 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_WEBSOCKET_WEBSOCKET_COMPRESSION_OPTIONS_HPP
+#define BONEFISH_WEBSOCKET_WEBSOCKET_COMPRESSION_OPTIONS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+namespace bonefish {
+
+/// Options for the permessage-deflate websocket extension. Compression is
+/// only used for connections whose clients offer the extension.
+class websocket_compression_options
+{
+public:
+    websocket_compression_options();
+
+    /// Enable or disable permessage-deflate. Default value is disabled.
+    void set_enabled(bool enabled);
+    bool is_enabled() const;
+
+    /// Set the largest LZ77 window size used when compressing outgoing
+    /// messages as a power of two. Values range from 8 to 15. Smaller
+    /// windows use less memory per connection. Default value is 15.
+    void set_max_window_bits(uint8_t bits);
+    uint8_t get_max_window_bits() const;
+
+    /// Set the payload size in bytes below which outgoing messages are sent
+    /// uncompressed. Default value is 256.
+    void set_min_payload_size(std::size_t size);
+    std::size_t get_min_payload_size() const;
+
+    /// Enable or disable compression context takeover for outgoing messages.
+    /// Disabling it resets the compression context after each message which
+    /// trades compression ratio for memory. Default value is enabled.
+    void set_context_takeover(bool enabled);
+    bool has_context_takeover() const;
+
+private:
+    bool m_enabled;
+    uint8_t m_max_window_bits;
+    std::size_t m_min_payload_size;
+    bool m_context_takeover;
+};
+
+inline websocket_compression_options::websocket_compression_options()
+    : m_enabled(false)
+    , m_max_window_bits(15)
+    , m_min_payload_size(256)
+    , m_context_takeover(true)
+{
+}
+
+inline void websocket_compression_options::set_enabled(bool enabled)
+{
+    m_enabled = enabled;
+}
+
+inline bool websocket_compression_options::is_enabled() const
+{
+    return m_enabled;
+}
+
+inline void websocket_compression_options::set_max_window_bits(uint8_t bits)
+{
+    if (bits < 8 || bits > 15) {
+        throw std::invalid_argument("window bits must be between 8 and 15");
+    }
+
+    m_max_window_bits = bits;
+}
+
+inline uint8_t websocket_compression_options::get_max_window_bits() const
+{
+    return m_max_window_bits;
+}
+
+inline void websocket_compression_options::set_min_payload_size(std::size_t size)
+{
+    m_min_payload_size = size;
+}
+
+inline std::size_t websocket_compression_options::get_min_payload_size() const
+{
+    return m_min_payload_size;
+}
+
+inline void websocket_compression_options::set_context_takeover(bool enabled)
+{
+    m_context_takeover = enabled;
+}
+
+inline bool websocket_compression_options::has_context_takeover() const
+{
+    return m_context_takeover;
+}
+
+} // namespace bonefish
+
+#endif // BONEFISH_WEBSOCKET_WEBSOCKET_COMPRESSION_OPTIONS_HPP
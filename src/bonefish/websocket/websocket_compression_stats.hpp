@@ -0,0 +1,143 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_WEBSOCKET_WEBSOCKET_COMPRESSION_STATS_HPP
+#define BONEFISH_WEBSOCKET_WEBSOCKET_COMPRESSION_STATS_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+
+namespace bonefish {
+
+/// Byte counters for a connection that negotiated permessage-deflate. Only
+/// messages that actually went through the compressor are counted so the
+/// ratio reflects what compression achieved on the wire.
+///
+/// The counters are updated by the thread that compresses or decompresses a
+/// message and may be read from any other thread.
+class websocket_compression_stats
+{
+public:
+    websocket_compression_stats();
+    websocket_compression_stats(websocket_compression_stats const&) = delete;
+    websocket_compression_stats& operator=(websocket_compression_stats const&) = delete;
+
+    /// Counters that the bytes of this connection are added to as well,
+    /// such as the totals of the server that accepted the connection.
+    void set_totals(const std::shared_ptr<websocket_compression_stats>& totals);
+
+    void add_inbound(uint64_t compressed_bytes, uint64_t uncompressed_bytes);
+    void add_outbound(uint64_t compressed_bytes, uint64_t uncompressed_bytes);
+
+    uint64_t get_inbound_compressed_bytes() const;
+    uint64_t get_inbound_uncompressed_bytes() const;
+    uint64_t get_outbound_compressed_bytes() const;
+    uint64_t get_outbound_uncompressed_bytes() const;
+
+    /// The ratio of compressed to uncompressed bytes in both directions or
+    /// 1.0 if nothing has been compressed yet.
+    double get_ratio() const;
+
+private:
+    std::atomic<uint64_t> m_inbound_compressed_bytes;
+    std::atomic<uint64_t> m_inbound_uncompressed_bytes;
+    std::atomic<uint64_t> m_outbound_compressed_bytes;
+    std::atomic<uint64_t> m_outbound_uncompressed_bytes;
+    std::shared_ptr<websocket_compression_stats> m_totals;
+};
+
+inline websocket_compression_stats::websocket_compression_stats()
+    : m_inbound_compressed_bytes(0)
+    , m_inbound_uncompressed_bytes(0)
+    , m_outbound_compressed_bytes(0)
+    , m_outbound_uncompressed_bytes(0)
+    , m_totals()
+{
+}
+
+inline void websocket_compression_stats::set_totals(
+        const std::shared_ptr<websocket_compression_stats>& totals)
+{
+    m_totals = totals;
+}
+
+inline void websocket_compression_stats::add_inbound(
+        uint64_t compressed_bytes, uint64_t uncompressed_bytes)
+{
+    m_inbound_compressed_bytes.fetch_add(compressed_bytes, std::memory_order_relaxed);
+    m_inbound_uncompressed_bytes.fetch_add(uncompressed_bytes, std::memory_order_relaxed);
+    if (m_totals) {
+        m_totals->add_inbound(compressed_bytes, uncompressed_bytes);
+    }
+}
+
+inline void websocket_compression_stats::add_outbound(
+        uint64_t compressed_bytes, uint64_t uncompressed_bytes)
+{
+    m_outbound_compressed_bytes.fetch_add(compressed_bytes, std::memory_order_relaxed);
+    m_outbound_uncompressed_bytes.fetch_add(uncompressed_bytes, std::memory_order_relaxed);
+    if (m_totals) {
+        m_totals->add_outbound(compressed_bytes, uncompressed_bytes);
+    }
+}
+
+inline uint64_t websocket_compression_stats::get_inbound_compressed_bytes() const
+{
+    return m_inbound_compressed_bytes.load(std::memory_order_relaxed);
+}
+
+inline uint64_t websocket_compression_stats::get_inbound_uncompressed_bytes() const
+{
+    return m_inbound_uncompressed_bytes.load(std::memory_order_relaxed);
+}
+
+inline uint64_t websocket_compression_stats::get_outbound_compressed_bytes() const
+{
+    return m_outbound_compressed_bytes.load(std::memory_order_relaxed);
+}
+
+inline uint64_t websocket_compression_stats::get_outbound_uncompressed_bytes() const
+{
+    return m_outbound_uncompressed_bytes.load(std::memory_order_relaxed);
+}
+
+inline double websocket_compression_stats::get_ratio() const
+{
+    const uint64_t uncompressed_bytes =
+            get_inbound_uncompressed_bytes() + get_outbound_uncompressed_bytes();
+    if (uncompressed_bytes == 0) {
+        return 1.0;
+    }
+
+    return static_cast<double>(get_inbound_compressed_bytes() + get_outbound_compressed_bytes()) /
+            static_cast<double>(uncompressed_bytes);
+}
+
+inline std::ostream& operator<<(std::ostream& os, const websocket_compression_stats& stats)
+{
+    os << "in " << stats.get_inbound_compressed_bytes() << "/"
+            << stats.get_inbound_uncompressed_bytes()
+            << " out " << stats.get_outbound_compressed_bytes() << "/"
+            << stats.get_outbound_uncompressed_bytes()
+            << " ratio " << stats.get_ratio();
+    return os;
+}
+
+} // namespace bonefish
+
+#endif // BONEFISH_WEBSOCKET_WEBSOCKET_COMPRESSION_STATS_HPP
@@ -17,9 +17,13 @@
 #ifndef BONEFISH_WEBSOCKET_WEBSOCKET_CONFIG_HPP
 #define BONEFISH_WEBSOCKET_WEBSOCKET_CONFIG_HPP
 
-#include <bonefish/common/wamp_connection_base.hpp>
+#include <bonefish/websocket/websocket_connection_base.hpp>
+#include <bonefish/websocket/websocket_message_pool.hpp>
+#include <bonefish/websocket/websocket_permessage_deflate.hpp>
 
 #include <websocketpp/config/asio_no_tls.hpp>
+#include <websocketpp/message_buffer/alloc.hpp>
+#include <websocketpp/message_buffer/message.hpp>
 
 namespace bonefish {
 
@@ -32,9 +36,14 @@ public:
     typedef core::concurrency_type concurrency_type;
     typedef core::request_type request_type;
     typedef core::response_type response_type;
-    typedef core::message_type message_type;
-    typedef core::con_msg_manager_type con_msg_manager_type;
-    typedef core::endpoint_msg_manager_type endpoint_msg_manager_type;
+
+    // Recycle the messages of each connection rather than allocating a new
+    // message and payload for every frame.
+    typedef websocketpp::message_buffer::message<websocket_message_pool> message_type;
+    typedef websocket_message_pool<message_type> con_msg_manager_type;
+    typedef websocketpp::message_buffer::alloc::endpoint_msg_manager<
+            con_msg_manager_type> endpoint_msg_manager_type;
+
     typedef core::alog_type alog_type;
     typedef core::elog_type elog_type;
     typedef core::rng_type rng_type;
@@ -42,7 +51,12 @@ public:
     typedef core::endpoint_base endpoint_base;
 
     // Set a custom connection_base class
-    typedef wamp_connection_base connection_base;
+    typedef websocket_connection_base connection_base;
+
+    // Enable the permessage-deflate extension. Whether or not it is offered
+    // to clients is decided at runtime by the websocket compression options.
+    struct permessage_deflate_config {};
+    typedef websocket_permessage_deflate<permessage_deflate_config> permessage_deflate_type;
 };
 
 } // namespace bonefish
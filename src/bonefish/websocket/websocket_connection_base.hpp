@@ -0,0 +1,104 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_WEBSOCKET_WEBSOCKET_CONNECTION_BASE_HPP
+#define BONEFISH_WEBSOCKET_WEBSOCKET_CONNECTION_BASE_HPP
+
+#include <bonefish/common/wamp_connection_base.hpp>
+#include <bonefish/websocket/websocket_compression_stats.hpp>
+#include <bonefish/websocket/websocket_protocol.hpp>
+
+#include <memory>
+
+namespace bonefish {
+
+class wamp_serializer;
+
+/// The per connection state for websocket connections. The subprotocol and
+/// serializer are resolved once when the connection is validated so that
+/// they do not have to be looked up for each message that is received.
+class websocket_connection_base : public wamp_connection_base
+{
+public:
+    websocket_connection_base();
+    virtual ~websocket_connection_base() override;
+
+    void set_subprotocol(websocket_subprotocol subprotocol);
+    websocket_subprotocol get_subprotocol_type() const;
+
+    void set_serializer(const std::shared_ptr<wamp_serializer>& serializer);
+    const std::shared_ptr<wamp_serializer>& get_serializer() const;
+
+    void set_compression_stats(const std::shared_ptr<websocket_compression_stats>& stats);
+    const std::shared_ptr<websocket_compression_stats>& get_compression_stats() const;
+
+private:
+    websocket_subprotocol m_subprotocol;
+    std::shared_ptr<wamp_serializer> m_serializer;
+
+    /// The byte counters for the connection if permessage-deflate was
+    /// negotiated with the client, otherwise empty.
+    std::shared_ptr<websocket_compression_stats> m_compression_stats;
+};
+
+inline websocket_connection_base::websocket_connection_base()
+    : wamp_connection_base()
+    , m_subprotocol(websocket_subprotocol::NONE)
+    , m_serializer()
+    , m_compression_stats()
+{
+}
+
+inline websocket_connection_base::~websocket_connection_base()
+{
+}
+
+inline void websocket_connection_base::set_subprotocol(websocket_subprotocol subprotocol)
+{
+    m_subprotocol = subprotocol;
+}
+
+inline websocket_subprotocol websocket_connection_base::get_subprotocol_type() const
+{
+    return m_subprotocol;
+}
+
+inline void websocket_connection_base::set_serializer(
+        const std::shared_ptr<wamp_serializer>& serializer)
+{
+    m_serializer = serializer;
+}
+
+inline const std::shared_ptr<wamp_serializer>& websocket_connection_base::get_serializer() const
+{
+    return m_serializer;
+}
+
+inline void websocket_connection_base::set_compression_stats(
+        const std::shared_ptr<websocket_compression_stats>& stats)
+{
+    m_compression_stats = stats;
+}
+
+inline const std::shared_ptr<websocket_compression_stats>&
+websocket_connection_base::get_compression_stats() const
+{
+    return m_compression_stats;
+}
+
+} // namespace bonefish
+
+#endif // BONEFISH_WEBSOCKET_WEBSOCKET_CONNECTION_BASE_HPP
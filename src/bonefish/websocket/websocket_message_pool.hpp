@@ -0,0 +1,154 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_WEBSOCKET_WEBSOCKET_MESSAGE_POOL_HPP
+#define BONEFISH_WEBSOCKET_WEBSOCKET_MESSAGE_POOL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include <websocketpp/frame.hpp>
+
+namespace bonefish {
+
+/// A websocketpp connection message manager that recycles the messages of
+/// a connection instead of allocating a new message and payload per frame.
+///
+/// A pooled message is only handed out again once the pool holds the last
+/// reference to it. This means that a payload which is still referenced by
+/// a decoded wamp message, or which is still queued for sending, is never
+/// overwritten. Once a connection has warmed up receiving or sending a frame
+/// does not allocate.
+///
+/// A pool is only ever used by the thread that services its connection.
+template <typename message>
+class websocket_message_pool :
+        public std::enable_shared_from_this<websocket_message_pool<message>>
+{
+public:
+    typedef websocket_message_pool<message> type;
+    typedef std::shared_ptr<websocket_message_pool> ptr;
+    typedef std::weak_ptr<websocket_message_pool> weak_ptr;
+    typedef typename message::ptr message_ptr;
+
+    websocket_message_pool();
+
+    message_ptr get_message();
+    message_ptr get_message(websocketpp::frame::opcode::value opcode, std::size_t size);
+
+    /// Recycling happens implicitly when the last outside reference to a
+    /// pooled message is released so there is nothing to do here.
+    bool recycle(message* msg);
+
+private:
+    message_ptr acquire();
+
+private:
+    /// The maximum number of messages kept per connection. Any messages
+    /// requested beyond this while all pooled messages are in use are
+    /// allocated as usual and released once they are no longer needed.
+    static const std::size_t MAX_POOLED_MESSAGES = 16;
+
+    /// Payloads that have grown beyond this capacity are released rather
+    /// than kept around for the lifetime of the connection.
+    static const std::size_t MAX_POOLED_CAPACITY = 64 * 1024;
+
+    std::vector<message_ptr> m_messages;
+};
+
+template <typename message>
+websocket_message_pool<message>::websocket_message_pool()
+    : m_messages()
+{
+}
+
+template <typename message>
+typename websocket_message_pool<message>::message_ptr
+websocket_message_pool<message>::get_message()
+{
+    message_ptr msg = acquire();
+    if (!msg) {
+        msg = std::make_shared<message>(type::shared_from_this());
+    }
+
+    return msg;
+}
+
+template <typename message>
+typename websocket_message_pool<message>::message_ptr
+websocket_message_pool<message>::get_message(
+        websocketpp::frame::opcode::value opcode, std::size_t size)
+{
+    message_ptr msg = acquire();
+    if (!msg) {
+        return std::make_shared<message>(type::shared_from_this(), opcode, size);
+    }
+
+    msg->set_opcode(opcode);
+    msg->get_raw_payload().reserve(size);
+
+    return msg;
+}
+
+template <typename message>
+bool websocket_message_pool<message>::recycle(message* msg)
+{
+    return false;
+}
+
+template <typename message>
+typename websocket_message_pool<message>::message_ptr
+websocket_message_pool<message>::acquire()
+{
+    for (message_ptr& pooled : m_messages) {
+        if (pooled.use_count() != 1) {
+            continue;
+        }
+
+        // The last outside reference may have been released by the router
+        // thread which decoded the payload so its reads have to complete
+        // before the payload is overwritten.
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        std::string& payload = pooled->get_raw_payload();
+        if (payload.capacity() > MAX_POOLED_CAPACITY) {
+            std::string().swap(payload);
+        } else {
+            payload.clear();
+        }
+
+        pooled->set_header(std::string());
+        pooled->set_prepared(false);
+        pooled->set_fin(true);
+        pooled->set_terminal(false);
+        pooled->set_compressed(false);
+
+        return pooled;
+    }
+
+    if (m_messages.size() < MAX_POOLED_MESSAGES) {
+        m_messages.push_back(std::make_shared<message>(type::shared_from_this()));
+        return m_messages.back();
+    }
+
+    return message_ptr();
+}
+
+} // namespace bonefish
+
+#endif // BONEFISH_WEBSOCKET_WEBSOCKET_MESSAGE_POOL_HPP
@@ -0,0 +1,52 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <bonefish/websocket/websocket_permessage_deflate.hpp>
+
+namespace bonefish {
+
+namespace {
+
+websocket_compression_options g_compression_options;
+thread_local std::shared_ptr<websocket_compression_stats> g_negotiated_stats;
+
+} // namespace
+
+void websocket_permessage_deflate_context::set_options(
+        const websocket_compression_options& options)
+{
+    g_compression_options = options;
+}
+
+const websocket_compression_options& websocket_permessage_deflate_context::get_options()
+{
+    return g_compression_options;
+}
+
+void websocket_permessage_deflate_context::set_negotiated_stats(
+        const std::shared_ptr<websocket_compression_stats>& stats)
+{
+    g_negotiated_stats = stats;
+}
+
+std::shared_ptr<websocket_compression_stats> websocket_permessage_deflate_context::take_negotiated_stats()
+{
+    std::shared_ptr<websocket_compression_stats> stats;
+    stats.swap(g_negotiated_stats);
+    return stats;
+}
+
+} // namespace bonefish
@@ -0,0 +1,139 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef BONEFISH_WEBSOCKET_WEBSOCKET_PERMESSAGE_DEFLATE_HPP
+#define BONEFISH_WEBSOCKET_WEBSOCKET_PERMESSAGE_DEFLATE_HPP
+
+#include <bonefish/websocket/websocket_compression_options.hpp>
+#include <bonefish/websocket/websocket_compression_stats.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <websocketpp/extensions/permessage_deflate/enabled.hpp>
+
+namespace bonefish {
+
+/// Websocketpp constructs the permessage-deflate extension itself for each
+/// connection so there is no way to hand it per server state. The options
+/// are therefore process wide and the byte counters of a newly negotiated
+/// extension are handed to the connection through a thread local slot that
+/// is claimed when the connection is validated. Negotiation and validation
+/// happen in the same handler so the slot is never observed by another
+/// connection.
+class websocket_permessage_deflate_context
+{
+public:
+    static void set_options(const websocket_compression_options& options);
+    static const websocket_compression_options& get_options();
+
+    static void set_negotiated_stats(const std::shared_ptr<websocket_compression_stats>& stats);
+    static std::shared_ptr<websocket_compression_stats> take_negotiated_stats();
+};
+
+/// The permessage-deflate extension configured from the process wide
+/// websocket compression options. The base class members are hidden rather
+/// than overridden as the websocket processor uses the extension type
+/// directly.
+template <typename config>
+class websocket_permessage_deflate :
+        public websocketpp::extensions::permessage_deflate::enabled<config>
+{
+public:
+    websocket_permessage_deflate();
+
+    bool is_implemented() const;
+    websocketpp::lib::error_code init(bool is_server);
+    websocketpp::lib::error_code compress(const std::string& in, std::string& out);
+    websocketpp::lib::error_code decompress(const uint8_t* buffer, std::size_t length,
+            std::string& out);
+
+private:
+    typedef websocketpp::extensions::permessage_deflate::enabled<config> base;
+
+    std::shared_ptr<websocket_compression_stats> m_stats;
+};
+
+template <typename config>
+websocket_permessage_deflate<config>::websocket_permessage_deflate()
+    : base()
+    , m_stats()
+{
+    const websocket_compression_options& options =
+            websocket_permessage_deflate_context::get_options();
+
+    if (!options.has_context_takeover()) {
+        base::enable_server_no_context_takeover();
+    }
+
+    // Never let the client negotiate a larger window than the one that
+    // has been configured for the server.
+    if (options.get_max_window_bits() < 15) {
+        base::set_server_max_window_bits(options.get_max_window_bits(),
+                websocketpp::extensions::permessage_deflate::mode::smallest);
+    }
+}
+
+template <typename config>
+bool websocket_permessage_deflate<config>::is_implemented() const
+{
+    return websocket_permessage_deflate_context::get_options().is_enabled();
+}
+
+template <typename config>
+websocketpp::lib::error_code websocket_permessage_deflate<config>::init(bool is_server)
+{
+    websocketpp::lib::error_code ec = base::init(is_server);
+    if (!ec) {
+        m_stats = std::make_shared<websocket_compression_stats>();
+        websocket_permessage_deflate_context::set_negotiated_stats(m_stats);
+    }
+
+    return ec;
+}
+
+template <typename config>
+websocketpp::lib::error_code websocket_permessage_deflate<config>::compress(
+        const std::string& in, std::string& out)
+{
+    // The compressor appends to the output buffer so only count the
+    // bytes that were added by this call.
+    const std::size_t offset = out.size();
+    websocketpp::lib::error_code ec = base::compress(in, out);
+    if (!ec && m_stats) {
+        m_stats->add_outbound(out.size() - offset, in.size());
+    }
+
+    return ec;
+}
+
+template <typename config>
+websocketpp::lib::error_code websocket_permessage_deflate<config>::decompress(
+        const uint8_t* buffer, std::size_t length, std::string& out)
+{
+    const std::size_t offset = out.size();
+    websocketpp::lib::error_code ec = base::decompress(buffer, length, out);
+    if (!ec && m_stats) {
+        m_stats->add_inbound(length, out.size() - offset);
+    }
+
+    return ec;
+}
+
+} // namespace bonefish
+
+#endif // BONEFISH_WEBSOCKET_WEBSOCKET_PERMESSAGE_DEFLATE_HPP
@@ -20,5 +20,28 @@ namespace bonefish {
 
 const std::string WAMPV2_JSON_SUBPROTOCOL("wamp.2.json");
 const std::string WAMPV2_MSGPACK_SUBPROTOCOL("wamp.2.msgpack");
+const std::string WAMPV2_JSON_BATCHED_SUBPROTOCOL("wamp.2.json.batched");
+const std::string WAMPV2_MSGPACK_BATCHED_SUBPROTOCOL("wamp.2.msgpack.batched");
+
+websocket_subprotocol subprotocol_from_string(const std::string& subprotocol)
+{
+    if (subprotocol == WAMPV2_MSGPACK_SUBPROTOCOL) {
+        return websocket_subprotocol::MSGPACK;
+    }
+
+    if (subprotocol == WAMPV2_JSON_SUBPROTOCOL) {
+        return websocket_subprotocol::JSON;
+    }
+
+    if (subprotocol == WAMPV2_MSGPACK_BATCHED_SUBPROTOCOL) {
+        return websocket_subprotocol::MSGPACK_BATCHED;
+    }
+
+    if (subprotocol == WAMPV2_JSON_BATCHED_SUBPROTOCOL) {
+        return websocket_subprotocol::JSON_BATCHED;
+    }
+
+    return websocket_subprotocol::NONE;
+}
 
 } // namespace bonefish
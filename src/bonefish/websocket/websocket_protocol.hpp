@@ -17,12 +17,32 @@
 #ifndef BONEFISH_WEBSOCKET_WEBSOCKET_PROTOCOL_HPP
 #define BONEFISH_WEBSOCKET_WEBSOCKET_PROTOCOL_HPP
 
+#include <cstdint>
 #include <string>
 
 namespace bonefish {
 
 extern const std::string WAMPV2_JSON_SUBPROTOCOL;
 extern const std::string WAMPV2_MSGPACK_SUBPROTOCOL;
+extern const std::string WAMPV2_JSON_BATCHED_SUBPROTOCOL;
+extern const std::string WAMPV2_MSGPACK_BATCHED_SUBPROTOCOL;
+
+enum class websocket_subprotocol : uint8_t
+{
+    NONE,
+    JSON,
+    MSGPACK,
+    JSON_BATCHED,
+    MSGPACK_BATCHED
+};
+
+websocket_subprotocol subprotocol_from_string(const std::string& subprotocol);
+
+inline bool is_batched_subprotocol(websocket_subprotocol subprotocol)
+{
+    return subprotocol == websocket_subprotocol::JSON_BATCHED ||
+            subprotocol == websocket_subprotocol::MSGPACK_BATCHED;
+}
 
 } // namespace bonefish
 
@@ -25,8 +25,10 @@ namespace bonefish {
 websocket_server::websocket_server(
         boost::asio::io_service& io_service,
         const std::shared_ptr<wamp_routers>& routers,
-        const std::shared_ptr<wamp_serializers>& serializers)
-    : m_impl(std::make_shared<websocket_server_impl>(io_service, routers, serializers))
+        const std::shared_ptr<wamp_serializers>& serializers,
+        const websocket_compression_options& compression_options)
+    : m_impl(std::make_shared<websocket_server_impl>(
+            io_service, routers, serializers, compression_options))
 {
 }
 
@@ -39,9 +41,20 @@ void websocket_server::start(const boost::asio::ip::address& ip_address, uint16_
     m_impl->start(ip_address, port);
 }
 
+void websocket_server::start(const boost::asio::ip::address& ip_address, uint16_t port,
+        const std::vector<boost::asio::io_service*>& io_services)
+{
+    m_impl->start(ip_address, port, io_services);
+}
+
 void websocket_server::shutdown()
 {
     m_impl->shutdown();
 }
 
+const websocket_compression_stats& websocket_server::get_compression_stats() const
+{
+    return m_impl->get_compression_stats();
+}
+
 } // namespace bonefish
@@ -17,10 +17,14 @@
 #ifndef BONEFISH_WEBSOCKET_WEBSOCKET_SERVER_HPP
 #define BONEFISH_WEBSOCKET_WEBSOCKET_SERVER_HPP
 
+#include <bonefish/websocket/websocket_compression_options.hpp>
+#include <bonefish/websocket/websocket_compression_stats.hpp>
+
 #include <boost/asio/io_service.hpp>
 #include <boost/asio/ip/address.hpp>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace bonefish {
 
@@ -33,12 +37,24 @@ class websocket_server
 public:
     websocket_server(boost::asio::io_service& io_service,
             const std::shared_ptr<wamp_routers>& routers,
-            const std::shared_ptr<wamp_serializers>& serializers);
+            const std::shared_ptr<wamp_serializers>& serializers,
+            const websocket_compression_options& compression_options =
+                    websocket_compression_options());
     ~websocket_server();
 
     void start(const boost::asio::ip::address& ip_address, uint16_t port);
+
+    /// Starts one SO_REUSEPORT acceptor on each of the given io services.
+    /// Connections stay on the io service that accepted them while their
+    /// messages are processed on the io service the server was created with.
+    void start(const boost::asio::ip::address& ip_address, uint16_t port,
+            const std::vector<boost::asio::io_service*>& io_services);
     void shutdown();
 
+    /// The bytes that went through permessage-deflate on all connections
+    /// and the resulting compression ratio.
+    const websocket_compression_stats& get_compression_stats() const;
+
 private:
     std::shared_ptr<websocket_server_impl> m_impl;
 };
@@ -24,10 +24,15 @@
 #include <bonefish/serialization/wamp_serializers.hpp>
 #include <bonefish/transport/wamp_transport.hpp>
 #include <bonefish/trace/trace.hpp>
+#include <bonefish/websocket/websocket_batch.hpp>
+#include <bonefish/websocket/websocket_compression_stats.hpp>
+#include <bonefish/websocket/websocket_permessage_deflate.hpp>
 #include <bonefish/websocket/websocket_protocol.hpp>
 #include <bonefish/websocket/websocket_transport.hpp>
 
+#include <boost/asio/detail/socket_option.hpp>
 #include <boost/asio/io_service.hpp>
+#include <stdexcept>
 #include <websocketpp/common/connection_hdl.hpp>
 #include <websocketpp/utilities.hpp>
 
@@ -36,11 +41,14 @@ namespace bonefish {
 websocket_server_impl::websocket_server_impl(
         boost::asio::io_service& io_service,
         const std::shared_ptr<wamp_routers>& routers,
-        const std::shared_ptr<wamp_serializers>& serializers)
+        const std::shared_ptr<wamp_serializers>& serializers,
+        const websocket_compression_options& compression_options)
     : m_io_service(io_service)
-    , m_server(new websocketpp::server<websocket_config>())
+    , m_servers()
     , m_routers(routers)
     , m_serializers(serializers)
+    , m_compression_options(compression_options)
+    , m_compression_stats(std::make_shared<websocket_compression_stats>())
     , m_message_processor(m_routers)
 {
 }
@@ -50,12 +58,57 @@ websocket_server_impl::~websocket_server_impl()
 }
 
 void websocket_server_impl::start(const boost::asio::ip::address& ip_address, uint16_t port)
+{
+    start(ip_address, port, std::vector<boost::asio::io_service*>(1, &m_io_service));
+}
+
+void websocket_server_impl::start(const boost::asio::ip::address& ip_address, uint16_t port,
+        const std::vector<boost::asio::io_service*>& io_services)
 {
     BONEFISH_TRACE("starting websocket server: %1%:%2%", ip_address.to_string() % port);
 
+    if (io_services.empty()) {
+        throw std::invalid_argument("no io services to accept connections on");
+    }
+
     boost::asio::ip::tcp::endpoint endpoint(ip_address, port);
 
+    // The permessage-deflate extension is created by websocketpp and can
+    // only be configured through the process wide compression options.
+    websocket_permessage_deflate_context::set_options(m_compression_options);
+
+    for (boost::asio::io_service* io_service : io_services) {
+        std::shared_ptr<server_type> server =
+                create_server(*io_service, io_services.size() > 1);
+        server->listen(endpoint);
+        server->start_accept();
+        m_servers.push_back(server);
+    }
+}
+
+void websocket_server_impl::shutdown()
+{
+    BONEFISH_TRACE("stopping websocket server");
+    for (const auto& server : m_servers) {
+        std::shared_ptr<server_type> stopping_server = server;
+        server->get_io_service().dispatch([stopping_server]() {
+            websocketpp::lib::error_code ec;
+            stopping_server->stop_listening(ec);
+        });
+    }
+}
+
+const websocket_compression_stats& websocket_server_impl::get_compression_stats() const
+{
+    return *m_compression_stats;
+}
+
+std::shared_ptr<websocket_server_impl::server_type> websocket_server_impl::create_server(
+        boost::asio::io_service& io_service, bool reuse_port)
+{
+    std::shared_ptr<server_type> server = std::make_shared<server_type>();
     std::weak_ptr<websocket_server_impl> weak_self = shared_from_this();
+    std::weak_ptr<server_type> weak_server = server;
 
     auto init_handler = [weak_self](
             websocketpp::connection_hdl handle,
@@ -65,15 +118,16 @@ void websocket_server_impl::start(const boost::asio::ip::address& ip_address, ui
             shared_self->on_socket_init(handle, socket);
         }
     };
-    m_server->set_socket_init_handler(init_handler);
+    server->set_socket_init_handler(init_handler);
 
-    auto open_handler = [weak_self](websocketpp::connection_hdl handle) {
+    auto open_handler = [weak_self, weak_server](websocketpp::connection_hdl handle) {
         auto shared_self = weak_self.lock();
-        if (shared_self) {
-            shared_self->on_open(handle);
+        auto shared_server = weak_server.lock();
+        if (shared_self && shared_server) {
+            shared_self->on_open(shared_server, handle);
         }
     };
-    m_server->set_open_handler(open_handler);
+    server->set_open_handler(open_handler);
 
     auto close_handler = [weak_self](websocketpp::connection_hdl handle) {
         auto shared_self = weak_self.lock();
@@ -81,7 +135,7 @@ void websocket_server_impl::start(const boost::asio::ip::address& ip_address, ui
             shared_self->on_close(handle);
         }
     };
-    m_server->set_close_handler(close_handler);
+    server->set_close_handler(close_handler);
 
     auto fail_handler = [weak_self](websocketpp::connection_hdl handle) {
         auto shared_self = weak_self.lock();
@@ -89,7 +143,7 @@ void websocket_server_impl::start(const boost::asio::ip::address& ip_address, ui
             shared_self->on_fail(handle);
         }
     };
-    m_server->set_fail_handler(fail_handler);
+    server->set_fail_handler(fail_handler);
 
     auto validate_handler = [weak_self](websocketpp::connection_hdl handle) -> bool {
         auto shared_self = weak_self.lock();
@@ -98,37 +152,77 @@ void websocket_server_impl::start(const boost::asio::ip::address& ip_address, ui
         }
         return false;
     };
-    m_server->set_validate_handler(validate_handler);
+    server->set_validate_handler(validate_handler);
 
-    auto message_handler = [weak_self](
+    auto message_handler = [weak_self, weak_server](
             websocketpp::connection_hdl handle,
-            websocketpp::server<websocket_config>::message_ptr message) {
+            server_type::message_ptr message) {
         auto shared_self = weak_self.lock();
-        if (shared_self) {
-            shared_self->on_message(handle, message);
+        auto shared_server = weak_server.lock();
+        if (shared_self && shared_server) {
+            shared_self->on_message(shared_server, handle, message);
         }
     };
-    m_server->set_message_handler(message_handler);
+    server->set_message_handler(message_handler);
 
     // Set log settings
     if (bonefish::trace::is_enabled()) {
-        m_server->set_access_channels(websocketpp::log::alevel::all);
-        m_server->set_error_channels(websocketpp::log::elevel::all);
+        server->set_access_channels(websocketpp::log::alevel::all);
+        server->set_error_channels(websocketpp::log::elevel::all);
     } else {
-        m_server->set_access_channels(websocketpp::log::alevel::none);
-        m_server->set_error_channels(websocketpp::log::elevel::none);
+        server->set_access_channels(websocketpp::log::alevel::none);
+        server->set_error_channels(websocketpp::log::elevel::none);
+    }
+
+    server->init_asio(&io_service);
+    server->set_reuse_addr(true);
+
+#if defined(SO_REUSEPORT)
+    if (reuse_port) {
+        server->set_tcp_pre_bind_handler([](server_type::transport_type::acceptor_ptr acceptor) {
+            typedef boost::asio::detail::socket_option::boolean<
+                    SOL_SOCKET, SO_REUSEPORT> reuse_port_option;
+            boost::system::error_code ec;
+            acceptor->set_option(reuse_port_option(true), ec);
+            return websocketpp::lib::error_code();
+        });
     }
+#else
+    if (reuse_port) {
+        throw std::invalid_argument("multiple acceptors require SO_REUSEPORT support");
+    }
+#endif
 
-    m_server->init_asio(&m_io_service);
-    m_server->set_reuse_addr(true);
-    m_server->listen(endpoint);
-    m_server->start_accept();
+    return server;
 }
 
-void websocket_server_impl::shutdown()
+websocket_server_impl::server_type::connection_ptr websocket_server_impl::get_connection(
+        websocketpp::connection_hdl handle)
 {
-    BONEFISH_TRACE("stopping websocket server");
-    m_server->stop_listening();
+    // Looking up a connection does not depend on the server that accepted
+    // it so any of the servers can be used.
+    return m_servers.front()->get_con_from_hdl(handle);
+}
+
+void websocket_server_impl::dispatch_message(const server_type::connection_ptr& connection,
+        std::unique_ptr<wamp_message>&& message, bool remote)
+{
+    // Messages are decoded on the thread of the server that accepted the
+    // connection and processed on the thread that drives the routers. That
+    // is usually the same thread in which case they are processed right
+    // away. Otherwise they wait in the connection's inbox and the routers
+    // are only woken up for the first message since they last looked.
+    if (!remote) {
+        m_message_processor.process_message(message, connection.get());
+        return;
+    }
+
+    if (connection->get_inbox().push(std::move(message))) {
+        std::shared_ptr<websocket_server_impl> shared_self = shared_from_this();
+        m_io_service.post([shared_self, connection]() {
+            shared_self->m_message_processor.process_inbox(connection.get());
+        });
+    }
 }
 
 void websocket_server_impl::on_socket_init(websocketpp::connection_hdl handle,
@@ -137,57 +231,84 @@ void websocket_server_impl::on_socket_init(websocketpp::connection_hdl handle,
     s.set_option(boost::asio::ip::tcp::no_delay(true));
 }
 
-void websocket_server_impl::on_open(websocketpp::connection_hdl handle)
+void websocket_server_impl::on_open(const std::shared_ptr<server_type>& server,
+        websocketpp::connection_hdl handle)
 {
+    server_type::connection_ptr connection = get_connection(handle);
+
+    // The transport is created once per connection and is shared by any
+    // sessions that are established over the connection.
+    connection->set_transport(std::make_shared<websocket_transport>(
+            m_io_service, connection->get_serializer(), handle, server,
+            connection->get_subprotocol_type(),
+            m_compression_options.get_min_payload_size()));
 }
 
 void websocket_server_impl::on_close(websocketpp::connection_hdl handle)
 {
-    websocketpp::server<websocket_config>::connection_ptr connection =
-            m_server->get_con_from_hdl(handle);
-
-    if (connection->has_session_id()) {
-        std::shared_ptr<wamp_router> router =
-                m_routers->get_router(connection->get_realm());
-        if (router) {
-            router->detach_session(connection->get_session_id());
-        }
-    }
+    detach_connection(get_connection(handle));
 }
 
 void websocket_server_impl::on_fail(websocketpp::connection_hdl handle)
 {
-    websocketpp::server<websocket_config>::connection_ptr connection =
-            m_server->get_con_from_hdl(handle);
+    detach_connection(get_connection(handle));
+}
 
-    if (connection->has_session_id()) {
-        std::shared_ptr<wamp_router> router =
-                m_routers->get_router(connection->get_realm());
-        if (router) {
-            router->detach_session(connection->get_session_id());
+void websocket_server_impl::detach_connection(const server_type::connection_ptr& connection)
+{
+    std::shared_ptr<websocket_server_impl> shared_self = shared_from_this();
+    m_io_service.dispatch([shared_self, connection]() {
+        if (connection->has_session_id()) {
+            const std::shared_ptr<wamp_router>& router = connection->get_router();
+            if (router) {
+                router->detach_session(connection->get_session_slot());
+            }
         }
-    }
+
+        if (connection->get_compression_stats()) {
+            BONEFISH_TRACE("compression: %1%", *connection->get_compression_stats());
+        }
+
+        connection->set_transport(nullptr);
+    });
 }
 
 bool websocket_server_impl::on_validate(websocketpp::connection_hdl handle)
 {
-    websocketpp::server<websocket_config>::connection_ptr connection =
-            m_server->get_con_from_hdl(handle);
+    server_type::connection_ptr connection = get_connection(handle);
+
+    // Extensions are negotiated just before the connection is validated. If
+    // permessage-deflate was accepted then claim its byte counters so that
+    // they can be reported for the connection and the server.
+    std::shared_ptr<websocket_compression_stats> compression_stats =
+            websocket_permessage_deflate_context::take_negotiated_stats();
+    if (compression_stats &&
+            !connection->get_response_header("Sec-WebSocket-Extensions").empty()) {
+        compression_stats->set_totals(m_compression_stats);
+        connection->set_compression_stats(compression_stats);
+    }
 
     const auto& subprotocols = connection->get_requested_subprotocols();
     for (const auto& subprotocol : subprotocols) {
-        if (subprotocol == WAMPV2_MSGPACK_SUBPROTOCOL) {
-            if (m_serializers->has_serializer(wamp_serializer_type::MSGPACK)) {
-                connection->select_subprotocol(subprotocol);
-                return true;
-            }
+        wamp_serializer_type serializer_type;
+        const websocket_subprotocol subprotocol_type = subprotocol_from_string(subprotocol);
+        if (subprotocol_type == websocket_subprotocol::MSGPACK ||
+                subprotocol_type == websocket_subprotocol::MSGPACK_BATCHED) {
+            serializer_type = wamp_serializer_type::MSGPACK;
+        } else if (subprotocol_type == websocket_subprotocol::JSON ||
+                subprotocol_type == websocket_subprotocol::JSON_BATCHED) {
+            serializer_type = wamp_serializer_type::JSON;
+        } else {
+            continue;
         }
 
-        if (subprotocol == WAMPV2_JSON_SUBPROTOCOL) {
-            if (m_serializers->has_serializer(wamp_serializer_type::JSON)) {
-                connection->select_subprotocol(subprotocol);
-                return true;
-            }
+        // Resolve the serializer once up front so that the subprotocol does
+        // not have to be inspected again for each message that is received.
+        if (m_serializers->has_serializer(serializer_type)) {
+            connection->select_subprotocol(subprotocol);
+            connection->set_subprotocol(subprotocol_type);
+            connection->set_serializer(m_serializers->get_serializer(serializer_type));
+            return true;
         }
     }
 
@@ -195,28 +316,38 @@ bool websocket_server_impl::on_validate(websocketpp::connection_hdl handle)
     return false;
 }
 
-void websocket_server_impl::on_message(websocketpp::connection_hdl handle,
-        websocketpp::server<websocket_config>::message_ptr buffer)
+void websocket_server_impl::on_message(const std::shared_ptr<server_type>& server,
+        websocketpp::connection_hdl handle, server_type::message_ptr buffer)
 {
-    websocketpp::server<websocket_config>::connection_ptr connection =
-            m_server->get_con_from_hdl(handle);
-    std::shared_ptr<wamp_serializer> serializer;
-
-    if (connection->get_subprotocol() == WAMPV2_MSGPACK_SUBPROTOCOL) {
-        serializer = m_serializers->get_serializer(wamp_serializer_type::MSGPACK);
-    } else if (connection->get_subprotocol() == WAMPV2_JSON_SUBPROTOCOL) {
-        serializer = m_serializers->get_serializer(wamp_serializer_type::JSON);
-    }
+    server_type::connection_ptr connection = get_connection(handle);
+    const std::shared_ptr<wamp_serializer>& serializer = connection->get_serializer();
+    const bool remote = &server->get_io_service() != &m_io_service;
 
     try {
-        std::unique_ptr<wamp_message> message(
-                serializer->deserialize(buffer->get_payload().c_str(), buffer->get_payload().size()));
-        std::unique_ptr<wamp_transport> transport(
-                new websocket_transport(serializer, handle, m_server));
-
-        if (message) {
-            m_message_processor.process_message(message, std::move(transport), connection.get());
+        // The payload is handed over to the decoded messages rather than
+        // copied out of. The pooled websocket message is only reused once
+        // every message referencing its payload has been released.
+        const std::shared_ptr<const void> owner(buffer);
+        const std::string& payload = buffer->get_payload();
+        const websocket_subprotocol subprotocol = connection->get_subprotocol_type();
+        if (!is_batched_subprotocol(subprotocol)) {
+            std::unique_ptr<wamp_message> message(
+                    serializer->deserialize_referenced(payload.data(), payload.size(), owner));
+
+            if (message) {
+                dispatch_message(connection, std::move(message), remote);
+            }
+            return;
         }
+
+        websocket_batch::split(subprotocol, payload.data(), payload.size(),
+                [&](const char* data, std::size_t length) {
+            std::unique_ptr<wamp_message> message(
+                    serializer->deserialize_referenced(data, length, owner));
+            if (message) {
+                dispatch_message(connection, std::move(message), remote);
+            }
+        });
     } catch (const std::exception& e) {
         BONEFISH_TRACE("unhandled exception: %1%", e.what());
     }
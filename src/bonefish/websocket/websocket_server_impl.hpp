@@ -18,6 +18,8 @@
 #define BONEFISH_WEBSOCKET_WEBSOCKET_SERVER_IMPL_HPP
 
 #include <bonefish/common/wamp_message_processor.hpp>
+#include <bonefish/websocket/websocket_compression_options.hpp>
+#include <bonefish/websocket/websocket_compression_stats.hpp>
 #include <bonefish/websocket/websocket_config.hpp>
 
 #include <boost/asio/io_service.hpp>
@@ -26,10 +28,12 @@
 #include <cstdint>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 #include <websocketpp/server.hpp>
 
 namespace bonefish {
 
+class wamp_message;
 class wamp_routers;
 class wamp_serializers;
 
@@ -38,27 +42,51 @@ class websocket_server_impl : public std::enable_shared_from_this<websocket_serv
 public:
     websocket_server_impl(boost::asio::io_service& io_service,
             const std::shared_ptr<wamp_routers>& routers,
-            const std::shared_ptr<wamp_serializers>& serializers);
+            const std::shared_ptr<wamp_serializers>& serializers,
+            const websocket_compression_options& compression_options);
     ~websocket_server_impl();
 
     void start(const boost::asio::ip::address& ip_address, uint16_t port);
+    void start(const boost::asio::ip::address& ip_address, uint16_t port,
+            const std::vector<boost::asio::io_service*>& io_services);
     void shutdown();
 
+    const websocket_compression_stats& get_compression_stats() const;
+
 private:
+    typedef websocketpp::server<websocket_config> server_type;
+
+    std::shared_ptr<server_type> create_server(boost::asio::io_service& io_service,
+            bool reuse_port);
+    server_type::connection_ptr get_connection(websocketpp::connection_hdl handle);
+    void dispatch_message(const server_type::connection_ptr& connection,
+            std::unique_ptr<wamp_message>&& message, bool remote);
+
     void on_socket_init(websocketpp::connection_hdl handle,
             boost::asio::ip::tcp::socket& socket);
-    void on_open(websocketpp::connection_hdl handle);
+    void on_open(const std::shared_ptr<server_type>& server,
+            websocketpp::connection_hdl handle);
     void on_close(websocketpp::connection_hdl handle);
     void on_fail(websocketpp::connection_hdl handle);
     bool on_validate(websocketpp::connection_hdl handle);
-    void on_message(websocketpp::connection_hdl handle,
-            websocketpp::server<websocket_config>::message_ptr message);
+    void on_message(const std::shared_ptr<server_type>& server,
+            websocketpp::connection_hdl handle, server_type::message_ptr message);
+
+    void detach_connection(const server_type::connection_ptr& connection);
 
 private:
     boost::asio::io_service& m_io_service;
-    std::shared_ptr<websocketpp::server<websocket_config>> m_server;
+
+    /// One server per io service that accepts connections. Each server
+    /// listens on its own SO_REUSEPORT acceptor.
+    std::vector<std::shared_ptr<server_type>> m_servers;
     std::shared_ptr<wamp_routers> m_routers;
     std::shared_ptr<wamp_serializers> m_serializers;
+    websocket_compression_options m_compression_options;
+
+    /// The compression byte counters of all connections that negotiated
+    /// permessage-deflate since the server was created.
+    std::shared_ptr<websocket_compression_stats> m_compression_stats;
     wamp_message_processor m_message_processor;
 };
 
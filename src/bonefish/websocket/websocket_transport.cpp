@@ -20,17 +20,27 @@
 #include <bonefish/serialization/expandable_buffer.hpp>
 #include <bonefish/serialization/wamp_serializer.hpp>
 #include <bonefish/trace/trace.hpp>
+#include <bonefish/transport/wamp_fanout_message.hpp>
 
 #include <iostream>
 
 namespace bonefish {
 
-websocket_transport::websocket_transport(const std::shared_ptr<wamp_serializer>& serializer,
+websocket_transport::websocket_transport(boost::asio::io_service& io_service,
+        const std::shared_ptr<wamp_serializer>& serializer,
         const websocketpp::connection_hdl& handle,
-        const std::shared_ptr<websocketpp::server<websocket_config>>& server)
-    : m_serializer(serializer)
+        const std::shared_ptr<websocketpp::server<websocket_config>>& server,
+        websocket_subprotocol subprotocol,
+        std::size_t min_compressed_size)
+    : m_io_service(io_service)
+    , m_serializer(serializer)
     , m_handle(handle)
     , m_server(server)
+    , m_connection_io_service(server->get_io_service())
+    , m_min_compressed_size(min_compressed_size)
+    , m_batched(is_batched_subprotocol(subprotocol))
+    , m_batch(m_batched ? new websocket_batch(subprotocol) : nullptr)
+    , m_flush_pending(false)
 {
 }
 
@@ -38,12 +48,221 @@ bool websocket_transport::send_message(wamp_message&& message)
 {
     BONEFISH_TRACE("sending message: %1%", message_type_to_string(message.get_type()));
     expandable_buffer buffer = m_serializer->serialize(message);
-    auto opcode = (m_serializer->get_type() == wamp_serializer_type::JSON)
-            ? websocketpp::frame::opcode::TEXT
-            : websocketpp::frame::opcode::BINARY;
-    m_server->send(m_handle, buffer.data(), buffer.size(), opcode);
+    if (!m_batched) {
+        return send_payload(buffer.data(), buffer.size());
+    }
+
+    // Messages that open or close a session are flushed right away so that
+    // the router learns whether they were actually sent.
+    const wamp_message_type type = message.get_type();
+    const bool flush_now = type == wamp_message_type::WELCOME ||
+            type == wamp_message_type::ABORT ||
+            type == wamp_message_type::CHALLENGE ||
+            type == wamp_message_type::GOODBYE;
+
+    return send_batched(buffer.data(), buffer.size(), flush_now);
+}
+
+bool websocket_transport::send_fanout_message(wamp_fanout_message& message)
+{
+    BONEFISH_TRACE("sending message: %1%", message_type_to_string(message.get_message().get_type()));
+    const expandable_buffer& buffer = message.serialize(*m_serializer);
+    if (m_batched) {
+        return send_batched(buffer.data(), buffer.size(), false);
+    }
+
+    websocketpp::lib::error_code ec;
+    auto connection = m_server->get_con_from_hdl(m_handle, ec);
+    if (ec) {
+        BONEFISH_TRACE("failed to send message: %1%", ec.message());
+        return false;
+    }
+
+    // Hixie-76 connections use an entirely different framing so they
+    // cannot share the prepared hybi frame. Connections that negotiated
+    // permessage-deflate compress large messages with their own deflate
+    // context so those messages cannot share the uncompressed frame either.
+    if (connection->get_version() < 7 ||
+            (connection->get_compression_stats() && buffer.size() >= m_min_compressed_size)) {
+        return send_payload(buffer.data(), buffer.size());
+    }
+
+    const wamp_serializer_type type = m_serializer->get_type();
+    auto frame = std::static_pointer_cast<message_ptr::element_type>(message.get_frame(type));
+    if (!frame) {
+        // Shared frames are never compressed as the compressed form depends
+        // on the deflate context of each individual connection. Only messages
+        // below the compression threshold share frames on such connections.
+        // A connection's message pool may only be used by the thread that
+        // services the connection so frames built on any other thread are
+        // allocated on their own.
+        const auto opcode = get_opcode();
+        if (is_remote()) {
+            frame = std::make_shared<message_ptr::element_type>(nullptr, opcode, buffer.size());
+        } else {
+            frame = connection->get_message(opcode, buffer.size());
+        }
+        frame->append_payload(buffer.data(), buffer.size());
+        frame->set_header(websocketpp::frame::prepare_header(
+                websocketpp::frame::basic_header(opcode, buffer.size(), true, false),
+                websocketpp::frame::extended_header(buffer.size())));
+        frame->set_prepared(true);
+        message.set_frame(type, frame);
+    }
+
+    if (!is_remote()) {
+        return write_frame(frame);
+    }
+
+    return post_send([this, frame]() {
+        return write_frame(frame);
+    });
+}
+
+bool websocket_transport::send_batched(const char* data, std::size_t length, bool flush_now)
+{
+    m_batch->append(data, length);
+    if (flush_now || m_batch->size() >= MAX_BATCH_SIZE) {
+        return flush();
+    }
+
+    // Defer sending the batch until the current event has been handled so
+    // that any other messages sent in the meantime share the same frame.
+    // By then the senders have been told that their messages were sent so
+    // a failed flush closes the connection which detaches its session.
+    if (!m_flush_pending) {
+        m_flush_pending = true;
+        std::weak_ptr<websocket_transport> weak_self = shared_from_this();
+        m_io_service.post([weak_self]() {
+            auto shared_self = weak_self.lock();
+            if (shared_self && !shared_self->flush()) {
+                shared_self->close_connection();
+            }
+        });
+    }
+
+    return true;
+}
+
+bool websocket_transport::flush()
+{
+    m_flush_pending = false;
+    if (!m_batch || m_batch->empty()) {
+        return true;
+    }
+
+    const std::string& data = m_batch->get_data();
+    bool sent = send_payload(data.data(), data.size());
+    m_batch->clear();
+
+    return sent;
+}
+
+bool websocket_transport::send_payload(const char* data, std::size_t length)
+{
+    if (!is_remote()) {
+        return write_payload(data, length);
+    }
+
+    auto payload = std::make_shared<std::string>(data, length);
+    return post_send([this, payload]() {
+        return write_payload(payload->data(), payload->size());
+    });
+}
+
+bool websocket_transport::post_send(const std::function<bool()>& send)
+{
+    // The connection belongs to another thread so the send is handed over
+    // to it. Sends are posted in order to an io service that is run by a
+    // single thread so they also go out in order. A failure can no longer
+    // be reported to the sender and closes the connection instead.
+    std::weak_ptr<websocket_transport> weak_self = shared_from_this();
+    m_connection_io_service.post([weak_self, send]() {
+        auto shared_self = weak_self.lock();
+        if (shared_self && !send()) {
+            shared_self->close_connection();
+        }
+    });
+
+    return true;
+}
+
+bool websocket_transport::write_frame(const message_ptr& frame)
+{
+    websocketpp::lib::error_code ec;
+    auto connection = m_server->get_con_from_hdl(m_handle, ec);
+    if (ec) {
+        BONEFISH_TRACE("failed to send message: %1%", ec.message());
+        return false;
+    }
+
+    ec = connection->send(frame);
+    if (ec) {
+        BONEFISH_TRACE("failed to send message: %1%", ec.message());
+        return false;
+    }
+
+    return true;
+}
+
+bool websocket_transport::write_payload(const char* data, std::size_t length)
+{
+    websocketpp::lib::error_code ec;
+    auto connection = m_server->get_con_from_hdl(m_handle, ec);
+    if (ec) {
+        BONEFISH_TRACE("failed to send message: %1%", ec.message());
+        return false;
+    }
+
+    // Small messages rarely compress well enough to be worth the cost so
+    // they are sent as is even if permessage-deflate has been negotiated.
+    auto payload = connection->get_message(get_opcode(), length);
+    payload->append_payload(data, length);
+    payload->set_compressed(length >= m_min_compressed_size);
+
+    ec = connection->send(payload);
+    if (ec) {
+        BONEFISH_TRACE("failed to send message: %1%", ec.message());
+        return false;
+    }
 
     return true;
 }
 
+void websocket_transport::close_connection()
+{
+    // Connections are only ever closed by the thread that services them.
+    std::weak_ptr<websocket_transport> weak_self = shared_from_this();
+    m_connection_io_service.dispatch([weak_self]() {
+        auto shared_self = weak_self.lock();
+        if (!shared_self) {
+            return;
+        }
+
+        websocketpp::lib::error_code ec;
+        auto connection = shared_self->m_server->get_con_from_hdl(shared_self->m_handle, ec);
+        if (ec) {
+            return;
+        }
+
+        connection->close(websocketpp::close::status::internal_endpoint_error,
+                "failed to send message", ec);
+        if (ec) {
+            BONEFISH_TRACE("failed to close connection: %1%", ec.message());
+        }
+    });
+}
+
+bool websocket_transport::is_remote() const
+{
+    return &m_connection_io_service != &m_io_service;
+}
+
+websocketpp::frame::opcode::value websocket_transport::get_opcode() const
+{
+    return (m_serializer->get_type() == wamp_serializer_type::JSON)
+            ? websocketpp::frame::opcode::TEXT
+            : websocketpp::frame::opcode::BINARY;
+}
+
 } // namespace bonefish
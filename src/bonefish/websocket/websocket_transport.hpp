@@ -18,9 +18,15 @@
 #define BONEFISH_WEBSOCKET_TRANSPORT_HPP
 
 #include <bonefish/transport/wamp_transport.hpp>
+#include <bonefish/websocket/websocket_batch.hpp>
 #include <bonefish/websocket/websocket_config.hpp>
+#include <bonefish/websocket/websocket_protocol.hpp>
 
+#include <boost/asio/io_service.hpp>
+#include <cstddef>
+#include <functional>
 #include <memory>
+#include <string>
 #include <websocketpp/common/connection_hdl.hpp>
 #include <websocketpp/server.hpp>
 
@@ -29,19 +35,68 @@ namespace bonefish {
 class wamp_message;
 class wamp_serializer;
 
-class websocket_transport : public wamp_transport
+class websocket_transport :
+        public wamp_transport,
+        public std::enable_shared_from_this<websocket_transport>
 {
 public:
-    websocket_transport(const std::shared_ptr<wamp_serializer>& serializer,
+    /// The io service is the one that messages are sent from. Batches are
+    /// flushed on it once the event that queued them has been handled. If
+    /// the connection is serviced by the io service of another thread then
+    /// sends are handed over to that thread.
+    websocket_transport(boost::asio::io_service& io_service,
+            const std::shared_ptr<wamp_serializer>& serializer,
             const websocketpp::connection_hdl& handle,
-            const std::shared_ptr<websocketpp::server<websocket_config>>& server);
+            const std::shared_ptr<websocketpp::server<websocket_config>>& server,
+            websocket_subprotocol subprotocol,
+            std::size_t min_compressed_size);
 
     virtual bool send_message(wamp_message&& message) override;
 
+    /// Sends a message that is shared with other websocket transports. The
+    /// frame is built once and the same websocketpp message is queued on
+    /// every connection as server to client frames are never masked.
+    /// Messages that this connection would compress are sent on their own.
+    virtual bool send_fanout_message(wamp_fanout_message& message) override;
+
+    /// Sends any messages that have been queued for a batched subprotocol.
+    bool flush();
+
+private:
+    typedef websocketpp::server<websocket_config>::message_ptr message_ptr;
+
+    bool send_payload(const char* data, std::size_t length);
+    bool send_batched(const char* data, std::size_t length, bool flush_now);
+    bool post_send(const std::function<bool()>& send);
+    bool write_frame(const message_ptr& frame);
+    bool write_payload(const char* data, std::size_t length);
+    void close_connection();
+    bool is_remote() const;
+    websocketpp::frame::opcode::value get_opcode() const;
+
 private:
+    /// Batches are flushed immediately once they grow beyond this size
+    /// rather than waiting for the deferred flush.
+    static const std::size_t MAX_BATCH_SIZE = 64 * 1024;
+
+    boost::asio::io_service& m_io_service;
     std::shared_ptr<wamp_serializer> m_serializer;
     websocketpp::connection_hdl m_handle;
     std::shared_ptr<websocketpp::server<websocket_config>> m_server;
+
+    /// The io service of the thread that services the connection.
+    boost::asio::io_service& m_connection_io_service;
+
+    /// Messages smaller than this are never handed to the compressor.
+    std::size_t m_min_compressed_size;
+
+    /// Whether or not messages are packed into batches before being sent.
+    bool m_batched;
+
+    /// Messages queued for the next batch. All of the messages that are sent
+    /// while handling a single event are packed into one websocket frame.
+    std::unique_ptr<websocket_batch> m_batch;
+    bool m_flush_pending;
 };
 
 } // namespace bonefish
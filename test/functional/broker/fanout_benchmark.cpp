@@ -0,0 +1,116 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+// Measures the cost of walking the subscribers of a topic the way the
+// broker does when it fans out an event. The previous layout, a hash set
+// of shared session pointers, is compared against the dense subscriber
+// array that the broker uses now. Both walks touch each session exactly
+// like the fan-out loop does so that only the container layout differs.
+//
+// Usage: fanout_benchmark [subscribers] [iterations]
+
+#include <bonefish/broker/wamp_broker_subscribers.hpp>
+#include <bonefish/identifiers/wamp_session_id.hpp>
+#include <bonefish/session/wamp_session.hpp>
+#include <bonefish/session/wamp_session_slot.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+template <typename Walk>
+double measure(std::size_t subscribers, std::size_t iterations, Walk walk)
+{
+    // One untimed pass so that both layouts start out equally warm.
+    std::uintptr_t checksum = walk();
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        checksum += walk();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start);
+
+    // Keeps the compiler from optimizing the walks away.
+    if (checksum == 1) {
+        std::cerr << "unexpected checksum" << std::endl;
+    }
+
+    return static_cast<double>(elapsed.count()) / (iterations * subscribers);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const std::size_t subscribers = argc > 1 ? std::stoul(argv[1]) : 10000;
+    const std::size_t iterations = argc > 2 ? std::stoul(argv[2]) : 1000;
+
+    // Sessions are allocated up front and subscribed in a random order
+    // which mirrors sessions subscribing over the lifetime of the router.
+    std::vector<std::shared_ptr<bonefish::wamp_session>> sessions;
+    sessions.reserve(subscribers);
+    for (std::size_t i = 0; i < subscribers; ++i) {
+        std::shared_ptr<bonefish::wamp_session> session = std::make_shared<bonefish::wamp_session>(
+                bonefish::wamp_session_id(), "bonefish.benchmark", nullptr);
+        session->set_slot(bonefish::wamp_session_slot(static_cast<uint32_t>(i), 0));
+        sessions.push_back(session);
+    }
+    std::shuffle(sessions.begin(), sessions.end(), std::mt19937(42));
+
+    std::unordered_set<std::shared_ptr<bonefish::wamp_session>> hash_set;
+    bonefish::wamp_broker_subscribers dense;
+    for (const auto& session : sessions) {
+        hash_set.insert(session);
+        dense.add_session(session.get());
+    }
+
+    const double before = measure(subscribers, iterations, [&]() {
+        std::uintptr_t checksum = 0;
+        for (const auto& subscriber : hash_set) {
+            checksum += reinterpret_cast<std::uintptr_t>(subscriber->get_transport().get());
+            checksum += subscriber->get_slot().index();
+        }
+        return checksum;
+    });
+
+    const double after = measure(subscribers, iterations, [&]() {
+        std::uintptr_t checksum = 0;
+        for (bonefish::wamp_session* subscriber : dense.get_sessions()) {
+            checksum += reinterpret_cast<std::uintptr_t>(subscriber->get_transport().get());
+            checksum += subscriber->get_slot().index();
+        }
+        return checksum;
+    });
+
+    std::cout << "subscribers: " << subscribers << std::endl;
+    std::cout << "iterations: " << iterations << std::endl;
+    std::cout << "unordered_set<shared_ptr>: " << before << " ns/subscriber" << std::endl;
+    std::cout << "dense array: " << after << " ns/subscriber" << std::endl;
+    std::cout << "speedup: " << before / after << "x" << std::endl;
+
+    return 0;
+}
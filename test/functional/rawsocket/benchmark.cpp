@@ -0,0 +1,468 @@
+/**
+ *  Copyright (C) 2015 Topology LP
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+// Measures the round trip latency and the throughput of the rawsocket
+// transports by publishing to a topic that the benchmark itself subscribes
+// to. The broker delivers each event back to its publisher so every message
+// crosses the transport in both directions.
+//
+// Usage: benchmark <realm> <tcp|uds|seqpacket|shm> <port|path> [messages] [payload-size]
+
+#include <bonefish/rawsocket/shm_segment.hpp>
+
+#include <arpa/inet.h>
+#include <boost/asio/connect.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <msgpack.hpp>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+const unsigned HELLO = 1;
+const unsigned WELCOME = 2;
+const unsigned GOODBYE = 6;
+const unsigned PUBLISH = 16;
+const unsigned SUBSCRIBE = 32;
+const unsigned SUBSCRIBED = 33;
+const unsigned EVENT = 36;
+
+const char* TOPIC = "bonefish.benchmark";
+
+// The number of publications that are in flight at once while measuring
+// the throughput.
+const std::size_t WINDOW = 64;
+
+// The largest datagram sent over a seqpacket socket. This has to match the
+// size that the router receives.
+const std::size_t MAX_DATAGRAM_SIZE = 64 * 1024;
+
+class stream
+{
+public:
+    virtual ~stream() = default;
+    virtual void write(const void* data, std::size_t length) = 0;
+    virtual void read(void* data, std::size_t length) = 0;
+
+    virtual void write_message(const char* data, std::size_t length)
+    {
+        std::uint32_t length_prefix = htonl(static_cast<std::uint32_t>(length));
+        write(&length_prefix, sizeof(length_prefix));
+        write(data, length);
+    }
+
+    virtual void read_message(std::vector<char>& buffer)
+    {
+        std::uint32_t length_prefix = 0;
+        read(&length_prefix, sizeof(length_prefix));
+        buffer.resize(ntohl(length_prefix));
+        read(buffer.data(), buffer.size());
+    }
+};
+
+template <typename Socket>
+class socket_stream : public stream
+{
+public:
+    explicit socket_stream(Socket&& socket)
+        : m_socket(std::move(socket))
+    {
+    }
+
+    virtual void write(const void* data, std::size_t length) override
+    {
+        boost::asio::write(m_socket, boost::asio::buffer(data, length));
+    }
+
+    virtual void read(void* data, std::size_t length) override
+    {
+        boost::asio::read(m_socket, boost::asio::buffer(data, length));
+    }
+
+private:
+    Socket m_socket;
+};
+
+// Exchanges each message as a single datagram. Messages larger than a
+// datagram are preceded by a chunk header and split into several datagrams.
+class seqpacket_stream : public stream
+{
+public:
+    explicit seqpacket_stream(const std::string& path)
+        : m_socket(::socket(AF_UNIX, SOCK_SEQPACKET, 0))
+    {
+        sockaddr_un address = sockaddr_un();
+        address.sun_family = AF_UNIX;
+        path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+        if (m_socket < 0 || ::connect(m_socket,
+                reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            throw std::runtime_error("failed to connect seqpacket socket");
+        }
+    }
+
+    virtual ~seqpacket_stream() override
+    {
+        ::close(m_socket);
+    }
+
+    virtual void write(const void* data, std::size_t length) override
+    {
+        if (::send(m_socket, data, length, MSG_NOSIGNAL) != static_cast<ssize_t>(length)) {
+            throw std::runtime_error("failed to send datagram");
+        }
+    }
+
+    virtual void read(void* data, std::size_t length) override
+    {
+        if (::recv(m_socket, data, length, 0) != static_cast<ssize_t>(length)) {
+            throw std::runtime_error("failed to receive datagram");
+        }
+    }
+
+    virtual void write_message(const char* data, std::size_t length) override
+    {
+        if (length <= MAX_DATAGRAM_SIZE) {
+            write(data, length);
+            return;
+        }
+
+        char chunk_header[8] = { 0 };
+        std::uint32_t message_length = htonl(static_cast<std::uint32_t>(length));
+        std::memcpy(chunk_header + 4, &message_length, sizeof(message_length));
+        write(chunk_header, sizeof(chunk_header));
+        for (std::size_t offset = 0; offset < length; offset += MAX_DATAGRAM_SIZE) {
+            write(data + offset, std::min(length - offset, MAX_DATAGRAM_SIZE));
+        }
+    }
+
+    virtual void read_message(std::vector<char>& buffer) override
+    {
+        buffer.resize(MAX_DATAGRAM_SIZE);
+        ssize_t received = ::recv(m_socket, buffer.data(), buffer.size(), 0);
+        if (received <= 0) {
+            throw std::runtime_error("failed to receive datagram");
+        }
+
+        if (received != 8 || buffer[0] != 0) {
+            buffer.resize(received);
+            return;
+        }
+
+        std::uint32_t message_length = 0;
+        std::memcpy(&message_length, buffer.data() + 4, sizeof(message_length));
+        buffer.resize(ntohl(message_length));
+        for (std::size_t offset = 0; offset < buffer.size(); offset += received) {
+            received = ::recv(m_socket, buffer.data() + offset, buffer.size() - offset, 0);
+            if (received <= 0) {
+                throw std::runtime_error("failed to receive datagram");
+            }
+        }
+    }
+
+private:
+    int m_socket;
+};
+
+class shm_stream : public stream
+{
+public:
+    explicit shm_stream(boost::asio::local::stream_protocol::socket&& socket)
+        : m_socket(std::move(socket))
+        , m_segment()
+    {
+        m_segment.receive(m_socket.native_handle());
+    }
+
+    virtual void write(const void* data, std::size_t length) override
+    {
+        const char* buffer = static_cast<const char*>(data);
+        bonefish::shm_channel& upstream = m_segment.get_upstream();
+        while (length != 0) {
+            std::size_t count = upstream.write(buffer, length);
+            buffer += count;
+            length -= count;
+            if (length != 0 && upstream.get_ring().prepare_writer_wait()) {
+                wait(upstream.get_space_event());
+            }
+        }
+    }
+
+    virtual void read(void* data, std::size_t length) override
+    {
+        char* buffer = static_cast<char*>(data);
+        bonefish::shm_channel& downstream = m_segment.get_downstream();
+        while (length != 0) {
+            std::size_t count = downstream.read(buffer, length);
+            buffer += count;
+            length -= count;
+            if (length != 0 && downstream.get_ring().prepare_reader_wait()) {
+                wait(downstream.get_data_event());
+            }
+        }
+    }
+
+private:
+    void wait(int event)
+    {
+        pollfd descriptors[2];
+        descriptors[0].fd = event;
+        descriptors[0].events = POLLIN;
+        descriptors[0].revents = 0;
+        descriptors[1].fd = m_socket.native_handle();
+        descriptors[1].events = 0;
+        descriptors[1].revents = 0;
+
+        if (poll(descriptors, 2, -1) == -1) {
+            throw std::runtime_error("poll failed");
+        }
+        if (descriptors[1].revents & (POLLHUP | POLLERR)) {
+            throw std::runtime_error("router closed the connection");
+        }
+        if (descriptors[0].revents & POLLIN) {
+            bonefish::shm_channel::clear_event(event);
+        }
+    }
+
+private:
+    boost::asio::local::stream_protocol::socket m_socket;
+    bonefish::shm_segment m_segment;
+};
+
+class client
+{
+public:
+    explicit client(std::unique_ptr<stream>&& stream)
+        : m_stream(std::move(stream))
+        , m_buffer()
+    {
+    }
+
+    void handshake()
+    {
+        // Request msgpack serialization with the largest message length.
+        std::uint32_t capabilities = htonl(0x7FF20000);
+        m_stream->write(&capabilities, sizeof(capabilities));
+        m_stream->read(&capabilities, sizeof(capabilities));
+        if ((ntohl(capabilities) & 0xFF0F0000) != 0x7F020000) {
+            throw std::runtime_error("rawsocket handshake failed");
+        }
+    }
+
+    void send(const msgpack::sbuffer& message)
+    {
+        m_stream->write_message(message.data(), message.size());
+    }
+
+    msgpack::unpacked receive()
+    {
+        m_stream->read_message(m_buffer);
+        return msgpack::unpack(m_buffer.data(), m_buffer.size());
+    }
+
+    msgpack::unpacked receive(unsigned expected_type)
+    {
+        msgpack::unpacked message = receive();
+        const msgpack::object& fields = message.get();
+        if (fields.type != msgpack::type::ARRAY || fields.via.array.size == 0 ||
+                fields.via.array.ptr[0].as<unsigned>() != expected_type) {
+            throw std::runtime_error("unexpected message received");
+        }
+        return message;
+    }
+
+private:
+    std::unique_ptr<stream> m_stream;
+    std::vector<char> m_buffer;
+};
+
+msgpack::sbuffer make_hello(const std::string& realm)
+{
+    msgpack::sbuffer buffer;
+    msgpack::packer<msgpack::sbuffer> packer(&buffer);
+    packer.pack_array(3);
+    packer.pack(HELLO);
+    packer.pack(realm);
+    packer.pack_map(1);
+    packer.pack(std::string("roles"));
+    packer.pack_map(2);
+    packer.pack(std::string("publisher"));
+    packer.pack_map(0);
+    packer.pack(std::string("subscriber"));
+    packer.pack_map(0);
+    return buffer;
+}
+
+msgpack::sbuffer make_subscribe()
+{
+    msgpack::sbuffer buffer;
+    msgpack::packer<msgpack::sbuffer> packer(&buffer);
+    packer.pack_array(4);
+    packer.pack(SUBSCRIBE);
+    packer.pack(1);
+    packer.pack_map(0);
+    packer.pack(std::string(TOPIC));
+    return buffer;
+}
+
+msgpack::sbuffer make_publish(std::uint64_t request_id, const std::string& payload)
+{
+    msgpack::sbuffer buffer;
+    msgpack::packer<msgpack::sbuffer> packer(&buffer);
+    packer.pack_array(5);
+    packer.pack(PUBLISH);
+    packer.pack(request_id);
+    packer.pack_map(0);
+    packer.pack(std::string(TOPIC));
+    packer.pack_array(1);
+    packer.pack(payload);
+    return buffer;
+}
+
+msgpack::sbuffer make_goodbye()
+{
+    msgpack::sbuffer buffer;
+    msgpack::packer<msgpack::sbuffer> packer(&buffer);
+    packer.pack_array(3);
+    packer.pack(GOODBYE);
+    packer.pack_map(0);
+    packer.pack(std::string("wamp.close.normal"));
+    return buffer;
+}
+
+std::unique_ptr<stream> connect(
+        boost::asio::io_service& io_service, const std::string& transport, const std::string& address)
+{
+    if (transport == "tcp") {
+        boost::asio::ip::tcp::socket socket(io_service);
+        socket.connect(boost::asio::ip::tcp::endpoint(
+                boost::asio::ip::address_v4::loopback(),
+                static_cast<unsigned short>(std::stoul(address))));
+        socket.set_option(boost::asio::ip::tcp::no_delay(true));
+        return std::unique_ptr<stream>(
+                new socket_stream<boost::asio::ip::tcp::socket>(std::move(socket)));
+    }
+
+    if (transport == "seqpacket") {
+        return std::unique_ptr<stream>(new seqpacket_stream(address));
+    }
+
+    boost::asio::local::stream_protocol::socket socket(io_service);
+    socket.connect(boost::asio::local::stream_protocol::endpoint(address));
+    if (transport == "uds") {
+        return std::unique_ptr<stream>(
+                new socket_stream<boost::asio::local::stream_protocol::socket>(std::move(socket)));
+    }
+    if (transport == "shm") {
+        return std::unique_ptr<stream>(new shm_stream(std::move(socket)));
+    }
+
+    throw std::invalid_argument("unknown transport: " + transport);
+}
+
+double to_microseconds(std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(duration).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 4) {
+        std::cerr << "usage: " << argv[0]
+                << " <realm> <tcp|uds|seqpacket|shm> <port|path> [messages] [payload-size]" << std::endl;
+        return 1;
+    }
+
+    const std::string realm = argv[1];
+    const std::string transport = argv[2];
+    const std::string address = argv[3];
+    const std::size_t messages = argc > 4 ? std::stoul(argv[4]) : 100000;
+    const std::string payload(argc > 5 ? std::stoul(argv[5]) : 64, 'x');
+
+    try {
+        boost::asio::io_service io_service;
+        client session(connect(io_service, transport, address));
+        session.handshake();
+        session.send(make_hello(realm));
+        session.receive(WELCOME);
+        session.send(make_subscribe());
+        session.receive(SUBSCRIBED);
+
+        // Latency: a single publication is in flight at any time.
+        std::vector<double> latencies;
+        latencies.reserve(messages);
+        for (std::size_t i = 0; i < messages; ++i) {
+            msgpack::sbuffer publish = make_publish(i + 1, payload);
+            auto start = std::chrono::steady_clock::now();
+            session.send(publish);
+            session.receive(EVENT);
+            latencies.push_back(to_microseconds(std::chrono::steady_clock::now() - start));
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&latencies](double p) {
+            return latencies[std::min(latencies.size() - 1,
+                    static_cast<std::size_t>(p * latencies.size()))];
+        };
+
+        // Throughput: publications are pipelined up to the window size.
+        msgpack::sbuffer publish = make_publish(messages + 1, payload);
+        std::size_t sent = 0;
+        std::size_t received = 0;
+        auto start = std::chrono::steady_clock::now();
+        while (received < messages) {
+            while (sent < messages && sent - received < WINDOW) {
+                session.send(publish);
+                ++sent;
+            }
+            session.receive(EVENT);
+            ++received;
+        }
+        const double elapsed = to_microseconds(std::chrono::steady_clock::now() - start);
+
+        session.send(make_goodbye());
+        session.receive(GOODBYE);
+
+        std::cout << transport << ": " << messages << " messages, "
+                << payload.size() << " byte payload" << std::endl
+                << "  latency us: p50 " << percentile(0.50)
+                << ", p99 " << percentile(0.99)
+                << ", max " << latencies.back() << std::endl
+                << "  throughput: " << (messages * 1e6 / elapsed) << " messages/s" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "benchmark failed: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
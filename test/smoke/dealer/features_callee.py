@@ -0,0 +1,137 @@
+###############################################################################
+#
+# The MIT License (MIT)
+#
+# Copyright (c) Tavendo GmbH
+# Copyright (c) Topology LP
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+#
+###############################################################################
+
+import sys
+
+from twisted.python import log
+from twisted.internet import reactor, task
+from twisted.internet.defer import inlineCallbacks, returnValue
+from twisted.internet.endpoints import clientFromString
+
+from autobahn.twisted import wamp, websocket
+from autobahn.wamp import types
+from autobahn.wamp.serializer import *
+
+class RegisterOptions(types.RegisterOptions):
+    """
+    Register options that pass along the dealer specific options
+    that autobahn does not know about.
+    """
+
+    def __init__(self, **options):
+        types.RegisterOptions.__init__(self)
+        self.options = options
+
+    def message_attr(self):
+        attr = types.RegisterOptions.message_attr(self)
+        attr.update(self.options)
+        return attr
+
+class Component(wamp.ApplicationSession):
+    """
+    Component that joins the router and registers the procedures
+    used by the dealer feature scenarios. Two of these components
+    are started. The fast one answers right away whereas the slow
+    one takes its time:
+
+          io.bonefish.test.sleep
+          io.bonefish.test.coalesced
+          io.bonefish.test.fanout
+          io.bonefish.test.queued
+          io.bonefish.test.disconnect
+
+    See README.md
+    """
+
+    invocations = 0
+
+    @inlineCallbacks
+    def onJoin(self, details):
+        self.name = self.config.extra['name']
+        if self.name == 'fast':
+            yield self.register(self.sleep, u'io.bonefish.test.sleep')
+            yield self.register(self.coalesced, u'io.bonefish.test.coalesced',
+                RegisterOptions(coalesce = True))
+            yield self.register(self.fanout, u'io.bonefish.test.fanout',
+                RegisterOptions(invoke = u'roundrobin'))
+        else:
+            yield self.register(self.fanout, u'io.bonefish.test.fanout',
+                RegisterOptions(invoke = u'roundrobin'))
+            yield self.register(self.queued, u'io.bonefish.test.queued',
+                RegisterOptions(concurrency = 1))
+            yield self.register(self.disconnect_later, u'io.bonefish.test.disconnect')
+        print("Registered procedures of the {} callee".format(self.name))
+
+    def onDisconnect(self):
+        print("The {} callee disconnected".format(self.name))
+
+    def sleep(self, seconds):
+        # Returning the deferred lets the invocation be interrupted.
+        return task.deferLater(reactor, seconds, lambda: seconds)
+
+    @inlineCallbacks
+    def coalesced(self):
+        Component.invocations += 1
+        invocations = Component.invocations
+        yield task.deferLater(reactor, 1, lambda: None)
+        returnValue(invocations)
+
+    @inlineCallbacks
+    def fanout(self):
+        if self.name == 'slow':
+            yield task.deferLater(reactor, 2, lambda: None)
+        returnValue(self.name)
+
+    def queued(self):
+        return task.deferLater(reactor, 1, lambda: self.name)
+
+    def disconnect_later(self):
+        reactor.callLater(0, self.disconnect)
+        return self.name
+
+if __name__ == '__main__':
+    # Start logging to console
+    log.startLogging(sys.stdout)
+
+    # Setup the serializers that we can support
+    serializers = []
+    serializers.append(MsgPackSerializer())
+
+    # Start a fast and a slow callee on their own connections
+    for name in ['fast', 'slow']:
+        component_config = types.ComponentConfig(realm = "default", extra = {'name': name})
+        session_factory = wamp.ApplicationSessionFactory(config = component_config)
+        session_factory.session = Component
+
+        transport_factory = websocket.WampWebSocketClientFactory(session_factory,
+            serializers = serializers, debug = False, debug_wamp = True)
+
+        client = clientFromString(reactor, "tcp:127.0.0.1:8001")
+        client.connect(transport_factory)
+
+    # Run the reactor loop
+    reactor.run()
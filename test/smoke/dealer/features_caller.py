@@ -0,0 +1,178 @@
+###############################################################################
+#
+# The MIT License (MIT)
+#
+# Copyright (c) Tavendo GmbH
+# Copyright (c) Topology LP
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+#
+###############################################################################
+
+import sys
+import time
+
+from twisted.python import log
+from twisted.internet import reactor
+from twisted.internet.defer import CancelledError, inlineCallbacks, returnValue
+from twisted.internet.endpoints import clientFromString
+from twisted.python.failure import Failure
+
+from autobahn.twisted import wamp, websocket
+from autobahn.wamp import types
+from autobahn.wamp.exception import ApplicationError
+from autobahn.wamp.serializer import *
+
+class CallOptions(types.CallOptions):
+    """
+    Call options that pass along the dealer specific options
+    that autobahn does not know about.
+    """
+
+    def __init__(self, **options):
+        types.CallOptions.__init__(self)
+        self.options = options
+
+    def message_attr(self):
+        attr = types.CallOptions.message_attr(self)
+        attr.update(self.options)
+        return attr
+
+def error_of(failure):
+    if failure.check(ApplicationError):
+        return failure.value.error
+    if failure.check(CancelledError):
+        return u'wamp.error.canceled'
+    return str(failure.value)
+
+class Component(wamp.ApplicationSession):
+    """
+    Component that joins the router and runs the dealer feature
+    scenarios against the procedures of the feature callees:
+
+          cancel, coalesce, fanout, queue
+
+    See README.md
+    """
+
+    @inlineCallbacks
+    def onJoin(self, details):
+        self.failures = 0
+        yield self.cancel()
+        yield self.coalesce()
+        yield self.fanout()
+        yield self.queue()
+        print("{} scenario(s) failed".format(self.failures))
+        self.leave()
+
+    def onDisconnect(self):
+        reactor.stop()
+
+    def check(self, scenario, condition, message):
+        if not condition:
+            self.failures += 1
+        print("{}: {}: {}".format("PASS" if condition else "FAIL", scenario, message))
+
+    @inlineCallbacks
+    def outcome(self, deferred):
+        try:
+            result = yield deferred
+        except Exception:
+            returnValue((None, error_of(Failure())))
+        returnValue((result, None))
+
+    @inlineCallbacks
+    def cancel(self):
+        # The caller is answered as soon as it cancels and the callee is
+        # interrupted rather than running to completion.
+        call = self.call(u'io.bonefish.test.sleep', 5)
+        reactor.callLater(0.5, call.cancel)
+        started = time.time()
+        result, error = yield self.outcome(call)
+        self.check("cancel", error == u'wamp.error.canceled' and time.time() - started < 2,
+            "error {} after {:.1f}s".format(error, time.time() - started))
+
+    @inlineCallbacks
+    def coalesce(self):
+        # The second call times out before the first one so it joins the
+        # pending invocation and times out on its own. The third call has
+        # no timeout so it cannot join and invokes the callee again.
+        first = self.outcome(self.call(u'io.bonefish.test.coalesced',
+            options = CallOptions(timeout = 3000)))
+        second = self.outcome(self.call(u'io.bonefish.test.coalesced',
+            options = CallOptions(timeout = 500)))
+        third = self.outcome(self.call(u'io.bonefish.test.coalesced'))
+
+        first_result, first_error = yield first
+        second_result, second_error = yield second
+        third_result, third_error = yield third
+        self.check("coalesce", first_error is None and third_error is None and
+            second_error == u'wamp.error.call_timed_out' and third_result == first_result + 1,
+            "results {} {} {}, errors {} {} {}".format(first_result, second_result,
+                third_result, first_error, second_error, third_error))
+
+    @inlineCallbacks
+    def fanout(self):
+        # The slow callee does not answer before the call times out so the
+        # call is answered with the result of the fast callee and a timeout.
+        result, error = yield self.outcome(self.call(u'io.bonefish.test.fanout',
+            options = CallOptions(fanout = u'all', timeout = 1000)))
+        answers = list(result.results) if isinstance(result, types.CallResult) else [result]
+        self.check("fanout", error is None and len(answers) == 2 and
+            {u'error': u'wamp.error.call_timed_out'} in answers,
+            "answers {}, error {}".format(answers, error))
+
+    @inlineCallbacks
+    def queue(self):
+        # Only one call runs at a time and the others wait in the queue. The
+        # callee then disconnects which fails the running call as well as the
+        # queued calls instead of leaving them waiting forever.
+        calls = [self.outcome(self.call(u'io.bonefish.test.queued')) for _ in range(3)]
+        yield self.call(u'io.bonefish.test.disconnect')
+        started = time.time()
+        errors = []
+        for call in calls:
+            result, error = yield call
+            errors.append(error)
+        self.check("queue", all(errors) and time.time() - started < 2,
+            "errors {} after {:.1f}s".format(errors, time.time() - started))
+
+if __name__ == '__main__':
+    # Start logging to console
+    log.startLogging(sys.stdout)
+
+    # Create an application session factory
+    component_config = types.ComponentConfig(realm = "default")
+    session_factory = wamp.ApplicationSessionFactory(config = component_config)
+    session_factory.session = Component
+
+    # Setup the serializers that we can support
+    serializers = []
+    serializers.append(MsgPackSerializer())
+
+    # Create a websocket transport factory
+    transport_factory = websocket.WampWebSocketClientFactory(session_factory,
+        serializers = serializers, debug = False, debug_wamp = True)
+
+    # Start the client and connect
+    client = clientFromString(reactor, "tcp:127.0.0.1:8001")
+    client.connect(transport_factory)
+
+    # Run the reactor loop
+    reactor.run()